@@ -0,0 +1,1282 @@
+// Micro-benchmarks for the traffic management core.
+// Usage: traffic_benchmark [name ...]   (runs every benchmark when no name is given)
+
+#include "../include/TrafficController.h"
+#include "../include/Intersection.h"
+#include "../include/TrafficSensor.h"
+#include "../include/EventLog.h"
+#include "../include/ReplaySource.h"
+#include "../include/LookaheadController.h"
+#include "../include/Scenario.h"
+#include "../include/SignalTimerTable.h"
+#include "../include/RingBarrier.h"
+#include "../include/ShardedSimulation.h"
+#include "../include/PlanScheduler.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <ctime>
+#include <memory>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Silences the per-intersection console chatter while large networks are built
+class QuietScope {
+private:
+    std::ostringstream sink;
+    std::streambuf* saved;
+
+public:
+    QuietScope() : saved(std::cout.rdbuf(sink.rdbuf())) {}
+    ~QuietScope() { std::cout.rdbuf(saved); }
+};
+
+void buildNetwork(TrafficController& controller, int count) {
+    QuietScope quiet;
+    for (int i = 0; i < count; ++i) {
+        controller.addIntersection("I" + std::to_string(i));
+    }
+}
+
+void printRate(const std::string& label, double events, double seconds) {
+    std::cout << "  " << std::left << std::setw(32) << label << std::right
+              << std::fixed << std::setprecision(2) << std::setw(10) << seconds * 1000.0 << " ms  "
+              << std::setprecision(0) << std::setw(14) << events / seconds << " events/sec\n";
+}
+
+void benchDetectionIngestion() {
+    const int intersectionCount = 1000;
+    const size_t eventCount = 2000000;
+    
+    TrafficController controller;
+    buildNetwork(controller, intersectionCount);
+    
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> intersectionDis(0, intersectionCount - 1);
+    std::uniform_int_distribution<> dirDis(0, 3);
+    
+    auto base = Clock::now();
+    std::vector<DetectionEvent> events(eventCount);
+    for (size_t i = 0; i < eventCount; ++i) {
+        events[i].intersection = static_cast<uint32_t>(intersectionDis(gen));
+        events[i].approach = static_cast<Direction>(dirDis(gen));
+        events[i].timestamp = base + std::chrono::microseconds(i * 500);
+    }
+    
+    std::cout << "\n[ingest] " << eventCount << " detector events over " << intersectionCount << " intersections\n";
+    
+    // One event per call, locating intersection and sensor by scanning like the
+    // old entry points. This path is slow, so it only runs over a sample.
+    const size_t sampleCount = eventCount / 20;
+    auto ids = controller.getIntersectionIds();
+    auto start = Clock::now();
+    for (size_t i = 0; i < sampleCount; ++i) {
+        const DetectionEvent& event = events[i];
+        Intersection* intersection = controller.getIntersection(ids[event.intersection]);
+        for (auto& sensor : intersection->getSensors()) {
+            if (sensor.getDirection() == event.approach) {
+                sensor.recordDetection(event.timestamp);
+                break;
+            }
+        }
+    }
+    printRate("per-event (lookup by id)", sampleCount, secondsSince(start));
+    
+    start = Clock::now();
+    size_t applied = controller.ingestDetections(events);
+    printRate("batch ingestDetections", applied, secondsSince(start));
+}
+
+void benchEventLog() {
+    const uint32_t eventsPerThread = 10000000;
+    const char* path = "bench_events.tlog";
+    
+    std::cout << "\n[eventlog] " << eventsPerThread << " appends per producer thread\n";
+    
+    for (int threads : {1, 4}) {
+        EventLog log;
+        if (!log.open(path)) {
+            return;
+        }
+        
+        auto start = Clock::now();
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; ++t) {
+            producers.emplace_back([&log, t, eventsPerThread]() {
+                for (uint32_t i = 0; i < eventsPerThread; ++i) {
+                    log.append(static_cast<EventType>(i & 3), static_cast<uint32_t>(t), static_cast<uint8_t>(i & 3), i);
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        double appendSeconds = secondsSince(start);
+        log.close();
+        double totalSeconds = secondsSince(start);
+        
+        double events = static_cast<double>(eventsPerThread) * threads;
+        printRate(std::to_string(threads) + " thread(s), append only", events, appendSeconds);
+        printRate(std::to_string(threads) + " thread(s), incl. final flush", events, totalSeconds);
+        
+        if (log.getEventsWritten() != static_cast<uint64_t>(events)) {
+            std::cout << "  WARNING: " << log.getEventsWritten() << " events reached the file\n";
+        }
+    }
+    
+    std::remove(path);
+}
+
+void benchReplay() {
+    const int intersectionCount = 50;
+    const size_t recordCount = 2000000;
+    const int64_t traceSeconds = 86400;
+    const char* csvPath = "bench_replay.csv";
+    const char* binaryPath = "bench_replay.trp";
+    const char* const directionNames[] = {"N", "S", "E", "W"};
+    const char* const typeNames[] = {"CAR", "TRUCK", "BUS", "MOTORCYCLE"};
+    
+    // A day-long trace of ordinary traffic, written in both formats
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> intersectionDis(0, intersectionCount - 1);
+    std::uniform_int_distribution<> dirDis(0, 3);
+    std::uniform_int_distribution<> typeDis(0, 3);
+    
+    std::vector<ReplayRecord> records(recordCount);
+    {
+        std::ofstream csv(csvPath);
+        csv << "timestamp_ms,intersection,approach,vehicle_type\n";
+        for (size_t i = 0; i < recordCount; ++i) {
+            ReplayRecord& record = records[i];
+            record.timestampMs = static_cast<int64_t>(i * (traceSeconds * 1000 / recordCount));
+            record.intersection = static_cast<uint32_t>(intersectionDis(gen));
+            record.approach = static_cast<Direction>(dirDis(gen));
+            record.vehicleType = static_cast<VehicleType>(typeDis(gen));
+            csv << record.timestampMs << ',' << record.intersection << ','
+                << directionNames[static_cast<int>(record.approach)] << ','
+                << typeNames[static_cast<int>(record.vehicleType)] << '\n';
+        }
+    }
+    if (!ReplaySource::writeBinary(binaryPath, records)) {
+        return;
+    }
+    records.clear();
+    records.shrink_to_fit();
+    
+    std::cout << "\n[replay] " << recordCount << " records, " << traceSeconds << " s trace, "
+              << intersectionCount << " intersections\n";
+    
+    for (const char* path : {csvPath, binaryPath}) {
+        ReplaySource source;
+        if (!source.open(path)) {
+            continue;
+        }
+        std::string label = source.getFormat() == ReplaySource::Format::CSV ? "csv" : "binary";
+        
+        // Parse only
+        ReplayRecord record;
+        uint64_t checksum = 0;
+        auto start = Clock::now();
+        while (source.next(record)) {
+            checksum += record.intersection;
+        }
+        printRate(label + " parse only", static_cast<double>(source.getRecordsRead()), secondsSince(start));
+        if (checksum == 0) {
+            std::cout << "  WARNING: empty replay\n";
+        }
+        
+        // Full replay through the controller, as fast as possible
+        source.rewind();
+        TrafficController controller;
+        buildNetwork(controller, intersectionCount);
+        ReplayResult result = controller.runReplay(source);
+        printRate(label + " full replay", static_cast<double>(result.arrivals), result.wallSeconds);
+        std::cout << "    " << std::setprecision(0) << result.getSpeedup() << "x real time, "
+                  << result.departures << " departures\n";
+    }
+    
+    std::remove(csvPath);
+    std::remove(binaryPath);
+}
+
+void benchCheckpoint() {
+    const int intersectionCount = 1000;
+    const int vehiclesPerIntersection = 40;
+    const char* path = "bench_state.ckpt";
+    
+    TrafficController controller;
+    buildNetwork(controller, intersectionCount);
+    auto ids = controller.getIntersectionIds();
+    {
+        QuietScope quiet;
+        for (const auto& id : ids) {
+            for (int v = 0; v < vehiclesPerIntersection; ++v) {
+                controller.submitVehicle(id, Vehicle("C" + std::to_string(v), VehicleType::CAR, static_cast<Direction>(v & 3)));
+            }
+        }
+    }
+    
+    std::cout << "\n[checkpoint] " << intersectionCount << " intersections, "
+              << intersectionCount * vehiclesPerIntersection << " queued vehicles\n";
+    
+    // saveCheckpoint returns once the state is captured; the file is written in the background
+    double captureSeconds;
+    double totalSeconds;
+    {
+        QuietScope quiet;
+        auto start = Clock::now();
+        controller.saveCheckpoint(path);
+        captureSeconds = secondsSince(start);
+        controller.waitForCheckpoint();
+        totalSeconds = secondsSince(start);
+    }
+    printRate("capture (blocking part)", intersectionCount, captureSeconds);
+    printRate("capture + background write", intersectionCount, totalSeconds);
+    
+    TrafficController restored;
+    auto start = Clock::now();
+    bool ok;
+    {
+        QuietScope quiet;
+        ok = restored.restoreCheckpoint(path);
+    }
+    printRate("restore", intersectionCount, secondsSince(start));
+    if (!ok || restored.getIntersectionCount() != intersectionCount) {
+        std::cout << "  WARNING: restore failed\n";
+    }
+    
+    std::remove(path);
+}
+
+// Replays a synthetic trace with heavy North/South and light East/West demand
+ReplayResult replayCorridor(ControlStrategy strategy, const char* path, int& queuedAtEnd) {
+    TrafficController controller;
+    buildNetwork(controller, 1);
+    ReplayResult result;
+    {
+        QuietScope quiet;
+        controller.setControlStrategy(strategy);
+        ReplaySource source;
+        if (source.open(path)) {
+            result = controller.runReplay(source);
+        }
+    }
+    queuedAtEnd = controller.getSnapshot().intersections[0].getTotalVehicleCount();
+    return result;
+}
+
+void benchLookahead() {
+    const int queuedVehicles = 400;
+    const int decisionRounds = 2000;
+    const char* path = "bench_lookahead.trp";
+    
+    TrafficController controller;
+    buildNetwork(controller, 1);
+    Intersection* intersection = controller.getIntersection("I0");
+    auto now = Clock::now();
+    {
+        QuietScope quiet;
+        for (int v = 0; v < queuedVehicles; ++v) {
+            Vehicle vehicle("Q" + std::to_string(v), v % 10 == 0 ? VehicleType::BUS : VehicleType::CAR,
+                            static_cast<Direction>(v & 3));
+            vehicle.setArrivalTime(now - std::chrono::seconds(v % 90));
+            intersection->addVehicle(vehicle);
+        }
+    }
+    
+    LookaheadController lookahead;
+    const LookaheadConfig& config = lookahead.getConfig();
+    int candidates = (config.maxGreenSeconds - config.minGreenSeconds) / config.candidateStepSeconds + 1;
+    
+    std::cout << "\n[lookahead] " << queuedVehicles << " queued vehicles, " << candidates
+              << " candidates x " << config.horizonSeconds << " s horizon\n";
+    
+    // What a naive lookahead pays just to give each candidate its own state
+    auto start = Clock::now();
+    size_t sink = 0;
+    for (int round = 0; round < decisionRounds / 10; ++round) {
+        for (int c = 0; c < candidates; ++c) {
+            Intersection copy = *intersection;
+            sink += copy.getTotalVehicleCount();
+        }
+    }
+    double deepCopySeconds = secondsSince(start);
+    printRate("deep copy per candidate", static_cast<double>(decisionRounds / 10) * candidates, deepCopySeconds);
+    
+    IntersectionFork root = intersection->fork(now);
+    start = Clock::now();
+    for (int round = 0; round < decisionRounds; ++round) {
+        for (int c = 0; c < candidates; ++c) {
+            IntersectionFork branch = root;
+            sink += static_cast<size_t>(branch.getPhaseLength());
+        }
+    }
+    printRate("fork per candidate", static_cast<double>(decisionRounds) * candidates, secondsSince(start));
+    
+    start = Clock::now();
+    for (int round = 0; round < decisionRounds; ++round) {
+        sink += static_cast<size_t>(lookahead.decide(intersection->fork(now)).extraGreenSeconds);
+    }
+    double decideSeconds = secondsSince(start);
+    printRate("full decision (fork + simulate)", decisionRounds, decideSeconds);
+    std::cout << "    " << std::setprecision(1) << decideSeconds * 1e6 / decisionRounds << " us per decision\n";
+    if (sink == 0) {
+        std::cout << "  WARNING: nothing evaluated\n";
+    }
+    
+    // Control quality on a two-hour trace that is near saturation under fixed time
+    const int traceSeconds = 7200;
+    std::vector<ReplayRecord> records;
+    std::mt19937 gen(7);
+    std::bernoulli_distribution heavy(0.36);
+    std::bernoulli_distribution light(0.10);
+    for (int s = 0; s < traceSeconds; ++s) {
+        for (int a = 0; a < 4; ++a) {
+            bool arrives = a < 2 ? heavy(gen) : light(gen);
+            if (arrives) {
+                records.push_back({static_cast<int64_t>(s) * 1000 + a * 100, 0,
+                                   static_cast<Direction>(a), VehicleType::CAR});
+            }
+        }
+    }
+    if (!ReplaySource::writeBinary(path, records)) {
+        return;
+    }
+    
+    for (ControlStrategy strategy : {ControlStrategy::FIXED_TIME, ControlStrategy::LOOKAHEAD}) {
+        int queuedAtEnd = 0;
+        ReplayResult result = replayCorridor(strategy, path, queuedAtEnd);
+        std::cout << "  " << std::left << std::setw(32)
+                  << (strategy == ControlStrategy::LOOKAHEAD ? "lookahead control" : "fixed-time control")
+                  << std::right << result.departures << " departed, " << queuedAtEnd << " still queued\n";
+    }
+    
+    std::remove(path);
+}
+
+void benchScenario() {
+    const int gridSize = 224;                 // 50,176 intersections
+    const int perCallCount = 5000;
+    const char* path = "bench_city.tscn";
+    
+    // Synthetic grid city: 4-neighbour two-way links, a few plans and daily demand profiles
+    ScenarioBuilder builder;
+    uint32_t plans[3] = {
+        builder.addPlan({{30, 30, 25, 25}, {5, 5, 5, 5}}),
+        builder.addPlan({{40, 40, 20, 20}, {4, 4, 4, 4}}),
+        builder.addPlan({{25, 25, 35, 35}, {5, 5, 5, 5}}),
+    };
+    uint32_t profiles[3];
+    for (int p = 0; p < 3; ++p) {
+        std::vector<float> rates;
+        for (int slot = 0; slot < 96; ++slot) {
+            float peak = (slot >= 28 && slot < 38) || (slot >= 68 && slot < 76) ? 3.0f : 1.0f;
+            for (int a = 0; a < 4; ++a) {
+                rates.push_back(peak * (200.0f + 50.0f * p + 20.0f * a));
+            }
+        }
+        profiles[p] = builder.addDemandProfile(900, rates);
+    }
+    for (int r = 0; r < gridSize; ++r) {
+        for (int c = 0; c < gridSize; ++c) {
+            int k = r * gridSize + c;
+            builder.addNode("G" + std::to_string(r) + "_" + std::to_string(c), c * 150.0f, r * 150.0f, 0xF,
+                            plans[k % 3], profiles[k % 3]);
+        }
+    }
+    for (int r = 0; r < gridSize; ++r) {
+        for (int c = 0; c < gridSize; ++c) {
+            uint32_t k = static_cast<uint32_t>(r * gridSize + c);
+            if (c + 1 < gridSize) {
+                builder.addLink(k, k + 1, Direction::EAST, 150.0f);
+                builder.addLink(k + 1, k, Direction::WEST, 150.0f);
+            }
+            if (r + 1 < gridSize) {
+                builder.addLink(k, k + gridSize, Direction::SOUTH, 150.0f);
+                builder.addLink(k + gridSize, k, Direction::NORTH, 150.0f);
+            }
+        }
+    }
+    if (!builder.write(path)) {
+        return;
+    }
+    
+    std::cout << "\n[scenario] " << builder.getNodeCount() << " intersection grid city (warm page cache)\n";
+    
+    // The old way: one addIntersection plus four configureIntersection calls per node.
+    // Configuration looks intersections up by id, so this only runs on a smaller city.
+    {
+        TrafficController controller;
+        double seconds;
+        {
+            QuietScope quiet;
+            auto start = Clock::now();
+            for (int i = 0; i < perCallCount; ++i) {
+                std::string id = "G" + std::to_string(i);
+                controller.addIntersection(id);
+                for (int d = 0; d < 4; ++d) {
+                    controller.configureIntersection(id, static_cast<Direction>(d), 30, 5);
+                }
+            }
+            seconds = secondsSince(start);
+        }
+        printRate("per-call build (5k nodes)", perCallCount, seconds);
+    }
+    
+    ScenarioFile file;
+    auto start = Clock::now();
+    bool opened = file.open(path);
+    printRate("map + validate", builder.getNodeCount(), secondsSince(start));
+    
+    TrafficController controller;
+    start = Clock::now();
+    bool loaded;
+    {
+        QuietScope quiet;
+        loaded = controller.loadScenario(path);
+    }
+    double loadSeconds = secondsSince(start);
+    printRate("loadScenario (cold start)", builder.getNodeCount(), loadSeconds);
+    if (!opened || !loaded || controller.getIntersectionCount() != static_cast<int>(builder.getNodeCount())) {
+        std::cout << "  WARNING: scenario failed to load\n";
+    }
+    
+    std::remove(path);
+}
+
+void benchSignals() {
+    const int intersectionCount = 100000;
+    const int seconds = 200;
+    
+    std::cout << "\n[signals] " << intersectionCount << " intersections, " << seconds << " s of signal time\n";
+    
+    // Baseline: every intersection counts down its own timers
+    std::vector<std::unique_ptr<Intersection>> standalone;
+    for (int i = 0; i < intersectionCount; ++i) {
+        standalone.push_back(std::make_unique<Intersection>("I" + std::to_string(i)));
+        for (int d = 0; d < 4; ++d) {
+            standalone.back()->addTrafficLight(static_cast<Direction>(d));
+            standalone.back()->addTrafficSensor(static_cast<Direction>(d));
+        }
+    }
+    auto now = Clock::now();
+    auto start = Clock::now();
+    for (int second = 0; second < seconds; ++second) {
+        now += std::chrono::seconds(1);
+        for (auto& intersection : standalone) {
+            intersection->stepSecond(now);
+        }
+    }
+    double perObjectSeconds = secondsSince(start);
+    printRate("per-object stepSecond", static_cast<double>(intersectionCount) * seconds, perObjectSeconds);
+    
+    // The controller's batched path, once per kernel
+    TrafficController controller;
+    buildNetwork(controller, intersectionCount);
+    for (auto kernel : {SignalTimerTable::Kernel::SCALAR, SignalTimerTable::Kernel::AVX2}) {
+        if (!controller.setSignalKernel(kernel)) {
+            std::cout << "  " << SignalTimerTable::getKernelName(kernel) << " not supported on this CPU\n";
+            continue;
+        }
+        start = Clock::now();
+        for (int second = 0; second < seconds; ++second) {
+            now += std::chrono::seconds(1);
+            controller.advanceSignals(now);
+        }
+        double batchSeconds = secondsSince(start);
+        printRate(std::string("batched, ") + SignalTimerTable::getKernelName(kernel) + " kernel",
+                  static_cast<double>(intersectionCount) * seconds, batchSeconds);
+        std::cout << "    " << std::setprecision(2) << perObjectSeconds / batchSeconds << "x per-object\n";
+    }
+    
+    // The countdown kernels on their own; due slots restart as a phase change would
+    for (auto kernel : {SignalTimerTable::Kernel::SCALAR, SignalTimerTable::Kernel::AVX2}) {
+        SignalTimerTable table;
+        if (!table.setKernel(kernel)) {
+            continue;
+        }
+        table.resize(intersectionCount);
+        for (int slot = 0; slot < intersectionCount; ++slot) {
+            table.nextEvent(static_cast<uint32_t>(slot)) = 35 + slot % 30;
+        }
+        size_t due = 0;
+        start = Clock::now();
+        for (int second = 0; second < seconds; ++second) {
+            now += std::chrono::seconds(1);
+            for (uint32_t slot : table.advance(now)) {
+                table.phaseTimer(slot) = 0;
+                due++;
+            }
+        }
+        printRate(std::string("kernel only, ") + SignalTimerTable::getKernelName(kernel),
+                  static_cast<double>(intersectionCount) * seconds, secondsSince(start));
+        std::cout << "    " << due << " due slots reported\n";
+    }
+}
+
+// One hour of a standalone intersection with heavy left-turn demand on the N-S street
+void benchNema() {
+    const int seconds = 3600;
+    
+    std::cout << "\n[nema] " << seconds << " s, heavy N-S lefts, per-movement queues\n";
+    
+    // Per-second arrival probabilities by approach and turn (left, through, right)
+    const double demand[4][3] = {
+        {0.10, 0.22, 0.05},   // North
+        {0.10, 0.22, 0.05},   // South
+        {0.04, 0.12, 0.04},   // East
+        {0.04, 0.12, 0.04},   // West
+    };
+    
+    struct Variant {
+        const char* label;
+        bool usePlan;
+        RingBarrierPlan plan;
+    };
+    const Variant variants[] = {
+        {"two-phase cycle", false, RingBarrierPlan()},
+        {"ring-barrier, permitted lefts", true, RingBarrierPlan::twoPhasePermitted()},
+        {"ring-barrier, protected lefts", true, RingBarrierPlan::standardEightPhase()},
+    };
+    
+    for (const Variant& variant : variants) {
+        Intersection intersection("NEMA");
+        {
+            QuietScope quiet;
+            for (int d = 0; d < 4; ++d) {
+                intersection.addTrafficLight(static_cast<Direction>(d));
+                intersection.addTrafficSensor(static_cast<Direction>(d));
+            }
+        }
+        std::string error;
+        if (variant.usePlan && !intersection.setRingBarrierPlan(variant.plan, error)) {
+            std::cout << "  " << variant.label << ": " << error << "\n";
+            continue;
+        }
+        
+        std::mt19937 gen(11);
+        std::uniform_real_distribution<double> roll(0.0, 1.0);
+        auto now = Clock::now();
+        size_t departures = 0;
+        size_t queuedSeconds = 0;
+        int nextId = 0;
+        auto start = Clock::now();
+        {
+            QuietScope quiet;
+            for (int second = 0; second < seconds; ++second) {
+                now += std::chrono::seconds(1);
+                for (int d = 0; d < 4; ++d) {
+                    for (int t = 0; t < 3; ++t) {
+                        if (roll(gen) < demand[d][t]) {
+                            Vehicle vehicle("V" + std::to_string(nextId++), VehicleType::CAR,
+                                            static_cast<Direction>(d), static_cast<Turn>(t));
+                            vehicle.setArrivalTime(now);
+                            intersection.addVehicle(vehicle);
+                        }
+                    }
+                }
+                intersection.stepSecond(now);
+                departures += intersection.processVehicleQueues();
+                queuedSeconds += intersection.getTotalVehicleCount();
+            }
+        }
+        double elapsed = secondsSince(start);
+        std::cout << "  " << std::left << std::setw(32) << variant.label << std::right
+                  << departures << " departed, " << intersection.getTotalVehicleCount() << " still queued, "
+                  << std::fixed << std::setprecision(1) << (departures ? static_cast<double>(queuedSeconds) / departures : 0.0)
+                  << " s avg delay, " << std::setprecision(2) << elapsed * 1000.0 << " ms\n";
+    }
+    
+    // Conflict checks against the precomputed matrix
+    const ConflictMatrix& matrix = ConflictMatrix::instance();
+    const int lookups = 20000000;
+    size_t compatibleCount = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < lookups; ++i) {
+        MovementMask set = static_cast<MovementMask>((i * 2654435761u) >> 20) & ALL_MOVEMENTS;
+        compatibleCount += (matrix.conflictsOfSet(set) & static_cast<MovementMask>(1u << (i % MOVEMENT_COUNT))) == 0;
+    }
+    printRate("movement-set conflict checks", lookups, secondsSince(start));
+    std::cout << "    " << compatibleCount << " compatible\n";
+}
+
+// A large network where only a few intersections see traffic at any moment
+void benchActiveSet() {
+    const int intersectionCount = 50000;
+    const int64_t traceSeconds = 600;
+    const char* path = "bench_activeset.trp";
+    
+    std::cout << "\n[activeset] " << intersectionCount << " intersections, " << traceSeconds << " s trace\n";
+    
+    for (int arrivalsPerSecond : {5, 500}) {
+        std::vector<ReplayRecord> records;
+        std::mt19937 gen(5);
+        std::uniform_int_distribution<> intersectionDis(0, intersectionCount - 1);
+        std::uniform_int_distribution<> dirDis(0, 3);
+        for (int64_t s = 0; s < traceSeconds; ++s) {
+            for (int i = 0; i < arrivalsPerSecond; ++i) {
+                records.push_back({s * 1000 + i * 1000 / arrivalsPerSecond, static_cast<uint32_t>(intersectionDis(gen)),
+                                   static_cast<Direction>(dirDis(gen)), VehicleType::CAR});
+            }
+        }
+        if (!ReplaySource::writeBinary(path, records)) {
+            return;
+        }
+        
+        std::cout << "  " << arrivalsPerSecond << " arrivals/s\n";
+        double fullScanSeconds = 0.0;
+        for (bool skipIdle : {false, true}) {
+            ReplaySource source;
+            if (!source.open(path)) {
+                break;
+            }
+            TrafficController controller;
+            buildNetwork(controller, intersectionCount);
+            controller.setIdleSkipping(skipIdle);
+            ReplayResult result = controller.runReplay(source);
+            
+            // Per simulated second: the signal pass plus every visited intersection
+            printRate(skipIdle ? "  active set" : "  every intersection", static_cast<double>(result.simulatedSeconds),
+                      result.wallSeconds);
+            std::cout << "      " << result.departures << " departures";
+            if (skipIdle) {
+                std::cout << ", " << controller.getActiveIntersectionCount() << " active at the end, "
+                          << std::setprecision(1) << fullScanSeconds / result.wallSeconds << "x";
+            } else {
+                fullScanSeconds = result.wallSeconds;
+            }
+            std::cout << "\n";
+        }
+    }
+    
+    std::remove(path);
+}
+
+// A square grid city, two-way 150 m links between neighbours
+bool writeGridScenario(const char* path, int gridSize, float perHour, const std::vector<ScenarioTrip>& trips = {}) {
+    ScenarioBuilder builder;
+    uint32_t plan = builder.addPlan({{30, 30, 25, 25}, {5, 5, 5, 5}});
+    uint32_t profile = builder.addDemandProfile(3600, {perHour, perHour, perHour, perHour});
+    for (int r = 0; r < gridSize; ++r) {
+        for (int c = 0; c < gridSize; ++c) {
+            builder.addNode("G" + std::to_string(r) + "_" + std::to_string(c), c * 150.0f, r * 150.0f, 0xF, plan, profile);
+        }
+    }
+    for (int r = 0; r < gridSize; ++r) {
+        for (int c = 0; c < gridSize; ++c) {
+            uint32_t k = static_cast<uint32_t>(r * gridSize + c);
+            if (c + 1 < gridSize) {
+                builder.addLink(k, k + 1, Direction::EAST, 150.0f);
+                builder.addLink(k + 1, k, Direction::WEST, 150.0f);
+            }
+            if (r + 1 < gridSize) {
+                builder.addLink(k, k + gridSize, Direction::SOUTH, 150.0f);
+                builder.addLink(k + gridSize, k, Direction::NORTH, 150.0f);
+            }
+        }
+    }
+    for (const ScenarioTrip& trip : trips) {
+        builder.addTrip(trip.origin, trip.destination, trip.tripsPerHour);
+    }
+    return builder.write(path);
+}
+
+// A grid city with vehicles moving between intersections, on 1..N worker threads
+void benchSharded() {
+    const int gridSize = 96;                  // 9,216 intersections
+    const int64_t seconds = 600;
+    const char* path = "bench_sharded.tscn";
+    
+    if (!writeGridScenario(path, gridSize, 12.0f)) {
+        return;
+    }
+    
+    unsigned cpus = std::max(1u, std::thread::hardware_concurrency());
+    std::cout << "\n[sharded] " << gridSize * gridSize << " intersection grid, " << seconds
+              << " s simulated, " << cpus << " hardware threads\n";
+    
+    std::vector<int> workerCounts = {1, 2, 4};
+    for (int workers = 8; workers <= static_cast<int>(cpus); workers *= 2) {
+        workerCounts.push_back(workers);
+    }
+    double oneWorkerSeconds = 0.0;
+    for (int workers : workerCounts) {
+        TrafficController controller;
+        {
+            QuietScope quiet;
+            if (!controller.loadScenario(path)) {
+                break;
+            }
+        }
+        NetworkRunConfig config;
+        config.workers = workers;
+        config.seconds = seconds;
+        NetworkRunResult result = controller.runShardedSimulation(config);
+        if (workers == 1) {
+            oneWorkerSeconds = result.wallSeconds;
+        }
+        printRate(std::to_string(result.workers) + " worker(s), " + std::to_string(result.cutLinks) + " cut links",
+                  static_cast<double>(result.departures), result.wallSeconds);
+        std::cout << "    " << result.vehiclesEntered << " entered, " << result.vehiclesExited << " exited, "
+                  << result.linkTransfers << " link moves (" << result.boundaryTransfers << " across shards), "
+                  << std::setprecision(1) << result.getAverageTimeInNetwork() << " s avg in network, "
+                  << std::setprecision(2) << oneWorkerSeconds / result.wallSeconds << "x one worker\n";
+    }
+    
+    std::remove(path);
+}
+
+// OD trips over a grid city: building the route table on load, then a run
+// where every vehicle follows a cached route
+void benchRouting() {
+    const int gridSize = 96;                  // 9,216 intersections
+    const int pairCount = 20000;
+    const float tripsPerHour = 300000.0f;
+    const int64_t seconds = 600;
+    const char* path = "bench_routing.tscn";
+    
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<uint32_t> node(0, gridSize * gridSize - 1);
+    std::vector<ScenarioTrip> trips(pairCount);
+    for (auto& trip : trips) {
+        trip = {node(rng), node(rng), tripsPerHour / pairCount, 0};
+    }
+    if (!writeGridScenario(path, gridSize, 0.0f, trips)) {
+        return;
+    }
+    
+    std::cout << "\n[routing] " << gridSize * gridSize << " intersection grid, " << pairCount << " OD pairs, "
+              << tripsPerHour << " trips/h, " << seconds << " s simulated\n";
+    TrafficController controller;
+    {
+        QuietScope quiet;
+        if (!controller.loadScenario(path)) {
+            std::remove(path);
+            return;
+        }
+    }
+    const RouteTable& routes = controller.getRoutes();
+    printRate("route table build", static_cast<double>(routes.getRouteCount()), routes.getBuildMilliseconds() / 1000.0);
+    std::cout << "    " << routes.getRouteCount() << " routes, " << routes.getUnroutableCount() << " unroutable, "
+              << std::setprecision(1) << static_cast<double>(routes.getStoredLinkCount()) / std::max(1u, routes.getRouteCount())
+              << " links per route, " << routes.getStoredLinkCount() * sizeof(uint32_t) / 1024 << " KiB\n";
+    
+    NetworkRunConfig config;
+    config.workers = 1;
+    config.seconds = seconds;
+    NetworkRunResult result = controller.runShardedSimulation(config);
+    printRate("routed network run", static_cast<double>(result.departures), result.wallSeconds);
+    std::cout << "    " << result.tripsStarted << " trips started, " << result.tripsCompleted << " reached their destination, "
+              << result.vehiclesInNetwork << " still in network, " << std::setprecision(0)
+              << result.tripsStarted / result.wallSeconds << " trips started per wall-clock second\n";
+    
+    std::remove(path);
+}
+
+// Iterative assignment of OD trips on a mid-size grid city: time per
+// iteration and how the relative gap falls
+void benchAssignment() {
+    const int gridSize = 48;                  // 2,304 intersections
+    const int pairCount = 3000;
+    const float tripsPerHour = 60000.0f;
+    const char* path = "bench_assignment.tscn";
+    
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<uint32_t> node(0, gridSize * gridSize - 1);
+    std::vector<ScenarioTrip> trips(pairCount);
+    for (auto& trip : trips) {
+        trip = {node(rng), node(rng), tripsPerHour / pairCount, 0};
+    }
+    if (!writeGridScenario(path, gridSize, 0.0f, trips)) {
+        return;
+    }
+    
+    TrafficController controller;
+    {
+        QuietScope quiet;
+        if (!controller.loadScenario(path)) {
+            std::remove(path);
+            return;
+        }
+    }
+    AssignmentConfig config;
+    config.iterations = 20;
+    config.gapTarget = 0.0;
+    config.run.seconds = 900;
+    
+    std::cout << std::fixed << "\n[assignment] " << gridSize * gridSize << " intersection grid, " << pairCount << " OD pairs, "
+              << static_cast<int>(tripsPerHour) << " trips/h, " << config.run.seconds << " s per iteration\n";
+    AssignmentResult result = controller.runAssignment(config);
+    for (const auto& iteration : result.iterations) {
+        if (iteration.iteration == 1 || iteration.iteration % 5 == 0) {
+            std::cout << "  iteration " << std::setw(2) << iteration.iteration << ": gap " << std::setprecision(4)
+                      << iteration.relativeGap << ", " << iteration.reroutedPairs << " pairs rerouted, "
+                      << std::setprecision(1) << iteration.averageTimeInNetwork << " s avg in network, simulate "
+                      << std::setprecision(0) << iteration.simulateSeconds * 1000.0 << " ms, reroute "
+                      << iteration.rerouteSeconds * 1000.0 << " ms\n";
+        }
+    }
+    std::cout << "  " << result.iterations.size() << " iterations in " << std::setprecision(1) << result.wallSeconds
+              << " s\n";
+    
+    std::remove(path);
+}
+
+// The sharded run with regions in worker processes instead of threads:
+// the cost of exchanging boundary vehicles through a coordinator
+void benchPartitioned() {
+    const int gridSize = 64;                  // 4,096 intersections
+    const int64_t seconds = 600;
+    const char* path = "bench_partitioned.tscn";
+    
+    if (!writeGridScenario(path, gridSize, 12.0f)) {
+        return;
+    }
+    
+    std::cout << "\n[partitioned] " << gridSize * gridSize << " intersection grid, " << seconds << " s simulated\n";
+    for (int workers : {2, 4}) {
+        NetworkRunResult byMode[2];
+        for (int mode = 0; mode < 2; ++mode) {
+            TrafficController controller;
+            {
+                QuietScope quiet;
+                if (!controller.loadScenario(path)) {
+                    std::remove(path);
+                    return;
+                }
+            }
+            NetworkRunConfig config;
+            config.workers = workers;
+            config.seconds = seconds;
+            byMode[mode] = mode == 0 ? controller.runShardedSimulation(config) : controller.runPartitionedSimulation(config);
+            printRate(std::to_string(workers) + (mode == 0 ? " threads" : " processes"),
+                      static_cast<double>(byMode[mode].departures), byMode[mode].wallSeconds);
+        }
+        
+        bool same = byMode[0].vehiclesEntered == byMode[1].vehiclesEntered &&
+                    byMode[0].vehiclesExited == byMode[1].vehiclesExited &&
+                    byMode[0].departures == byMode[1].departures &&
+                    byMode[0].heldDischarges == byMode[1].heldDischarges &&
+                    byMode[0].vehiclesInNetwork == byMode[1].vehiclesInNetwork;
+        std::cout << "    " << byMode[1].boundaryTransfers << " vehicles across " << byMode[1].cutLinks
+                  << " cut links, " << byMode[1].departures << " departures, "
+                  << (same ? "same counts as threads" : "COUNTS DIFFER FROM THREADS") << "\n";
+    }
+    
+    std::remove(path);
+}
+
+// An overloaded grid city with and without bounded link storage: how far the
+// queues grow, and that spillback gives the same counts however it is run
+void benchSpillback() {
+    const int gridSize = 32;                  // 1,024 intersections
+    const int64_t seconds = 1800;
+    const float perHour = 400.0f;             // Per approach; more than a cycle serves
+    const char* path = "bench_spillback.tscn";
+    
+    if (!writeGridScenario(path, gridSize, perHour)) {
+        return;
+    }
+    
+    std::cout << std::fixed << "\n[spillback] " << gridSize * gridSize << " intersection grid, "
+              << static_cast<int>(perHour) << " vehicles/h per approach, " << seconds << " s simulated\n";
+    const struct {
+        const char* label;
+        bool spillback;
+        int workers;
+        bool processes;
+    } runs[] = {
+        {"unbounded, 1 thread", false, 1, false},
+        {"spillback, 1 thread", true, 1, false},
+        {"spillback, 4 threads", true, 4, false},
+        {"spillback, 4 processes", true, 4, true},
+    };
+    NetworkRunResult reference;
+    for (const auto& run : runs) {
+        TrafficController controller;
+        {
+            QuietScope quiet;
+            if (!controller.loadScenario(path)) {
+                std::remove(path);
+                return;
+            }
+        }
+        NetworkRunConfig config;
+        config.workers = run.workers;
+        config.seconds = seconds;
+        config.spillback = run.spillback;
+        NetworkRunResult result = run.processes ? controller.runPartitionedSimulation(config)
+                                                : controller.runShardedSimulation(config);
+        printRate(run.label, static_cast<double>(result.departures), result.wallSeconds);
+        std::cout << "    " << result.vehiclesInNetwork << " in network at the end, " << result.fullLinks
+                  << " full links, " << result.entriesRefused << " entries refused, " << result.heldDischarges
+                  << " discharges held";
+        if (run.spillback && run.workers == 1) {
+            reference = result;
+        } else if (run.spillback) {
+            bool same = result.vehiclesEntered == reference.vehiclesEntered &&
+                        result.departures == reference.departures &&
+                        result.heldDischarges == reference.heldDischarges &&
+                        result.vehiclesInNetwork == reference.vehiclesInNetwork;
+            std::cout << ", " << (same ? "same counts as 1 thread" : "COUNTS DIFFER FROM 1 THREAD");
+        }
+        std::cout << "\n";
+    }
+    
+    std::remove(path);
+}
+
+// Car-following on lanes at 10 Hz: vehicle updates per wall-clock second
+// with tens of thousands of vehicles on one core
+void benchIdm() {
+    const int intersectionCount = 100;
+    
+    TrafficController controller;
+    {
+        QuietScope quiet;
+        for (int i = 0; i < intersectionCount; ++i) {
+            controller.addIntersection("I" + std::to_string(i));
+        }
+    }
+    LaneRunConfig config;
+    config.seconds = 600;
+    config.lanesPerApproach = 3;
+    config.approachMeters = 1000.0f;
+    config.demandPerLaneHour = 700.0f;
+    
+    std::cout << std::fixed << "\n[idm] " << intersectionCount << " intersections, " << config.lanesPerApproach
+              << " lanes of " << static_cast<int>(config.approachMeters) << " m per approach, "
+              << config.stepsPerSecond << " Hz, " << config.seconds << " s simulated\n";
+    LaneRunResult result = controller.runLaneSimulation(config);
+    printRate("vehicle updates", static_cast<double>(result.vehicleUpdates), result.wallSeconds);
+    std::cout << "    " << result.lanes << " lanes, peak " << result.peakVehicles << " vehicles, "
+              << std::setprecision(1) << result.getRealTimeFactor() << "x real time, "
+              << result.getAverageTravelTime() << " s avg travel, " << std::setprecision(2)
+              << result.getStopsPerVehicle() << " stops per vehicle\n";
+}
+
+// Green-wave offsets for a long arterial whose signals start out uncoordinated:
+// search time, bandwidths, and stops and travel time before and after
+void benchGreenWave() {
+    const int intersectionCount = 200;
+    
+    TrafficController controller;
+    std::mt19937 rng(47);
+    {
+        QuietScope quiet;
+        for (int i = 0; i < intersectionCount; ++i) {
+            std::string id = "I" + std::to_string(i);
+            controller.addIntersection(id);
+            Intersection* intersection = controller.getIntersection(id);
+            int crossGreen = 15 + static_cast<int>(rng() % 16);
+            int arterialGreen = 25 + static_cast<int>(rng() % 21);
+            intersection->configureTiming(Direction::NORTH, crossGreen, 4);
+            intersection->configureTiming(Direction::SOUTH, crossGreen, 4);
+            intersection->configureTiming(Direction::EAST, arterialGreen, 4);
+            intersection->configureTiming(Direction::WEST, arterialGreen, 4);
+            intersection->setCyclePosition(static_cast<int>(rng() % 120));
+        }
+    }
+    CorridorConfig config;
+    config.evaluation.seconds = 7200;   // Long enough to drive the whole corridor
+    config.evaluation.demandPerLaneHour = 500.0f;
+    
+    std::cout << std::fixed << "\n[greenwave] " << intersectionCount << " signals, "
+              << static_cast<int>(config.spacingMeters) << " m apart, " << std::setprecision(1) << config.speed << " m/s progression\n";
+    CorridorResult result = controller.coordinateCorridor(config);
+    std::cout << "    search: " << std::setprecision(1) << result.optimizeMilliseconds << " ms, cycle "
+              << result.cycleSeconds << " s, bandwidth " << result.outboundBandwidth << " s outbound, "
+              << result.inboundBandwidth << " s inbound\n";
+    const char* names[2] = {"outbound", "inbound"};
+    for (int d = 0; d < 2; ++d) {
+        std::cout << "    " << names[d] << ": " << std::setprecision(2) << result.before.stopsPerVehicle[d]
+                  << " -> " << result.after.stopsPerVehicle[d] << " stops per vehicle, " << std::setprecision(0)
+                  << result.before.travelSeconds[d] << " -> " << result.after.travelSeconds[d] << " s travel ("
+                  << result.after.vehicles[d] << " vehicles)\n";
+    }
+}
+
+// Time-of-day plans: the old per-step rush-hour re-timing of every
+// intersection against a week of scheduled plan changes, and how quickly
+// offset plans are reached without cutting phases short
+void benchPlanSchedule() {
+    const int intersectionCount = 10000;
+    const int legacySteps = 200;
+    
+    auto rushHours = std::make_shared<const PlanSchedule>(PlanSchedule::rushHours(TimingPlan()));
+    std::vector<std::unique_ptr<Intersection>> intersections;
+    for (int i = 0; i < intersectionCount; ++i) {
+        intersections.push_back(std::make_unique<Intersection>("I" + std::to_string(i)));
+        for (int d = 0; d < 4; ++d) {
+            intersections.back()->addTrafficLight(static_cast<Direction>(d));
+        }
+        intersections.back()->setPlanSchedule(rushHours);
+    }
+    
+    std::cout << "\n[planschedule] " << intersectionCount << " intersections, rush hours 07-10 and 17-20\n";
+    
+    // What adaptiveSignalTiming did every 3 s of a rush hour
+    auto start = Clock::now();
+    for (int step = 0; step < legacySteps; ++step) {
+        std::time_t now = std::time(nullptr);
+        volatile int hour = std::localtime(&now)->tm_hour;
+        (void)hour;
+        for (auto& intersection : intersections) {
+            intersection->configureTiming(Direction::NORTH, 40, 5);
+            intersection->configureTiming(Direction::SOUTH, 40, 5);
+        }
+    }
+    printRate("per-step re-timing (steps)", legacySteps, secondsSince(start));
+    
+    // A week, one advance per second
+    const int64_t weekSeconds = PlanSchedule::WEEK_SECONDS;
+    PlanScheduler scheduler;
+    auto steadyOrigin = Clock::now();
+    auto wallOrigin = std::chrono::system_clock::now();
+    scheduler.rebuild(intersections, steadyOrigin);
+    start = Clock::now();
+    for (int64_t second = 0; second < weekSeconds; ++second) {
+        scheduler.advance(intersections, steadyOrigin + std::chrono::seconds(second),
+                          wallOrigin + std::chrono::seconds(second));
+    }
+    printRate("scheduled week (seconds)", static_cast<double>(weekSeconds), secondsSince(start));
+    std::cout << "    " << scheduler.getStats().planChanges << " plan changes, " << scheduler.getStats().clockReads
+              << " local time reads\n";
+    
+    // Offset plans from 07:00, signals running: every intersection its own offset
+    const int coordinatedCount = 200;
+    std::time_t today = std::time(nullptr);
+    std::tm local = *std::localtime(&today);
+    local.tm_hour = 6;
+    local.tm_min = 50;
+    local.tm_sec = 0;
+    auto morning = std::chrono::system_clock::from_time_t(std::mktime(&local));
+    intersections.resize(coordinatedCount);
+    for (int i = 0; i < coordinatedCount; ++i) {
+        PlanSchedule schedule;
+        TimingPlan free;
+        TimingPlan coordinated;
+        coordinated.greenSeconds = {36, 36, 24, 24};
+        coordinated.offset = (i * 17) % 70;
+        uint16_t first = schedule.addPlan(free);
+        uint16_t second = schedule.addPlan(coordinated);
+        std::string error;
+        schedule.addPeriod({0x7F, 0, first}, error);
+        schedule.addPeriod({0x7F, 7 * 60, second}, error);
+        schedule.compile();
+        intersections[i]->setPlanSchedule(std::make_shared<const PlanSchedule>(schedule));
+        intersections[i]->setCyclePosition(i * 7);
+    }
+    PlanScheduler seeker;
+    seeker.rebuild(intersections, steadyOrigin);
+    int aligned = 0;
+    int64_t alignedBy = -1;
+    for (int64_t second = 0; second < 3600; ++second) {
+        auto now = steadyOrigin + std::chrono::seconds(second);
+        for (auto& intersection : intersections) {
+            intersection->stepSecond(now);
+        }
+        seeker.advance(intersections, now, morning + std::chrono::seconds(second));
+        if (alignedBy < 0 && seeker.getStats().offsetsReached == static_cast<uint64_t>(coordinatedCount)) {
+            alignedBy = second - 600;
+        }
+    }
+    int32_t secondOfDay = PlanScheduler::weekSecond(morning + std::chrono::seconds(3599)) % (24 * 3600);
+    for (int i = 0; i < coordinatedCount; ++i) {
+        int cycle = intersections[i]->getCycleLength();
+        int target = (((secondOfDay - (i * 17) % 70) % cycle) + cycle) % cycle;
+        aligned += intersections[i]->getCyclePosition() == target ? 1 : 0;
+    }
+    std::cout << "    offsets: " << aligned << "/" << coordinatedCount << " aligned, last one "
+              << alignedBy << " s after 07:00 in " << seeker.getStats().seekSteps << " phase adjustments\n";
+}
+
+// Optimization's view of a loaded network: the old rescan of every queue
+// against the aggregates the intersections keep up to date
+void benchAggregates() {
+    const int intersectionCount = 10000;
+    const int vehicleCount = 80000;
+    const int rounds = 50;
+    
+    TrafficController controller;
+    buildNetwork(controller, intersectionCount);
+    std::vector<Intersection*> intersections;
+    for (int i = 0; i < intersectionCount; ++i) {
+        intersections.push_back(controller.getIntersection("I" + std::to_string(i)));
+    }
+    std::mt19937 gen(49);
+    for (int v = 0; v < vehicleCount; ++v) {
+        // Skewed, so some intersections are well over the mean
+        int index = static_cast<int>(std::min(gen() % intersectionCount, gen() % intersectionCount));
+        intersections[index]->addVehicle(Vehicle("C" + std::to_string(v), VehicleType::CAR, static_cast<Direction>(gen() & 3)));
+    }
+    
+    std::cout << "\n[aggregates] " << intersectionCount << " intersections, " << vehicleCount << " queued vehicles\n";
+    
+    // What optimizeTrafficFlow and balanceIntersectionLoad read before
+    size_t rescanDecisions = 0;
+    auto start = Clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (Intersection* intersection : intersections) {
+            int longest = 0;
+            for (int d = 0; d < 4; ++d) {
+                longest = std::max(longest, intersection->getQueueLength(static_cast<Direction>(d)));
+            }
+            rescanDecisions += longest > 5 ? 1 : 0;
+        }
+        int total = 0;
+        for (Intersection* intersection : intersections) {
+            total += intersection->getTotalVehicleCount();
+        }
+        for (Intersection* intersection : intersections) {
+            rescanDecisions += intersection->getTotalVehicleCount() > total / intersectionCount + 3 ? 1 : 0;
+        }
+    }
+    printRate("rescan (rounds)", rounds, secondsSince(start));
+    
+    // The same decisions from the aggregates
+    const NetworkLoad& load = controller.getNetworkLoad();
+    size_t aggregateDecisions = 0;
+    start = Clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        aggregateDecisions += load.getCongested().size();
+        int64_t mean = load.getTotalQueued() / intersectionCount;
+        for (uint32_t i = 0; i < load.size(); ++i) {
+            aggregateDecisions += load.getLoad(i) > mean + 3 ? 1 : 0;
+        }
+    }
+    printRate("aggregates (rounds)", rounds, secondsSince(start));
+    
+    // optimizeTrafficFlow + balanceIntersectionLoad, re-timing included
+    start = Clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        controller.optimizeTrafficFlow();
+        controller.balanceIntersectionLoad();
+    }
+    printRate("optimize + balance (rounds)", rounds, secondsSince(start));
+    std::cout << "    " << rescanDecisions / rounds << " decisions per round, "
+              << (aggregateDecisions == rescanDecisions ? "same from the aggregates" : "AGGREGATES DIFFER") << "\n";
+}
+
+void benchCongestionIndex() {
+    const int intersectionCount = 10000;
+    const int vehicleCount = 80000;
+    const int queries = 1000;
+    const size_t k = 10;
+    
+    TrafficController controller;
+    buildNetwork(controller, intersectionCount);
+    std::vector<Intersection*> intersections;
+    for (int i = 0; i < intersectionCount; ++i) {
+        intersections.push_back(controller.getIntersection("I" + std::to_string(i)));
+    }
+    
+    std::cout << "\n[congestion] " << intersectionCount << " intersections, " << vehicleCount
+              << " queued vehicles, top " << k << "\n";
+    
+    // Queue changes, each keeping the rankings up to date
+    std::mt19937 gen(50);
+    auto start = Clock::now();
+    for (int v = 0; v < vehicleCount; ++v) {
+        int index = static_cast<int>(std::min(gen() % intersectionCount, gen() % intersectionCount));
+        intersections[index]->addVehicle(Vehicle("C" + std::to_string(v), VehicleType::CAR, static_cast<Direction>(gen() & 3)));
+    }
+    printRate("enqueue, index updated (vehicles)", vehicleCount, secondsSince(start));
+    
+    // What an operator had before: every intersection's queues, then a partial sort
+    std::vector<std::pair<int, int>> scanned;
+    size_t checksum = 0;
+    start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        scanned.clear();
+        for (int i = 0; i < intersectionCount; ++i) {
+            scanned.push_back({intersections[i]->getTotalVehicleCount(), -i});
+        }
+        std::partial_sort(scanned.begin(), scanned.begin() + k, scanned.end(), std::greater<std::pair<int, int>>());
+        checksum += scanned[0].first;
+    }
+    printRate("full scan (queries)", queries, secondsSince(start));
+    
+    const CongestionIndex& index = controller.getNetworkLoad().getCongestionIndex();
+    std::vector<CongestionEntry> entries;
+    start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        for (int metric = 0; metric < 4; ++metric) {
+            index.top(static_cast<CongestionMetric>(metric), k, 0.0, entries);
+        }
+        checksum += entries.size();
+    }
+    printRate("index, all four rankings (queries)", queries, secondsSince(start));
+    
+    index.top(CongestionMetric::QUEUE_LENGTH, k, 0.0, entries);
+    bool same = entries.size() == k;
+    for (size_t i = 0; same && i < k; ++i) {
+        same = static_cast<int>(entries[i].value) == scanned[i].first;
+    }
+    std::cout << "    worst queue " << scanned[0].first << " vehicles, "
+              << (same ? "same top " + std::to_string(k) + " from the index" : std::string("INDEX DIFFERS"))
+              << " (checksum " << checksum << ")\n";
+}
+
+struct Benchmark {
+    const char* name;
+    void (*run)();
+};
+
+const Benchmark benchmarks[] = {
+    {"ingest", benchDetectionIngestion},
+    {"eventlog", benchEventLog},
+    {"replay", benchReplay},
+    {"checkpoint", benchCheckpoint},
+    {"lookahead", benchLookahead},
+    {"scenario", benchScenario},
+    {"signals", benchSignals},
+    {"nema", benchNema},
+    {"activeset", benchActiveSet},
+    {"sharded", benchSharded},
+    {"partitioned", benchPartitioned},
+    {"spillback", benchSpillback},
+    {"routing", benchRouting},
+    {"assignment", benchAssignment},
+    {"idm", benchIdm},
+    {"greenwave", benchGreenWave},
+    {"planschedule", benchPlanSchedule},
+    {"aggregates", benchAggregates},
+    {"congestion", benchCongestionIndex},
+};
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::cout << "Smart Traffic Management System - benchmarks\n";
+    
+    for (const auto& benchmark : benchmarks) {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; ++i) {
+            if (std::strcmp(argv[i], benchmark.name) == 0) {
+                selected = true;
+            }
+        }
+        if (selected) {
+            benchmark.run();
+        }
+    }
+    
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Indices of the intersections that have work on the next tick. Membership is
+// a flag per intersection plus a dense list of the members, so waking one is
+// O(1) and walking the set costs what is in it, not the network size.
+//
+// An intersection joins when a vehicle queues at it and leaves once the tick
+// that drains its queues has finished (retain). Scheduled signal changes don't
+// need membership: SignalTimerTable already reports those slots when due.
+class ActiveSet {
+private:
+    std::vector<uint32_t> members;
+    std::vector<uint8_t> active;   // One flag per intersection
+    bool sorted;                   // Members in ascending order
+    uint64_t wakeCount;
+
+public:
+    ActiveSet();
+    
+    void resize(size_t count);     // Existing members beyond count are dropped
+    void clear();                  // Everyone dormant
+    void wake(uint32_t index);
+    bool isActive(uint32_t index) const;
+    size_t size() const;           // Active intersections
+    size_t capacity() const;       // All intersections
+    uint64_t getWakeCount() const;
+    
+    // Members in ascending order, so the work order matches a full scan
+    const std::vector<uint32_t>& getMembers();
+    
+    // Drops the members for which keep(index) is false
+    template <typename Keep>
+    void retain(Keep keep) {
+        size_t kept = 0;
+        for (uint32_t index : members) {
+            if (keep(index)) {
+                members[kept++] = index;
+            } else {
+                active[index] = 0;
+            }
+        }
+        members.resize(kept);
+    }
+};
\ No newline at end of file
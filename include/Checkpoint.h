@@ -0,0 +1,82 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Binary encoding for controller checkpoints. Values are stored raw in host
+// byte order; steady_clock times are stored as nanosecond offsets from the
+// capture instant, so a checkpoint restored by another process (with another
+// clock epoch) keeps every age, countdown and window position.
+//
+// File: "TRFCKPT1" | u32 version | u32 reserved | u64 payload size |
+//   u64 FNV-1a checksum of the payload | payload.
+class CheckpointWriter {
+private:
+    std::vector<char> buffer;
+    std::chrono::steady_clock::time_point base;
+
+public:
+    explicit CheckpointWriter(std::chrono::steady_clock::time_point captureTime);
+    
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint fields must be plain data");
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+    }
+    
+    void putString(const std::string& value);
+    void putTime(std::chrono::steady_clock::time_point value);
+    
+    std::vector<char>& data();
+    
+    // Writes beside the target and renames over it, so a crash mid-write
+    // never leaves a truncated checkpoint behind
+    static bool writeFile(const std::string& path, const std::vector<char>& payload);
+};
+
+class CheckpointReader {
+private:
+    MappedFile file;
+    const char* cursor;
+    const char* end;
+    std::chrono::steady_clock::time_point base;
+    bool failed;
+
+public:
+    CheckpointReader();
+    
+    // Maps the file and validates header and checksum; times are rebased onto restoreTime
+    bool open(const std::string& path, std::chrono::steady_clock::time_point restoreTime);
+    
+    // Reads a bare payload held by the caller (no header), e.g. one received from another process
+    void openBuffer(const char* data, size_t size, std::chrono::steady_clock::time_point restoreTime);
+    
+    template <typename T>
+    T get() {
+        static_assert(std::is_trivially_copyable<T>::value, "checkpoint fields must be plain data");
+        T value{};
+        if (failed || static_cast<size_t>(end - cursor) < sizeof(T)) {
+            failed = true;
+            return value;
+        }
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+    
+    std::string getString();
+    std::chrono::steady_clock::time_point getTime();
+    
+    // Reads an element count, failing if the rest of the payload can't hold that many
+    uint32_t getCount(size_t minElementBytes);
+    
+    void fail();
+    bool ok() const;
+    bool atEnd() const;
+};
\ No newline at end of file
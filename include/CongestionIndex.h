@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Binary max-heap over slots 0..n-1 with each slot's heap position kept
+// beside it, so a slot's key changes in O(log n) and the k largest are read
+// by a best-first walk down from the root in O(k log k).
+class IndexedHeap {
+private:
+    std::vector<double> keys;         // By slot
+    std::vector<uint32_t> heap;       // Slots in heap order
+    std::vector<uint32_t> position;   // By slot: index into heap
+    
+    void place(size_t at, uint32_t slot);
+    void siftUp(size_t at);
+    void siftDown(size_t at);
+
+public:
+    void resize(size_t count, double key);   // New slots start at key
+    void update(uint32_t slot, double key);
+    void assign(std::vector<double> newKeys);   // Every key at once, heapified in O(n)
+    
+    // Up to k slots with the largest keys, largest first
+    void top(size_t k, std::vector<uint32_t>& out) const;
+    
+    double getKey(uint32_t slot) const;
+    size_t size() const;
+};
+
+enum class CongestionMetric {
+    QUEUE_LENGTH,      // Vehicles queued at an intersection
+    AVERAGE_WAIT,      // Mean wait of the vehicles queued there, seconds
+    GROWTH_RATE,       // Queue growth, vehicles per minute
+    APPROACH_QUEUE     // Vehicles queued on one approach
+};
+
+struct CongestionEntry {
+    uint32_t index;      // Intersection
+    int approach;        // Direction for APPROACH_QUEUE, -1 otherwise
+    double value;        // In the metric's unit
+};
+
+// Ranks intersections and approaches by how congested they are, kept up to
+// date by NetworkLoad on every queue change so operators' "worst right now"
+// queries never walk the network.
+//
+// One IndexedHeap per metric. Average wait orders by mean arrival time (the
+// earlier, the longer the wait), which only moves when a vehicle joins or
+// leaves, so the order holds as time passes. Growth compares each load with
+// the load a window ago; rolling the window re-keys every intersection
+// once per GROWTH_WINDOW_SECONDS, in O(n).
+class CongestionIndex {
+public:
+    static constexpr int GROWTH_WINDOW_SECONDS = 60;
+
+private:
+    IndexedHeap byQueue;
+    IndexedHeap byWait;
+    IndexedHeap byGrowth;
+    IndexedHeap byApproach;            // Intersection i, approach a at i * 4 + a
+    std::vector<int32_t> baseline;         // Per intersection: load at the start of the previous window
+    std::vector<int32_t> windowStartLoad;  // ... and at the start of the current one
+    double baselineSeconds;
+    double windowStartSeconds;             // Negative until the first roll
+
+public:
+    CongestionIndex();
+    
+    void resize(size_t count);
+    void clear();
+    
+    void updateApproach(uint32_t index, int approach, int32_t queued);
+    void updateIntersection(uint32_t index, int32_t load, double arrivalSum);   // arrivalSum: steady-clock seconds
+    
+    // Starts a new growth window once the current one is GROWTH_WINDOW_SECONDS old
+    void rollGrowthWindow(double nowSeconds, const std::vector<int32_t>& load);
+    
+    // Up to k entries, worst first; intersections with nothing to report
+    // (empty queues, no growth) are left out
+    void top(CongestionMetric metric, size_t k, double nowSeconds, std::vector<CongestionEntry>& out) const;
+};
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Intersection.h"
+#include "LaneSimulation.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct CorridorConfig {
+    std::vector<std::string> intersections;  // In the outbound direction of travel; empty: all, in order
+    int cycleSeconds = 0;           // Common cycle (at least the longest member cycle); 0: searched
+    int maxCycleSeconds = 150;      // Upper end of the cycle search
+    double balance = 0.5;           // Inbound band at least this times the outbound one (MAXBAND's k); 0: one-way allowed
+    Direction heading = Direction::EAST;    // Outbound direction of travel where no scenario link says
+    float spacingMeters = 300.0f;   // Between signals where no scenario link joins them
+    float speed = 13.9f;            // Progression speed in metres per second, ditto
+    double resolution = 0.5;        // Seconds, of the search over the inbound band's position
+    LaneRunConfig evaluation;       // Before and after runs, one lane each way
+};
+
+// One link between neighbouring corridor signals
+struct CorridorLink {
+    float meters;
+    float speed;                    // Metres per second
+    Direction heading;              // Direction of travel: the approach it feeds
+};
+
+struct CorridorMeasures {
+    double stopsPerVehicle[2] = {0.0, 0.0};   // Outbound, inbound
+    double travelSeconds[2] = {0.0, 0.0};     // Per vehicle, corridor entry to the last stop line
+    uint64_t vehicles[2] = {0, 0};
+};
+
+struct CorridorResult {
+    bool applied = false;
+    int cycleSeconds = 0;
+    double outboundBandwidth = 0.0; // Seconds per cycle a platoon passes every signal without stopping
+    double inboundBandwidth = 0.0;
+    std::vector<int> offsets;       // Per signal: its corridor green start, seconds into the common cycle
+    CorridorMeasures before;
+    CorridorMeasures after;
+    double optimizeMilliseconds = 0.0;
+};
+
+// Green-wave coordination of the signals along an arterial.
+//
+// Every signal gets a common cycle (the extra time over its own cycle going
+// to the corridor phase) and an offset that maximizes the sum of the
+// outbound and inbound green bandwidths, subject to the directional balance
+// v >= k * w of MAXBAND so the inbound direction is never given up for a
+// wider outbound band. With the outbound band fixed at the start of the
+// cycle, a signal fits both bands of widths w and v exactly when v <= p or
+// w <= q, where p and q follow from its green and the inbound band's
+// position; so for each candidate position, sorting the signals by p gives
+// the best (w, v) in one sweep, O(C / resolution * n log n).
+//
+// Unless a cycle is given, every whole-second cycle from the longest member
+// cycle up to maxCycleSeconds is tried and the one with the largest share of
+// the cycle in the two bands kept: travel times that line up with some cycle
+// (alternate progression, for one) only show as two-way bands there. A
+// corridor of hundreds of signals takes a few hundred milliseconds.
+//
+// Offsets are applied to the intersections as cycle positions. Stops per
+// vehicle and corridor travel time are measured before and after with lane
+// microsimulations of the corridor in both directions.
+class CorridorCoordinator {
+private:
+    std::vector<Intersection*> signals;
+    std::vector<CorridorLink> outbound;   // outbound[i] joins signal i to i + 1
+    std::vector<CorridorLink> inbound;    // inbound[i] joins signal i + 1 to i
+    CorridorConfig config;
+    
+    CorridorMeasures measure() const;
+    int corridorPhase(size_t signal) const;
+
+public:
+    CorridorCoordinator(const std::vector<Intersection*>& corridor, const std::vector<CorridorLink>& outboundLinks,
+                        const std::vector<CorridorLink>& inboundLinks, const CorridorConfig& corridorConfig);
+    
+    // Widest outbound + inbound bands with v >= balance * w, all in seconds:
+    // every signal's green, its travel time from the first signal outbound and
+    // from the last one inbound. Fills every signal's green start, in seconds
+    // into the cycle, and returns w + v; 0 when no two bands fit (with
+    // balance 0 a one-way band always does).
+    static double maximizeBandwidth(double cycle, const std::vector<double>& greens,
+                                    const std::vector<double>& outboundSeconds, const std::vector<double>& inboundSeconds,
+                                    double resolution, double balance, std::vector<double>& greenStart);
+    
+    // Width of the band through arcs [start_i, start_i + green_i) on a cycle
+    static double bandwidth(double cycle, const std::vector<double>& starts, const std::vector<double>& greens);
+    
+    CorridorResult run();
+};
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class EventType : uint8_t {
+    ARRIVAL,
+    DEPARTURE,
+    PHASE_CHANGE,
+    PREEMPTION,
+    PREEMPTION_END
+};
+
+// Events are buffered column by column in fixed-size chunks. A full chunk
+// becomes one on-disk segment without any re-encoding.
+struct EventChunk {
+    static const uint32_t CAPACITY = 8192;
+    
+    std::atomic<bool> busy{false};         // Owner is mid-append (see EventLog::close)
+    uint32_t count = 0;
+    int64_t timestampNs[CAPACITY];         // Since the log was opened
+    uint32_t intersection[CAPACITY];
+    uint32_t subject[CAPACITY];            // Vehicle serial, or phase number for PHASE_CHANGE
+    uint8_t type[CAPACITY];
+    uint8_t approach[CAPACITY];
+};
+
+struct LoggedEvent {
+    int64_t timestampNs;
+    uint32_t intersection;
+    uint32_t subject;
+    EventType type;
+    uint8_t approach;
+};
+
+// High-throughput binary log of vehicle and signal events.
+//
+// File layout (little-endian):
+//   header  : "TRAFLOG1" | u32 version | u32 chunk capacity | i64 wall-clock start (ns since epoch)
+//   segment : "SEG1" | u32 count | i64 timestamps[count] | u32 intersections[count]
+//             | u32 subjects[count] | u8 types[count] | u8 approaches[count]
+//
+// Producers append into a chunk owned by their thread; only acquiring a new
+// chunk every CAPACITY events takes the lock. Full chunks are written by a
+// background thread through a large stream buffer. Segments appear in flush
+// order, so events from different threads are not globally time-sorted.
+class EventLog {
+private:
+    static const uint32_t FORMAT_VERSION = 1;
+    
+    std::atomic<uint64_t> sessionId;       // New per open(); keys the per-thread chunk slots
+    std::atomic<bool> accepting;
+    std::chrono::steady_clock::time_point startTime;
+    std::ofstream file;
+    std::vector<char> streamBuffer;
+    
+    std::mutex poolMutex;
+    std::condition_variable writerWakeup;
+    std::vector<std::unique_ptr<EventChunk>> chunks;   // Owns every chunk ever handed out
+    std::vector<EventChunk*> freeChunks;
+    std::vector<EventChunk*> activeChunks;             // Currently held by a producer thread
+    std::deque<EventChunk*> writeQueue;
+    bool writerStop;
+    std::thread writerThread;
+    
+    std::atomic<uint64_t> eventsWritten;
+    std::atomic<uint64_t> segmentsWritten;
+    
+    EventChunk* acquireChunk();
+    void submitChunk(EventChunk* chunk);
+    void writerLoop();
+    void writeSegment(const EventChunk& chunk);
+
+public:
+    EventLog();
+    ~EventLog();
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+    
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const;
+    
+    // Hot path: a few column stores into the calling thread's chunk
+    void append(EventType type, uint32_t intersection, uint8_t approach, uint32_t subject);
+    
+    uint64_t getEventsWritten() const;
+    uint64_t getSegmentsWritten() const;
+    
+    // Reads a whole log back into row form (for tooling and verification)
+    static bool readFile(const std::string& filename, std::vector<LoggedEvent>& events);
+};
\ No newline at end of file
@@ -3,26 +3,69 @@
 #include "TrafficLight.h"
 #include "Vehicle.h"
 #include "TrafficSensor.h"
+#include "StateSnapshot.h"
+#include "EventLog.h"
+#include "IntersectionFork.h"
+#include "SignalState.h"
+#include "SignalTimerTable.h"
+#include "RingBarrier.h"
+#include "ActiveSet.h"
+#include "NetworkLoad.h"
+#include "PlanSchedule.h"
 #include <vector>
-#include <queue>
+#include <deque>
 #include <string>
 #include <map>
+#include <array>
+#include <memory>
 
 class Intersection {
 private:
     std::string id;
-    std::vector<TrafficLight> lights;
+    SignalState signals;                             // Every approach's indication, packed
+    std::array<int16_t, 4> signalDuration;           // Per approach: length of the current indication
+    SignalTimerSlot timers;                          // Phase timer and countdowns, possibly in a shared table
+    uint8_t signalEmergencyMask;                     // Approaches held by emergency preemption
     std::vector<TrafficSensor> sensors;
-    std::vector<std::queue<Vehicle>> vehicleQueues;  // One queue per direction
+    std::vector<std::deque<Vehicle>> vehicleQueues;  // One FIFO per movement (approach * 3 + turn)
+    MovementMask queuedMovements;                    // Movements with a non-empty queue
+    std::array<uint16_t, 4> approachCapacity;        // Per approach: storage in vehicles, 0 unbounded
+    std::array<int, 4> sensorIndex;                  // Sensor slot per direction, -1 if none
+    double queuedArrivalSeconds;                     // Sum of arrival times of queued vehicles
+    EventLog* eventLog;                              // Optional binary event sink (not owned)
+    uint32_t logIndex;                               // This intersection's id in the event log
+    ActiveSet* activeSet;                            // Woken when the first vehicle queues (not owned)
+    uint32_t activeIndex;
+    NetworkLoad* networkLoad;                        // Told of every queue change (not owned)
+    uint32_t loadIndex;
     bool emergencyMode;
     int cycleTime;             // Total cycle time in seconds
     int currentPhase;          // Current phase of the cycle
-    std::chrono::steady_clock::time_point lastUpdate;
+    int phaseLength;           // Length of the current phase; reset to the plan at each switch
+    std::chrono::steady_clock::time_point lastUpdate;  // Last per-object step (stepSecond)
+    
+    // Ring-and-barrier phasing; the two-phase N-S/E-W cycle runs while inactive
+    bool ringBarrierActive;
+    RingBarrierState ringBarrier;
+    
+    // Time-of-day plans, run by the controller's PlanScheduler (shared, not checkpointed)
+    std::shared_ptr<const PlanSchedule> planSchedule;
     
     // Timing configuration
     std::map<Direction, int> greenDuration;
     std::map<Direction, int> yellowDuration;
     int redDuration;
+    
+    void enqueueVehicle(int movement, const Vehicle& vehicle);
+    size_t dischargeVehicles(std::vector<Vehicle>* departed, std::array<int32_t, 4>* exitRoom, size_t* held);
+    Vehicle dequeueVehicle(int movement);
+    void applySignals(SignalState next);
+    void scheduleNextEvent();
+    void scheduleSensorRoll();
+    void rollSensorWindows(std::chrono::steady_clock::time_point now);
+    void wakeSensorRoll(const TrafficSensor& sensor);   // After a detection at a sensor that may be at rest
+    void advanceRingBarrier();
+    void applyRingBarrierSignals();
 
 public:
     Intersection(const std::string& intersectionId);
@@ -31,34 +74,81 @@ public:
     void addTrafficLight(Direction dir);
     void addTrafficSensor(Direction dir);
     void configureTiming(Direction dir, int greenTime, int yellowTime);
+    void attachEventLog(EventLog* log, uint32_t index);
+    void attachSignalTimers(SignalTimerTable* table, uint32_t slot);  // nullptr detaches
+    void attachActiveSet(ActiveSet* set, uint32_t index);             // nullptr detaches
+    void attachNetworkLoad(NetworkLoad* load, uint32_t index);        // nullptr detaches
+    void setApproachCapacity(Direction dir, int vehicles);            // 0: unbounded
     
     // Vehicle management
-    void addVehicle(const Vehicle& vehicle);
-    void processVehicleQueues();
+    bool addVehicle(const Vehicle& vehicle);  // False, and not queued, when its approach is full
+    size_t applyDetections(const DetectionEvent* first, const DetectionEvent* last);
+    size_t processVehicleQueues();  // Returns vehicles discharged
+    size_t processVehicleQueues(std::vector<Vehicle>& departed);  // Also appends them to departed
+    // Spillback: exitRoom[h] is the space left on the link leaving heading h. A
+    // movement with a green whose exit has no room holds its vehicle at the stop
+    // line (counted in held); every departure takes one unit of room.
+    size_t processVehicleQueues(std::vector<Vehicle>& departed, std::array<int32_t, 4>& exitRoom, size_t& held);
     Vehicle removeVehicle(Direction dir);
     
     // Signal control
-    void updateSignals();
+    bool updateSignals();      // True when a second of signal time elapsed
+    void stepSecond(std::chrono::steady_clock::time_point now);  // One second of signal time
+    void completeSecond(std::chrono::steady_clock::time_point now);  // Due work once the timers advanced
     void handleEmergencyVehicle(Direction emergencyDir);
     void normalOperation();
-    void switchToNextPhase();
+    void switchToNextPhase();  // Due signal change: yellow onset or the next phase
+    void setPhaseLength(int seconds);
+    int getCycleLength() const;           // Both phases of the two-phase plan
+    int getCyclePosition() const;
+    void setCyclePosition(int second);    // Seconds since phase 0's green began, modulo the cycle
+    void setPlanSchedule(std::shared_ptr<const PlanSchedule> schedule);   // nullptr: fixed timing
+    const std::shared_ptr<const PlanSchedule>& getPlanSchedule() const;
+    
+    // Ring-and-barrier phasing (validated against the movement conflict matrix)
+    bool setRingBarrierPlan(const RingBarrierPlan& plan, std::string& error);
+    void clearRingBarrierPlan();   // Back to the two-phase cycle
+    bool hasRingBarrierPlan() const;
+    const RingBarrierState& getRingBarrier() const;
+    MovementMask getProtectedGreen() const;   // Movements with right of way
+    MovementMask getPermittedGreen() const;   // Movements that may go after yielding
     
     // Getters
     std::string getId() const;
-    std::vector<TrafficLight>& getLights();
-    std::vector<TrafficSensor>& getSensors();
+    std::vector<TrafficLight> getLights() const;    // Views of the packed signal state
+    TrafficLight getLight(Direction dir) const;
+    SignalState getSignalState() const;
+    std::vector<TrafficSensor>& getSensors();   // A shorter interval set here applies from the next roll
+    TrafficSensor* getSensor(Direction dir);
     bool isEmergencyMode() const;
     int getCurrentPhase() const;
+    int getPhaseTimer() const;
+    int getPhaseLength() const;
+    int getPlannedPhaseLength(int phase) const;   // Longest green plus yellow of the approaches served
+    int getPlannedYellow(int phase) const;
     
     // Queue management
-    int getQueueLength(Direction dir) const;
-    std::queue<Vehicle>& getQueue(Direction dir);
+    int getQueueLength(Direction dir) const;   // All movements of the approach
+    int getMovementQueueLength(Direction dir, Turn turn) const;
+    int getApproachCapacity(Direction dir) const;   // 0: unbounded
+    bool isApproachFull(Direction dir) const;
+    const std::deque<Vehicle>& getQueue(Direction dir, Turn turn) const;
     
     // Analytics
     double getAverageWaitTime() const;
     int getTotalVehicleCount() const;
+    bool hasQueuedVehicles() const;
     void clearQueues();
+    void shiftArrivalTimes(std::chrono::steady_clock::duration by);   // Every queued vehicle's, keeping their order
+    
+    // Lookahead: cheap copy-on-write fork of signal and queue state at time now
+    IntersectionFork fork(std::chrono::steady_clock::time_point now) const;
     
     // Display
+    void captureSnapshot(IntersectionSnapshot& out) const;
     void displayStatus() const;
+    
+    // Checkpointing (the event-log attachment is not part of the state)
+    void writeCheckpoint(CheckpointWriter& out) const;
+    void readCheckpoint(CheckpointReader& in);
 };
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A vehicle as the lookahead model sees it
+struct ForkedVehicle {
+    float waitedSeconds;       // Time already spent queued when the fork was taken
+    float weight;              // Cost multiplier (vehicle priority)
+};
+
+// Everything captured at fork time that no branch ever changes. Shared by all
+// forks taken from the same intersection state.
+struct IntersectionForkBase {
+    std::array<std::vector<ForkedVehicle>, 4> queues;  // Per approach, front first
+    std::array<double, 4> arrivalRate;                 // Predicted vehicles per second
+    std::array<int, 2> phaseLength;                    // Planned length of each phase
+    std::array<int, 2> yellowSeconds;
+};
+
+struct ForkCostModel {
+    double saturationFlow = 1.0;     // Vehicles per second per green approach
+    double maxWaitSeconds = 120.0;   // Waits beyond this are penalised...
+    double starvationWeight = 4.0;   // ...at this multiple of the normal cost
+};
+
+// Copy-on-write fork of one intersection's signal and queue state for
+// model-predictive lookahead. Queued vehicles stay in the shared base and are
+// consumed through per-approach cursors; arrivals predicted during the
+// lookahead are tracked as fluid queue lengths. Copying a fork is O(1) in the
+// number of queued vehicles, so every candidate decision gets its own branch.
+class IntersectionFork {
+private:
+    std::shared_ptr<const IntersectionForkBase> base;
+    std::array<uint32_t, 4> discharged;     // Base vehicles already departed per approach
+    std::array<double, 4> predictedQueue;   // Vehicles that arrived after the fork
+    uint8_t greenMask;                      // Bit per approach allowed to proceed
+    int currentPhase;
+    int phaseTimer;
+    int phaseLength;
+    int elapsedSeconds;
+    double cost;                            // Weighted vehicle-seconds of delay so far
+    
+    double departureCost(const ForkedVehicle& vehicle, const ForkCostModel& model) const;
+
+public:
+    IntersectionFork(std::shared_ptr<const IntersectionForkBase> sharedBase, int phase, int timer,
+                     int length, uint8_t green);
+    
+    // One second of signal time followed by queue discharge, like Intersection::stepSecond
+    // plus processVehicleQueues
+    void step(const ForkCostModel& model);
+    void run(int seconds, const ForkCostModel& model);
+    void setPhaseLength(int seconds);
+    
+    // Getters
+    int getCurrentPhase() const;
+    int getPhaseTimer() const;
+    int getPhaseLength() const;
+    int getElapsedSeconds() const;
+    int getYellowSeconds() const;                       // Of the current phase
+    double getQueuedVehicles() const;
+    double getCost(const ForkCostModel& model) const;   // Includes vehicles still queued
+    
+    static uint8_t phaseGreenMask(int phase);
+};
\ No newline at end of file
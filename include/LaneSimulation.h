@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Intersection.h"
+#include <cstdint>
+#include <vector>
+
+// Intelligent Driver Model parameters, shared by every vehicle
+struct IdmParameters {
+    float desiredSpeed = 13.9f;     // Metres per second (50 km/h)
+    float timeHeadway = 1.5f;       // Seconds
+    float minGap = 2.0f;            // Metres, bumper to bumper at standstill
+    float maxAcceleration = 1.0f;   // Metres per second squared
+    float comfortDeceleration = 2.0f;
+    float vehicleLength = 5.0f;     // Metres
+};
+
+struct LaneRunConfig {
+    IdmParameters idm;
+    int stepsPerSecond = 10;        // Car-following steps; signals change on whole seconds
+    int64_t seconds = 600;
+    uint64_t seed = 1;
+    
+    // Used when the controller lays out one set of lanes per signalled approach
+    int lanesPerApproach = 2;       // Without a scenario link feeding the approach
+    float approachMeters = 300.0f;  // ...
+    float demandPerLaneHour = 600.0f;
+};
+
+// One lane up to a stop line
+struct LaneSpec {
+    float lengthMeters = 300.0f;
+    int32_t signal = -1;            // Index of the signal at its end; -1: none, vehicles never stop there
+    Direction approach = Direction::NORTH;   // Signal head that controls it
+    int32_t next = -1;              // Lane vehicles continue on past the stop line; -1: they leave
+    float demandPerHour = 0.0f;     // Vehicles entering at its upstream end
+};
+
+struct LaneRunResult {
+    uint32_t lanes = 0;
+    int64_t simulatedSeconds = 0;
+    int stepsPerSecond = 0;
+    double wallSeconds = 0.0;
+    uint64_t vehiclesEntered = 0;
+    uint64_t vehiclesLeft = 0;      // Crossed the stop line of a lane with no next lane
+    uint64_t stopLineCrossings = 0; // Every lane's stop line
+    uint64_t vehiclesOnLanes = 0;   // At the end
+    uint64_t peakVehicles = 0;      // Most on the lanes at once, sampled every second
+    uint64_t entryBacklog = 0;      // Demand still waiting for room to enter at the end
+    uint64_t vehicleUpdates = 0;    // Vehicle-steps computed
+    double travelSeconds = 0.0;     // Summed over the vehicles that left, entry to exit
+    double stops = 0.0;             // ... and their stops
+    
+    double getStopsPerVehicle() const;
+    double getAverageTravelTime() const;        // Seconds per vehicle that left
+    double getRealTimeFactor() const;           // Simulated seconds per wall-clock second
+    double getUpdatesPerSecond() const;         // Vehicle-steps per wall-clock second
+};
+
+// Microscopic simulation of vehicles on lanes, for detailed corridor studies
+// where a point queue is too coarse.
+//
+// Every lane keeps its vehicles front to back in parallel arrays (position,
+// speed, acceleration, ...), so a vehicle's leader is the previous element
+// and the Intelligent Driver Model step is a branch-free loop over
+// contiguous floats that the compiler vectorizes. A step first computes all
+// accelerations, then integrates all lanes (ballistic, never reversing),
+// then moves the vehicles that crossed a stop line onto their next lane, so
+// the result does not depend on lane order.
+//
+// The first vehicle of a lane follows the last vehicle of the next lane and,
+// when its signal says stop, a standing obstacle at the stop line: on red
+// always, on yellow only if it can still stop at the comfortable
+// deceleration. The signals are copies of the given intersections, stepped
+// once per simulated second; the originals are left untouched.
+class LaneSimulation {
+private:
+    struct Lane {
+        LaneSpec spec;
+        bool stopAtLine;            // Signal state as of the last whole second
+        bool yellowAtLine;
+        bool committed;             // The front vehicle went on yellow and no longer stops
+        uint32_t head;              // First vehicle still on the lane
+        uint64_t pending;           // Arrivals waiting for room at the entry
+        std::vector<float> position;    // Metres from the lane start, decreasing from the front
+        std::vector<float> speed;
+        std::vector<float> acceleration;
+        std::vector<float> entered;     // Simulated second it entered the network
+        std::vector<float> stops;       // Counts kept as floats so the step loop stays all-float
+        std::vector<float> moving;      // 1 while moving, 0 once stopped (with hysteresis)
+        
+        uint32_t size() const { return static_cast<uint32_t>(position.size()) - head; }
+    };
+    
+    std::vector<Intersection> signals;
+    std::vector<Lane> lanes;
+    LaneRunConfig config;
+    
+    void readSignals();
+    void computeAccelerations();
+    void integrate(float dt);
+    void moveAcrossStopLines(float now, LaneRunResult& result);
+    void admitArrivals(Lane& lane, float now, LaneRunResult& result);
+    void append(Lane& lane, float position, float speed, float entered, float stops, float moving);
+    static void compact(Lane& lane);
+
+public:
+    // Copies the intersections; LaneSpec::signal indexes this list
+    LaneSimulation(const std::vector<const Intersection*>& signalSources, const LaneRunConfig& runConfig);
+    
+    int32_t addLane(const LaneSpec& spec);   // Returns its index; next may name a lane added later
+    uint32_t getLaneCount() const { return static_cast<uint32_t>(lanes.size()); }
+    
+    LaneRunResult run();
+};
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "IntersectionFork.h"
+#include <cstdint>
+
+enum class ControlStrategy {
+    FIXED_TIME,     // Every phase runs its configured length
+    LOOKAHEAD       // Phase lengths chosen by simulating candidate decisions
+};
+
+struct LookaheadConfig {
+    int horizonSeconds = 90;       // How far each candidate is simulated
+    int minGreenSeconds = 10;      // No decision before a phase has had this much green
+    int maxGreenSeconds = 60;
+    int candidateStepSeconds = 5;  // Spacing of the candidate green extensions
+    int replanSeconds = 5;         // Rolling-horizon replanning interval
+    ForkCostModel costModel;
+};
+
+struct LookaheadDecision {
+    int extraGreenSeconds = 0;     // Green to keep after the next second before yellow
+    int candidates = 0;
+    double cost = 0.0;             // Predicted cost of the chosen candidate
+    double fixedTimeCost = 0.0;    // Predicted cost of leaving the plan alone
+};
+
+// Model-predictive phase control: at each decision point every candidate green
+// extension is simulated over the horizon on its own fork of the intersection
+// and the cheapest one is committed.
+class LookaheadController {
+private:
+    LookaheadConfig config;
+    uint64_t decisions;
+    uint64_t candidatesEvaluated;
+    double totalDecisionMs;
+    double maxDecisionMs;
+
+public:
+    LookaheadController();
+    
+    void setConfig(const LookaheadConfig& newConfig);
+    const LookaheadConfig& getConfig() const;
+    
+    // Whether an intersection at this point of its phase should be replanned
+    bool isDecisionPoint(int phaseTimer, int phaseLength, int yellowSeconds) const;
+    LookaheadDecision decide(const IntersectionFork& root);
+    
+    // Getters
+    uint64_t getDecisions() const;
+    uint64_t getCandidatesEvaluated() const;
+    double getAverageDecisionMs() const;
+    double getMaxDecisionMs() const;
+};
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Contents are used in place;
+// nothing is copied into the process heap.
+class MappedFile {
+private:
+    const char* mappedData;
+    size_t mappedSize;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    bool open(const std::string& path);
+    void close();
+    void adviseSequential();
+    
+    // Getters
+    bool isOpen() const;
+    const char* data() const;
+    size_t size() const;
+};
\ No newline at end of file
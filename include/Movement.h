@@ -0,0 +1,88 @@
+#pragma once
+
+#include "TrafficLight.h"
+#include <array>
+#include <cstdint>
+#include <string>
+
+enum class Turn {
+    LEFT,
+    THROUGH,
+    RIGHT
+};
+
+// Movement m = approach * 3 + turn, so approach d owns bits 3d..3d+2 of a mask
+using MovementMask = uint16_t;
+const int MOVEMENT_COUNT = 12;
+const MovementMask ALL_MOVEMENTS = 0x0FFF;
+
+inline int movementIndex(Direction approach, Turn turn) {
+    return static_cast<int>(approach) * 3 + static_cast<int>(turn);
+}
+
+inline MovementMask movementBit(Direction approach, Turn turn) {
+    return static_cast<MovementMask>(1u << movementIndex(approach, turn));
+}
+
+inline Direction movementApproach(int movement) {
+    return static_cast<Direction>(movement / 3);
+}
+
+inline Turn movementTurn(int movement) {
+    return static_cast<Turn>(movement % 3);
+}
+
+inline MovementMask approachMovements(Direction approach) {
+    return static_cast<MovementMask>(0x7u << (static_cast<int>(approach) * 3));
+}
+
+// The same turn on every approach
+inline MovementMask turnMovements(Turn turn) {
+    return static_cast<MovementMask>(0x249u << static_cast<int>(turn));
+}
+
+// Approaches (Direction bitmask) with at least one movement in the set
+uint8_t movementApproaches(MovementMask movements);
+MovementMask approachMaskMovements(uint8_t approaches);
+Direction opposingApproach(Direction approach);
+Direction turnHeading(Direction heading, Turn turn);   // Direction of travel after the turn
+bool turnBetween(Direction heading, Direction exitHeading, Turn& turn);  // False for a U-turn
+// A signalled approach (Direction bitmask) and turn that leave heading exitHeading,
+// preferring through, then right, then left
+bool approachFor(uint8_t approaches, Direction exitHeading, Direction& approach, Turn& turn);
+std::string movementName(int movement);    // e.g. "N-L"
+
+// Crossing conflicts between the twelve movements of a four-leg intersection
+// with right-hand traffic, precomputed once. Each movement is a chord from its
+// entry point to its exit point on the intersection boundary; two movements
+// conflict when their chords cross. Movements from the same approach never
+// conflict, and merges into the same exit leg are not treated as conflicts
+// (the exit is assumed wide enough to take both).
+//
+// The union of conflicts is tabulated for every possible movement set, so any
+// set-against-set check is two loads and an AND.
+class ConflictMatrix {
+private:
+    std::array<MovementMask, MOVEMENT_COUNT> rows;
+    std::array<MovementMask, ALL_MOVEMENTS + 1> unions;
+    
+    ConflictMatrix();
+
+public:
+    static const ConflictMatrix& instance();
+    
+    MovementMask conflictsOf(int movement) const {
+        return rows[movement];
+    }
+    
+    // Every movement that conflicts with at least one movement of the set
+    MovementMask conflictsOfSet(MovementMask movements) const {
+        return unions[movements & ALL_MOVEMENTS];
+    }
+    
+    bool compatible(MovementMask a, MovementMask b) const {
+        return (conflictsOfSet(a) & b) == 0;
+    }
+    
+    void display() const;
+};
\ No newline at end of file
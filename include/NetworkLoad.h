@@ -0,0 +1,80 @@
+#pragma once
+
+#include "TrafficLight.h"
+#include "CongestionIndex.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Network-wide queue aggregates, updated by the intersections themselves as
+// deltas on every enqueue and dequeue, so control decisions read them
+// instead of walking every intersection's queues.
+//
+// Counts are kept per approach in one contiguous array (four per
+// intersection), with each intersection's load and the network total beside
+// them. Intersections with an approach queue longer than LONG_QUEUE are kept
+// in a dense list as well (a flag per intersection plus the members, as in
+// ActiveSet), so the ones that need a longer green are found without a scan.
+// Every change is passed on to a CongestionIndex as well, which ranks the
+// worst intersections and approaches for operators.
+//
+// Not synchronized: while the system runs only the controller thread
+// touches it, and resize, clear and set (which rebuild the lists and heaps)
+// are left to the controller's mutators that refuse while running.
+class NetworkLoad {
+public:
+    static constexpr int32_t LONG_QUEUE = 5;   // More than this on one approach: the intersection is congested
+
+private:
+    static constexpr uint32_t NOT_LISTED = 0xFFFFFFFFu;
+    
+    std::vector<int32_t> approachQueued;   // Intersection i, approach a at i * 4 + a
+    std::vector<int32_t> load;             // Per intersection, all approaches
+    std::vector<uint8_t> longApproaches;   // Per intersection: approaches over LONG_QUEUE
+    std::vector<uint32_t> congested;       // Intersections with a long approach, unordered
+    std::vector<uint32_t> congestedSlot;   // Position in congested, NOT_LISTED if absent
+    std::vector<double> arrivalSum;        // Per intersection: arrival times of its queued vehicles, steady-clock seconds
+    int64_t totalQueued;
+    CongestionIndex congestion;
+    
+    void setLong(uint32_t index, bool isLong);
+
+public:
+    NetworkLoad();
+    
+    void resize(size_t count);     // Counts beyond count are dropped, new ones start at zero
+    void clear();                  // Every count back to zero
+    
+    // One vehicle more (delta 1) or fewer (-1) on an approach, arrived at arrivalSeconds
+    void add(uint32_t index, int approach, int32_t delta, double arrivalSeconds) {
+        int32_t& queued = approachQueued[index * 4 + approach];
+        bool wasLong = queued > LONG_QUEUE;
+        queued += delta;
+        load[index] += delta;
+        totalQueued += delta;
+        // Reset once the intersection drains so rounding never accumulates
+        arrivalSum[index] = load[index] > 0 ? arrivalSum[index] + delta * arrivalSeconds : 0.0;
+        if ((queued > LONG_QUEUE) != wasLong) {
+            setLong(index, !wasLong);
+        }
+        congestion.updateApproach(index, approach, queued);
+        congestion.updateIntersection(index, load[index], arrivalSum[index]);
+    }
+    
+    // Replaces an intersection's counts, for attaching one that already has queues
+    void set(uint32_t index, const std::array<int32_t, 4>& queued, double queuedArrivalSum);
+    
+    // Growth is measured against the loads as of the last roll (see CongestionIndex)
+    void rollGrowthWindow(double nowSeconds);
+    
+    // Getters
+    size_t size() const;
+    int64_t getTotalQueued() const;
+    double getMeanLoad() const;                // Queued vehicles per intersection
+    int32_t getLoad(uint32_t index) const;
+    int32_t getApproachQueued(uint32_t index, Direction dir) const;
+    Direction getLongestApproach(uint32_t index) const;   // The first of equals, in Direction order
+    const std::vector<uint32_t>& getCongested() const;
+    const CongestionIndex& getCongestionIndex() const;
+};
\ No newline at end of file
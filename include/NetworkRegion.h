@@ -0,0 +1,195 @@
+#pragma once
+
+#include "Intersection.h"
+#include "Scenario.h"
+#include "RouteTable.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+struct NetworkRunConfig {
+    int workers = 0;                // Threads or processes; 0: one per hardware thread
+    int64_t seconds = 3600;         // Simulated time
+    int64_t startSecondOfDay = 0;   // Where the demand profiles are read from
+    uint64_t seed = 1;
+    bool pinThreads = true;         // Linux: worker w stays on CPU w (when there are enough CPUs)
+    bool collectLinkTimes = false;  // Fill the result's per-link travel times (routed vehicles only)
+    bool spillback = true;          // Links store a bounded number of vehicles; a full one holds upstream discharge
+    int entryStorage = 60;          // With spillback: queue limit on approaches no link feeds
+};
+
+struct NetworkRunResult {
+    int workers = 0;
+    uint32_t cutLinks = 0;          // Links whose ends are in different regions
+    int64_t simulatedSeconds = 0;
+    double wallSeconds = 0.0;
+    uint64_t vehiclesEntered = 0;   // Generated from the demand profiles
+    uint64_t vehiclesExited = 0;    // Left on a leg with no outgoing link, or at their destination
+    uint64_t tripsStarted = 0;      // ... of the entered, generated from the OD trips
+    uint64_t tripsCompleted = 0;    // ... of the exited, reached their destination
+    uint64_t departures = 0;        // Discharged by an intersection
+    uint64_t linkTransfers = 0;     // Sent down a link to the next intersection
+    uint64_t boundaryTransfers = 0; // ... of which crossed into another region
+    uint64_t vehiclesInNetwork = 0; // Queued or on a link at the end
+    uint64_t entriesRefused = 0;    // Demand and trip vehicles turned away by a full approach
+    uint64_t heldDischarges = 0;    // Green movements held at the stop line by a full downstream link
+    uint32_t fullLinks = 0;         // Links at or over their storage at the end
+    double vehicleSeconds = 0.0;    // Time spent in the network by all vehicles
+    std::vector<double> linkSeconds;        // Per scenario link when collected: summed experienced travel time
+    std::vector<uint32_t> linkTraversals;   // ... over this many traversals
+    
+    double getSpeedup() const;              // Simulated seconds per wall-clock second
+    double getAverageTimeInNetwork() const; // Seconds per entered vehicle
+};
+
+// A vehicle sent down a link that ends in another region
+struct VehicleTransfer {
+    uint32_t link;
+    int64_t readySecond;            // When it reaches the end of the link
+    Vehicle vehicle;
+};
+
+// Storage in use on a link (vehicles on it plus those queued at its end),
+// reported by the region the link ends in to the region it starts in
+struct LinkOccupancy {
+    uint32_t link;
+    uint32_t vehicles;
+};
+
+// What one region sends another in a second
+struct BoundaryExchange {
+    std::vector<VehicleTransfer> vehicles;
+    std::vector<LinkOccupancy> occupancy;
+};
+
+// A scenario's road network cut into regions, with the link lookups every
+// region needs. Read-only once built, so regions on different threads share it.
+//
+// Links name the downstream queue by direction of travel. A vehicle turning
+// out of queue h leaves heading turnHeading(h, turn) on the outgoing link with
+// that heading, or leaves the network if there is none. Vehicles on an OD
+// trip follow their route instead and leave at its destination.
+class NetworkTopology {
+private:
+    const ScenarioFile& scenario;
+    const RouteTable* routes;            // Null without OD trips
+    std::vector<uint32_t> nodeOwner;     // Region per node
+    uint32_t regionCount;
+    uint32_t linkCount;
+    std::vector<int32_t> outLinks;       // Four per node, by heading; -1 where there is none
+    std::vector<uint32_t> linkSlot;      // Index of each link among the links its region owns
+    std::vector<uint32_t> outSlot;       // Index of each link among those leaving its start region
+    std::vector<int32_t> travelSeconds;  // Free-flow travel time per link
+    std::vector<uint32_t> storage;       // Vehicles per link at jam density
+    uint32_t cutLinks;
+
+public:
+    // The first nodeCount nodes of the scenario are simulated
+    NetworkTopology(const ScenarioFile& network, uint32_t nodeCount, int regions, const RouteTable* tripRoutes = nullptr);
+    
+    // Region (0..regions-1) of every node: recursive coordinate bisection,
+    // so each region is contiguous with about nodeCount / regions nodes
+    static std::vector<uint32_t> partition(const ScenarioFile& network, int regions);
+    
+    // Getters
+    const ScenarioFile& getScenario() const { return scenario; }
+    const RouteTable* getRoutes() const { return routes; }
+    uint32_t getNodeCount() const { return static_cast<uint32_t>(nodeOwner.size()); }
+    uint32_t getRegionCount() const { return regionCount; }
+    uint32_t getRegion(uint32_t node) const { return nodeOwner[node]; }
+    uint32_t getLinkCount() const { return linkCount; }
+    const ScenarioLink& getLink(uint32_t link) const { return scenario.outgoingBegin(0)[link]; }
+    bool isSimulated(uint32_t link) const;   // Both ends are nodes of the network
+    int32_t getOutLink(uint32_t node, Direction heading) const { return outLinks[node * 4 + static_cast<int>(heading)]; }
+    uint32_t getLinkSlot(uint32_t link) const { return linkSlot[link]; }
+    uint32_t getOutSlot(uint32_t link) const { return outSlot[link]; }
+    int32_t getTravelSeconds(uint32_t link) const { return travelSeconds[link]; }
+    uint32_t getStorage(uint32_t link) const { return storage[link]; }
+    uint32_t getCutLinkCount() const { return cutLinks; }
+};
+
+// One region's share of a network run: its intersections and the links that
+// end in it. Each simulated second moves vehicles that have travelled their
+// link into the downstream queues, adds the second's demand, steps the
+// signals and sends discharged vehicles on, either down a local link or into
+// the outbox of the region the link ends in.
+//
+// Turns and demand are drawn from hashes of (node, approach, second, ...)
+// rather than a shared RNG, so a run gives the same result however the
+// network is cut, provided every region's outbox is delivered (receive)
+// before the next second.
+//
+// With spillback, a link holds its storage in vehicles, counting those on it
+// and those queued at its end. The downstream region reports a link's
+// occupancy at the start of each second, only when it changed; the upstream
+// region uses it from the next second on, minus what it has sent since, as
+// the room left for discharge. Reports reach local and remote regions with
+// the same one-second delay, so spillback, too, is independent of the cut. A
+// full approach leaves arriving vehicles at the end of their link, which
+// fills it and so holds the intersection upstream: gridlock propagates link
+// by link.
+class NetworkRegion {
+private:
+    struct InTransit {
+        int64_t readySecond;
+        Vehicle vehicle;
+    };
+    
+    const NetworkTopology& topology;
+    NetworkRunConfig config;
+    uint32_t region;
+    std::vector<uint32_t> nodes;                 // Ascending
+    std::vector<Intersection*> local;            // Per local node (not owned)
+    std::vector<uint32_t> inboundBegin;          // Per local node, into inboundLinks
+    std::vector<uint32_t> inboundLinks;
+    std::vector<uint32_t> tripBegin;             // Per local node, into trips
+    std::vector<uint32_t> trips;                 // Routed scenario trips starting here
+    std::vector<std::deque<InTransit>> transit;  // Links ending here, by link slot
+    std::vector<uint32_t> reportedOccupancy;     // By link slot: the last occupancy sent upstream
+    std::vector<uint32_t> downstreamOccupancy;   // Links leaving here, by out slot: last report in effect
+    std::vector<uint32_t> pendingOccupancy;      // ... report that takes effect next second, if any
+    std::vector<uint32_t> sentNow;               // ... vehicles sent this second
+    std::vector<uint32_t> sentBefore;            // ... and the second before, both unseen by the report
+    std::vector<double> linkSeconds;             // By link slot, when collecting link times
+    std::vector<uint32_t> linkTraversals;
+    std::vector<Vehicle> departed;               // Scratch for one intersection's discharge
+    
+    uint64_t entered;
+    uint64_t exited;
+    uint64_t tripsStarted;
+    uint64_t tripsCompleted;
+    uint64_t departures;
+    uint64_t linkTransfers;
+    uint64_t boundaryTransfers;
+    uint64_t entriesRefused;
+    uint64_t heldDischarges;
+    int64_t resident;                            // Queued here at the start + entered - exited
+    double vehicleSeconds;
+    
+    bool routeIsSimulated(uint32_t route) const;
+    uint32_t getOccupancy(size_t localNode, uint32_t link) const;   // A link ending at a local node
+    void exchangeOccupancy(std::vector<BoundaryExchange>& outbox);
+    void startTrips(Intersection& intersection, uint32_t trip, int64_t second, std::chrono::steady_clock::time_point now);
+    bool arrive(Intersection& intersection, Vehicle& vehicle, Direction heading, std::chrono::steady_clock::time_point now);
+    void recordTraversal(const Vehicle& vehicle, std::chrono::steady_clock::time_point now);
+
+public:
+    // byNode[node] is the intersection for every node of this region
+    NetworkRegion(const NetworkTopology& network, uint32_t regionIndex, const NetworkRunConfig& runConfig,
+                  const std::vector<Intersection*>& byNode);
+    
+    void receive(VehicleTransfer&& transfer);
+    void receive(const LinkOccupancy& report);   // A link leaving this region
+    
+    // One second of simulated time. Transfers and reports to other regions are
+    // appended to outbox[region]; the caller empties it once they are delivered.
+    void step(int64_t second, std::chrono::steady_clock::time_point now, std::vector<BoundaryExchange>& outbox);
+    
+    // Adds this region's counts, including the vehicles it holds now
+    void addTo(NetworkRunResult& result) const;
+    
+    // Getters
+    uint32_t getRegion() const { return region; }
+    const std::vector<uint32_t>& getNodes() const { return nodes; }
+};
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "NetworkRegion.h"
+#include <memory>
+#include <vector>
+
+// Runs a scenario network with each region in its own worker process, the
+// process-level counterpart of ShardedSimulation.
+//
+// The calling process is the coordinator. It forks one worker per region and
+// talks to each over a Unix domain socket pair; workers never talk to each
+// other. Every simulated second the coordinator sends each worker a TICK
+// holding what reached its region the second before, waits for every
+// worker's DONE (the vehicles and link occupancy reports it sent across its
+// boundary, grouped by receiving region) and routes those into the next
+// TICK, so the coordinator is both the exchange and the tick barrier.
+// Vehicles cross as checkpoint records. Regions, turns and demand match ShardedSimulation exactly, so both
+// give the same counts for the same configuration.
+//
+// Workers are forked copies of the caller and see the intersections as they
+// were at the fork; the caller's own intersections are left untouched.
+// POSIX only.
+class PartitionedSimulation {
+private:
+    struct Worker {
+        int pid;
+        int socket;
+    };
+    
+    const ScenarioFile& scenario;
+    std::vector<std::unique_ptr<Intersection>>& intersections;
+    NetworkRunConfig config;
+    int workerCount;
+    std::unique_ptr<NetworkTopology> topology;
+    std::vector<Worker> workers;
+    
+    bool startWorkers(std::chrono::steady_clock::time_point origin);
+    void stopWorkers();
+    [[noreturn]] void serveRegion(uint32_t region, int socket, std::chrono::steady_clock::time_point origin);
+
+public:
+    PartitionedSimulation(const ScenarioFile& network, std::vector<std::unique_ptr<Intersection>>& nodes,
+                          const NetworkRunConfig& runConfig, const RouteTable* routes = nullptr);
+    ~PartitionedSimulation();
+    
+    NetworkRunResult run();
+};
\ No newline at end of file
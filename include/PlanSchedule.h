@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One fixed-time plan for an intersection's two-phase cycle
+struct TimingPlan {
+    std::string name;
+    std::array<uint16_t, 4> greenSeconds = {30, 30, 25, 25};   // Per Direction, as Intersection::configureTiming
+    std::array<uint16_t, 4> yellowSeconds = {5, 5, 5, 5};
+    int offset = -1;   // Seconds into the cycle phase 0's green starts, cycles counted from local midnight; -1: free
+};
+
+// A time-of-day entry: from startMinute on the given weekdays, plan runs
+// until the next entry takes over
+struct PlanPeriod {
+    uint8_t days = 0x7F;       // Bit per weekday, Sunday = bit 0 (as std::tm::tm_wday)
+    int startMinute = 0;       // After local midnight
+    uint16_t plan = 0;         // Index into the schedule's plans
+};
+
+// Weekly time-of-day / day-of-week plan schedule.
+//
+// compile() turns the periods into one sorted list of transitions over the
+// week (seconds since Sunday 00:00 local time, consecutive entries with the
+// same plan merged), so finding the plan in force is a binary search and the
+// next plan change is the following entry. Schedules are immutable once
+// compiled and shared between the intersections that use them.
+class PlanSchedule {
+public:
+    static constexpr int32_t WEEK_SECONDS = 7 * 24 * 3600;
+    
+    struct Transition {
+        int32_t weekSecond;
+        uint16_t plan;
+    };
+
+private:
+    std::vector<TimingPlan> plans;
+    std::vector<PlanPeriod> periods;
+    std::vector<Transition> transitions;
+
+public:
+    uint16_t addPlan(const TimingPlan& plan);
+    bool addPeriod(const PlanPeriod& period, std::string& error);
+    void compile();   // Later periods win where two start at the same second
+    
+    // The controller's default rush hours: base all day, base with a 40 s N/S green
+    // 07:00-10:00 and 17:00-20:00 every day
+    static PlanSchedule rushHours(const TimingPlan& base);
+    
+    // Index into getTransitions() of the one in force at a second of the week
+    size_t locate(int32_t weekSecond) const;
+    // Seconds from weekSecond until the next transition, at most a week
+    int32_t secondsUntilNext(int32_t weekSecond) const;
+    
+    // Getters
+    const TimingPlan& getPlan(size_t index) const;
+    size_t getPlanCount() const;
+    const std::vector<PlanPeriod>& getPeriods() const;
+    const std::vector<Transition>& getTransitions() const;
+    
+    void display() const;
+};
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "PlanSchedule.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <vector>
+
+class Intersection;
+
+struct PlanSchedulerStats {
+    uint64_t planChanges = 0;      // Plans applied at a boundary
+    uint64_t seekSteps = 0;        // Phases lengthened or shortened to reach a new offset
+    uint64_t offsetsReached = 0;
+    uint64_t clockReads = 0;       // Local time conversions, one per batch of due events
+};
+
+// Runs every intersection's plan schedule (Intersection::getPlanSchedule()).
+//
+// Nothing is evaluated between plan boundaries: each intersection has one
+// pending event in a min-heap, keyed by when its next transition falls due,
+// and advance() is a single comparison against the heap's top until then.
+// Local time is read only when an event is due.
+//
+// A new plan's timing is set through configureTiming, which takes effect at
+// the next phase change, so no running green or yellow is ever cut short. A
+// plan with an offset is then reached smoothly (shortway transition): at the
+// start of each phase the current green is shortened by up to 17% of the
+// cycle (never below half its planned green) or lengthened by up to 20%,
+// whichever direction reaches the target offset sooner, until the cycle
+// lines up with the offset.
+class PlanScheduler {
+public:
+    static constexpr int MAX_SHORTEN_PERCENT = 17;
+    static constexpr int MAX_LENGTHEN_PERCENT = 20;
+
+private:
+    enum class EventKind : uint8_t {
+        BOUNDARY,              // The schedule's next transition
+        SEEK                   // Next phase start while moving to the plan's offset
+    };
+    
+    struct Event {
+        std::chrono::steady_clock::time_point due;
+        uint32_t slot;
+        EventKind kind;
+        
+        bool operator>(const Event& other) const { return due > other.due; }
+    };
+    
+    struct SlotState {
+        const PlanSchedule* schedule = nullptr;   // As of the last event, to notice a replaced schedule
+        int32_t plan = -1;                        // Plan in force, -1 before the first boundary
+        bool seeking = false;
+    };
+    
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    std::vector<SlotState> slots;
+    PlanSchedulerStats stats;
+    
+    // Seconds until the next seek step, 0 once the offset is reached
+    int seekOffset(Intersection& intersection, const TimingPlan& plan, int32_t secondOfDay);
+
+public:
+    // Every scheduled intersection gets its plan in force applied at the first
+    // advance(); slot i is intersection i
+    void rebuild(const std::vector<std::unique_ptr<Intersection>>& intersections,
+                 std::chrono::steady_clock::time_point now);
+    void clear();
+    
+    // Applies what fell due by now; wallNow is only converted to local time when something did
+    void advance(std::vector<std::unique_ptr<Intersection>>& intersections, std::chrono::steady_clock::time_point now,
+                 std::chrono::system_clock::time_point wallNow);
+    
+    // Seconds since Sunday 00:00 local time
+    static int32_t weekSecond(std::chrono::system_clock::time_point wallNow);
+    
+    // Getters
+    size_t getPendingCount() const;
+    const PlanSchedulerStats& getStats() const;
+};
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+enum class SchedulingMode {
+    BEST_EFFORT,    // Work, then sleep a fixed interval (period drifts with work time)
+    REAL_TIME       // Absolute deadlines with overrun accounting
+};
+
+struct TickTimingStats {
+    uint64_t ticks = 0;
+    uint64_t missedDeadlines = 0;
+    uint64_t skippedPeriods = 0;     // Whole periods dropped to catch up after overruns
+    uint64_t shedTicks = 0;          // Ticks that skipped non-critical work
+    double periodMs = 0.0;
+    double lastWorkMs = 0.0;
+    double maxWorkMs = 0.0;
+    double totalWorkMs = 0.0;
+    double maxJitterMs = 0.0;        // Worst wake-up lateness against the release time
+    double totalJitterMs = 0.0;
+    
+    double getAverageWorkMs() const;
+    double getAverageJitterMs() const;
+};
+
+// Periodic release times for the control loop. Tick k is released at
+// start + k * period and must finish before tick k + 1 is released.
+class RealTimeScheduler {
+private:
+    std::chrono::steady_clock::duration period;
+    std::chrono::steady_clock::time_point nextRelease;
+    std::chrono::steady_clock::time_point tickStart;
+    std::chrono::steady_clock::time_point lastOverrunLog;
+    std::atomic<bool> sheddingEnabled;   // Set from the UI thread, read by the control thread
+    bool behind;                     // Last tick overran its deadline
+    TickTimingStats stats;
+
+public:
+    RealTimeScheduler();
+    
+    // Configuration
+    void setPeriod(std::chrono::steady_clock::duration newPeriod);
+    void setLoadShedding(bool enabled);
+    void reset(std::chrono::steady_clock::time_point now);
+    void rebase(std::chrono::steady_clock::time_point now);    // New release origin, stats kept
+    
+    // Per-tick protocol: wait until getNextRelease(), beginTick(), work, endTick()
+    std::chrono::steady_clock::time_point getNextRelease() const;
+    void beginTick(std::chrono::steady_clock::time_point wakeTime);
+    void endTick(std::chrono::steady_clock::time_point finishTime);
+    bool shouldShedWork() const;
+    
+    // Getters
+    std::chrono::steady_clock::duration getPeriod() const;
+    bool isLoadSheddingEnabled() const;
+    const TickTimingStats& getStats() const;
+};
\ No newline at end of file
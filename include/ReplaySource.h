@@ -0,0 +1,73 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "TrafficLight.h"
+#include "Vehicle.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ReplayRecord {
+    int64_t timestampMs;       // Detector time, milliseconds from any fixed origin
+    uint32_t intersection;     // Index into the controller's intersection list
+    Direction approach;
+    VehicleType vehicleType;
+};
+
+struct ReplayResult {
+    uint64_t arrivals = 0;
+    uint64_t malformedRecords = 0;
+    uint64_t skippedRecords = 0;     // Unknown intersection index
+    uint64_t outOfOrderRecords = 0;  // Earlier than the replay clock; applied at the current second
+    uint64_t departures = 0;
+    int64_t simulatedSeconds = 0;
+    double wallSeconds = 0.0;
+    
+    double getSpeedup() const;       // Simulated seconds per wall-clock second
+    double getRecordsPerSecond() const;
+};
+
+// Recorded detector data, memory-mapped and parsed in place.
+//
+// CSV: one record per line, "timestamp_ms,intersection,approach,vehicle_type".
+//   approach is 0-3 or a direction name/initial (N, SOUTH, ...); vehicle_type is
+//   0-7 or a type name (CAR, BUS, ...). Lines that don't start with a digit
+//   (headers, comments) are skipped; malformed lines are counted and skipped.
+// Binary: "TRFREPL1" | u32 version | u32 record size | u64 record count,
+//   followed by packed 16-byte records (i64 ms, u32 intersection, u8 approach,
+//   u8 type, u16 reserved).
+class ReplaySource {
+public:
+    enum class Format {
+        CSV,
+        BINARY
+    };
+
+private:
+    MappedFile file;
+    Format format;
+    const char* cursor;
+    const char* end;
+    uint64_t recordsRead;
+    uint64_t malformedRecords;
+    
+    bool nextCsv(ReplayRecord& record);
+    bool nextBinary(ReplayRecord& record);
+
+public:
+    ReplaySource();
+    
+    bool open(const std::string& path);
+    bool next(ReplayRecord& record);
+    void rewind();
+    
+    // Getters
+    Format getFormat() const;
+    size_t getSizeBytes() const;
+    double getProgress() const;          // Fraction of the file consumed
+    uint64_t getRecordsRead() const;
+    uint64_t getMalformedRecords() const;
+    
+    // Writes records in the binary format (e.g. to convert a CSV trace once)
+    static bool writeBinary(const std::string& path, const std::vector<ReplayRecord>& records);
+};
\ No newline at end of file
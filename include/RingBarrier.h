@@ -0,0 +1,109 @@
+#pragma once
+
+#include "Movement.h"
+#include <array>
+#include <cstdint>
+#include <string>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+// One NEMA phase: the movements it serves and its actuated timing
+struct NemaPhase {
+    MovementMask protectedMovements = 0;
+    MovementMask permittedMovements = 0;   // Served while yielding to the opposing approach
+    int minGreen = 5;                      // Seconds of green before the phase may gap out
+    int maxGreen = 30;
+    int yellow = 4;
+    int redClearance = 1;
+    
+    MovementMask served() const {
+        return protectedMovements | permittedMovements;
+    }
+};
+
+// Dual-ring, two-barrier phase plan using NEMA phase numbers 1-8. Each ring
+// runs its phases in sequence; the rings only cross a barrier together, so a
+// phase times concurrently with whatever the other ring runs in the same
+// barrier group. validate() checks every such pairing against the movement
+// conflict matrix.
+class RingBarrierPlan {
+public:
+    static const int PHASES = 8;
+    static const int RINGS = 2;
+    static const int GROUPS = 2;           // Barrier groups: main street, then side street
+    static const int GROUP_SLOTS = 2;      // Phases per ring within a group
+
+private:
+    std::array<NemaPhase, PHASES> phases;  // Phase n at index n - 1
+    std::array<std::array<std::array<uint8_t, GROUP_SLOTS>, GROUPS>, RINGS> sequence;  // 0 = empty slot
+
+public:
+    RingBarrierPlan();
+    
+    // Standard eight-phase plan with protected lefts: N/S main street in group 0
+    // (1 = S-L, 2 = N-T/R, 5 = N-L, 6 = S-T/R), E/W side street in group 1
+    // (3 = W-L, 4 = E-T/R, 7 = E-L, 8 = W-T/R)
+    static RingBarrierPlan standardEightPhase(int throughMaxGreen = 30, int leftMaxGreen = 15);
+    // The classic two-phase cycle: each approach in one phase, lefts permitted
+    static RingBarrierPlan twoPhasePermitted(int maxGreen = 30);
+    
+    void setPhase(int number, const NemaPhase& phase);
+    const NemaPhase& getPhase(int number) const;
+    void setSequence(int ring, int group, uint8_t first, uint8_t second = 0);
+    uint8_t getSequence(int ring, int group, int slot) const;
+    MovementMask servedMovements() const;
+    
+    bool validate(std::string& error) const;
+    void display() const;
+    
+    // Checkpointing
+    void writeCheckpoint(CheckpointWriter& out) const;
+    void readCheckpoint(CheckpointReader& in);
+};
+
+enum class RingInterval : uint8_t {
+    GREEN,
+    YELLOW,
+    RED_CLEARANCE,
+    BARRIER         // Done with this group, waiting for the other ring
+};
+
+// Actuated run-time state of a validated plan. A phase holds green for its
+// minimum, then gaps out as soon as none of its movements has a vehicle
+// waiting, or maxes out; yellow and red clearance follow. Both rings start
+// the next barrier group together.
+class RingBarrierState {
+private:
+    RingBarrierPlan plan;
+    int barrierGroup;
+    std::array<uint8_t, RingBarrierPlan::RINGS> slot;
+    std::array<RingInterval, RingBarrierPlan::RINGS> interval;
+    std::array<int, RingBarrierPlan::RINGS> timer;
+    
+    void startGroup(int group);
+    void startSlot(int ring, int position);
+
+public:
+    RingBarrierState();
+    explicit RingBarrierState(const RingBarrierPlan& validatedPlan);
+    
+    // One second. demand holds the movements with queued vehicles. Returns
+    // true when the barrier was crossed.
+    bool step(MovementMask demand);
+    void restart();
+    
+    // Getters
+    const RingBarrierPlan& getPlan() const;
+    int getBarrierGroup() const;
+    int getActivePhase(int ring) const;         // NEMA number, 0 when waiting at the barrier
+    RingInterval getInterval(int ring) const;
+    int getIntervalTimer(int ring) const;
+    MovementMask getProtectedGreen() const;
+    MovementMask getPermittedGreen() const;
+    MovementMask getYellow() const;
+    
+    // Checkpointing
+    void writeCheckpoint(CheckpointWriter& out) const;
+    void readCheckpoint(CheckpointReader& in);
+};
\ No newline at end of file
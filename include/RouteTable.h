@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Scenario.h"
+#include "Vehicle.h"
+#include <cstdint>
+#include <vector>
+
+// One re-routing pass of an iterative assignment
+struct ReassignResult {
+    double relativeGap = 0.0;       // Demand-weighted excess of current over shortest route times, before the pass
+    uint32_t improvablePairs = 0;   // OD pairs whose route was not the shortest
+    uint32_t reroutedPairs = 0;     // ... of which were moved onto it
+    double milliseconds = 0.0;
+};
+
+// Shortest routes for a scenario's origin-destination trips, computed once
+// per OD pair when the scenario loads and stored back to back as link
+// indices. A vehicle on a trip carries only its route id and a cursor, so
+// following a route costs one array read per intersection.
+//
+// Paths are shortest in travel time over the links (free-flow on load,
+// measured ones when re-assigned), searched link by link so they never ask
+// for a U-turn and only enter intersections on a signalled approach. One
+// search per origin serves every destination of that origin; origins are
+// searched in parallel.
+class RouteTable {
+private:
+    std::vector<uint64_t> pairs;        // Routable OD pairs, origin << 32 | destination, sorted; route id = index
+    std::vector<double> pairDemand;     // Per route, trips per hour of all trips on that pair
+    std::vector<uint32_t> routeBegin;   // Per route, into routeLinks, plus one past the last
+    std::vector<uint32_t> routeLinks;   // Scenario link indices (position from outgoingBegin(0))
+    std::vector<uint32_t> tripRoute;    // Per scenario trip, Vehicle::NO_ROUTE when unroutable
+    uint32_t unroutable;                // Trips with no path, or starting where they end
+    double buildMilliseconds;
+
+public:
+    RouteTable();
+    
+    // Routes every trip of the scenario at free-flow; threads 0 uses one per hardware thread
+    void build(const ScenarioFile& scenario, int threads = 0);
+    void clear();
+    
+    // Searches every pair again against linkSeconds (one per scenario link)
+    // and moves each pair that has a faster route onto it with probability
+    // fraction, hashed from the pair and iteration. Route ids are unchanged.
+    ReassignResult reassign(const ScenarioFile& scenario, const std::vector<uint32_t>& linkSeconds, double fraction,
+                            uint32_t iteration, int threads = 0);
+    
+    uint32_t findRoute(uint32_t origin, uint32_t destination) const;  // Vehicle::NO_ROUTE if none
+    static uint32_t getFreeFlowSeconds(const ScenarioLink& link);
+    
+    // Getters
+    uint32_t getRouteCount() const { return static_cast<uint32_t>(pairs.size()); }
+    uint32_t getTripRoute(uint32_t trip) const { return trip < tripRoute.size() ? tripRoute[trip] : Vehicle::NO_ROUTE; }
+    uint32_t getLength(uint32_t route) const { return routeBegin[route + 1] - routeBegin[route]; }
+    uint32_t getLink(uint32_t route, uint32_t cursor) const { return routeLinks[routeBegin[route] + cursor]; }
+    size_t getStoredLinkCount() const { return routeLinks.size(); }
+    uint32_t getUnroutableCount() const { return unroutable; }
+    double getBuildMilliseconds() const { return buildMilliseconds; }
+};
\ No newline at end of file
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "TrafficLight.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// On-disk records. They are read straight out of the mapping, so every field is
+// fixed-width, 4-byte aligned and little-endian.
+struct ScenarioNode {
+    uint32_t nameOffset;       // Into the string table
+    uint32_t nameLength;
+    float x;                   // Metres, any planar projection
+    float y;
+    uint32_t planIndex;        // Into the phase plans
+    uint32_t demandProfile;    // Into the demand profiles, NO_PROFILE if none
+    uint8_t approachMask;      // Bit per Direction with a signal head and detector
+    uint8_t reserved[3];
+};
+
+struct ScenarioLink {
+    uint32_t from;             // Node indices
+    uint32_t to;
+    uint8_t heading;           // Direction of travel; vehicles join this queue at 'to'
+    uint8_t lanes;
+    uint16_t reserved;
+    float lengthMeters;
+    float freeFlowSpeed;       // Metres per second
+    float capacity;            // Vehicles per hour
+};
+
+struct ScenarioPhasePlan {
+    uint16_t greenSeconds[4];  // Per Direction, as Intersection::configureTiming
+    uint16_t yellowSeconds[4];
+};
+
+struct ScenarioTrip {
+    uint32_t origin;           // Node indices
+    uint32_t destination;
+    float tripsPerHour;
+    uint32_t reserved;
+};
+
+struct ScenarioDemandProfile {
+    uint32_t firstRate;        // Into the rate table; slot s, approach a is firstRate + s * 4 + a
+    uint32_t slotCount;
+    uint32_t slotSeconds;      // Profile wraps after slotCount * slotSeconds
+    uint32_t reserved;
+};
+
+// Versioned binary scenario (network topology, approaches, phase plans,
+// demand profiles and origin-destination trips), memory-mapped and used in place.
+//
+// File: "TRFSCEN1" | u32 version | u32 section count | section table of
+//   {u32 id, u32 element size, u64 offset, u64 byte size} | sections, each
+//   8-byte aligned. Links are sorted by origin node and the LINK_INDEX section
+//   holds nodeCount + 1 offsets into them, so a node's outgoing links are a
+//   contiguous range.
+class ScenarioFile {
+public:
+    static const uint32_t NO_PROFILE = 0xFFFFFFFFu;
+    
+    enum class Section : uint32_t {
+        NODES = 1,
+        LINKS = 2,
+        LINK_INDEX = 3,
+        PLANS = 4,
+        DEMAND_PROFILES = 5,
+        DEMAND_RATES = 6,
+        STRINGS = 7,
+        TRIPS = 8                  // Optional: scenarios without one have no OD demand
+    };
+
+private:
+    MappedFile file;
+    const ScenarioNode* nodes;
+    uint32_t nodeCount;
+    const ScenarioLink* links;
+    uint32_t linkCount;
+    const uint32_t* linkIndex;
+    const ScenarioPhasePlan* plans;
+    uint32_t planCount;
+    const ScenarioDemandProfile* profiles;
+    uint32_t profileCount;
+    const float* demandRates;
+    uint32_t rateCount;
+    const char* strings;
+    uint32_t stringBytes;
+    const ScenarioTrip* trips;
+    uint32_t tripCount;
+    
+    bool validate(const std::string& path) const;
+
+public:
+    ScenarioFile();
+    ScenarioFile(const ScenarioFile&) = delete;
+    ScenarioFile& operator=(const ScenarioFile&) = delete;
+    
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+    
+    // Getters
+    uint32_t getNodeCount() const;
+    uint32_t getLinkCount() const;
+    uint32_t getPlanCount() const;
+    uint32_t getTripCount() const;
+    const ScenarioNode& getNode(uint32_t index) const;
+    std::string_view getNodeName(uint32_t index) const;
+    const ScenarioPhasePlan& getPlan(uint32_t index) const;
+    const ScenarioTrip& getTrip(uint32_t index) const;
+    const ScenarioLink* outgoingBegin(uint32_t node) const;
+    const ScenarioLink* outgoingEnd(uint32_t node) const;
+    
+    // Vehicles per hour on one approach of a node at a time of day, 0 without a profile
+    double getDemandPerHour(uint32_t node, Direction approach, int64_t secondOfDay) const;
+    
+    // Vehicles a link holds at jam density (7.5 m each, per lane), at least one
+    static uint32_t getStorageVehicles(const ScenarioLink& link);
+};
+
+// Assembles a scenario in memory and writes it in the ScenarioFile format
+class ScenarioBuilder {
+private:
+    std::vector<ScenarioNode> nodes;
+    std::vector<ScenarioLink> links;
+    std::vector<ScenarioPhasePlan> plans;
+    std::vector<ScenarioDemandProfile> profiles;
+    std::vector<float> demandRates;
+    std::vector<ScenarioTrip> trips;
+    std::string strings;
+
+public:
+    uint32_t addPlan(const ScenarioPhasePlan& plan);
+    uint32_t addDemandProfile(uint32_t slotSeconds, const std::vector<float>& ratesPerHour);  // 4 per slot
+    uint32_t addNode(const std::string& name, float x, float y, uint8_t approachMask, uint32_t plan,
+                     uint32_t demandProfile = ScenarioFile::NO_PROFILE);
+    void addLink(uint32_t from, uint32_t to, Direction heading, float lengthMeters,
+                 float freeFlowSpeed = 13.9f, uint8_t lanes = 1, float capacity = 1800.0f);
+    void addTrip(uint32_t origin, uint32_t destination, float tripsPerHour);
+    
+    size_t getNodeCount() const;
+    bool write(const std::string& path) const;
+};
\ No newline at end of file
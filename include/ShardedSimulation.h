@@ -0,0 +1,41 @@
+#pragma once
+
+#include "NetworkRegion.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+// Runs a scenario network with vehicles moving between intersections, split
+// over worker threads by region.
+//
+// The network is cut into contiguous regions by recursive coordinate
+// bisection, one NetworkRegion per worker. A worker owns its intersections
+// and the links that end in its region, and copies its intersections when it
+// starts so their memory is first touched on its own NUMA node. Transfers and
+// occupancy reports to a neighbouring region go into per-receiver exchange
+// buffers that are double-buffered by second parity, so a single barrier per second both
+// publishes them and frees the pair written the second before. Nothing else
+// is shared between workers.
+class ShardedSimulation {
+private:
+    struct Shard;
+    class SpinBarrier;
+    
+    const ScenarioFile& scenario;
+    std::vector<std::unique_ptr<Intersection>>& intersections;
+    NetworkRunConfig config;
+    int workerCount;
+    std::unique_ptr<NetworkTopology> topology;    // Read-only during the run
+    std::vector<std::unique_ptr<Shard>> shards;   // Built by their own workers
+    
+    void runWorker(int worker, SpinBarrier& barrier, std::chrono::steady_clock::time_point origin);
+    void buildShard(int worker);
+    void drainExchange(Shard& shard, int parity);
+
+public:
+    ShardedSimulation(const ScenarioFile& network, std::vector<std::unique_ptr<Intersection>>& nodes,
+                      const NetworkRunConfig& runConfig, const RouteTable* routes = nullptr);
+    ~ShardedSimulation();
+    
+    NetworkRunResult run();
+};
\ No newline at end of file
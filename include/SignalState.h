@@ -0,0 +1,90 @@
+#pragma once
+
+#include "TrafficLight.h"
+#include <cstdint>
+
+// An intersection's complete signal indication in one integer. There is a
+// 4-bit plane per TrafficState; bit i of a plane is set when the approach with
+// Direction value i shows that state. Approaches without a signal head have no
+// bit in any plane. Phase changes and proceed checks are plain bit operations.
+class SignalState {
+public:
+    static const int STATE_COUNT = 5;
+    static const uint32_t PLANE_REPEAT = 0x11111u;   // One bit per plane, for broadcasting a mask
+
+private:
+    uint32_t bits;
+    
+    static constexpr int shift(TrafficState state) {
+        return static_cast<int>(state) * 4;
+    }
+
+public:
+    constexpr SignalState() : bits(0) {}
+    explicit constexpr SignalState(uint32_t raw) : bits(raw) {}
+    
+    uint32_t raw() const { return bits; }
+    
+    // Approaches showing a state, as a Direction bitmask
+    uint8_t mask(TrafficState state) const {
+        return static_cast<uint8_t>((bits >> shift(state)) & 0xFu);
+    }
+    
+    // Approaches that have a signal head at all
+    uint8_t present() const {
+        uint32_t folded = bits | (bits >> 4) | (bits >> 8) | (bits >> 12) | (bits >> 16);
+        return static_cast<uint8_t>(folded & 0xFu);
+    }
+    
+    uint8_t proceedMask() const {
+        return mask(TrafficState::GREEN);
+    }
+    
+    bool canProceed(Direction dir) const {
+        return (bits >> (shift(TrafficState::GREEN) + static_cast<int>(dir))) & 1u;
+    }
+    
+    bool has(Direction dir) const {
+        return (present() >> static_cast<int>(dir)) & 1u;
+    }
+    
+    TrafficState get(Direction dir) const {
+        uint32_t column = (bits >> static_cast<int>(dir)) & PLANE_REPEAT;
+        for (int state = 0; state < STATE_COUNT; ++state) {
+            if (column & (1u << (state * 4))) {
+                return static_cast<TrafficState>(state);
+            }
+        }
+        return TrafficState::RED;
+    }
+    
+    // Puts the given approaches in one state, whatever they showed before
+    void set(uint8_t approaches, TrafficState state) {
+        bits &= ~(approaches * PLANE_REPEAT);
+        bits |= static_cast<uint32_t>(approaches) << shift(state);
+    }
+    
+    void set(Direction dir, TrafficState state) {
+        set(static_cast<uint8_t>(1u << static_cast<int>(dir)), state);
+    }
+    
+    // Green for the given approaches, red for every other approach present
+    void setPhase(uint8_t green) {
+        uint8_t all = present();
+        bits = (static_cast<uint32_t>(green & all) << shift(TrafficState::GREEN)) |
+               (static_cast<uint32_t>(all & ~green) << shift(TrafficState::RED));
+    }
+    
+    // Every green approach turns yellow
+    void greenToYellow() {
+        uint32_t green = mask(TrafficState::GREEN);
+        bits = (bits & ~(0xFu << shift(TrafficState::GREEN))) | (green << shift(TrafficState::YELLOW));
+    }
+    
+    // Approaches whose indication differs between two states
+    uint8_t changedFrom(SignalState other) const {
+        uint32_t diff = bits ^ other.bits;
+        uint32_t folded = diff | (diff >> 4) | (diff >> 8) | (diff >> 12) | (diff >> 16);
+        return static_cast<uint8_t>(folded & 0xFu);
+    }
+};
\ No newline at end of file
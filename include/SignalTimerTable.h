@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Once-a-second timers of every intersection in a network, stored column-wise
+// so the countdown is one pass over contiguous arrays instead of a walk over
+// Intersection objects. Slot i belongs to intersection i.
+//
+// advance() moves every slot one second forward: the phase timer goes up and
+// each approach's indication countdown goes down (stopping at zero). It reports
+// the slots that need their intersection's attention: the phase timer reached
+// the next scheduled signal change, or a sensor interval has closed. The kernel
+// is AVX2 when the CPU has it and a scalar loop otherwise; both produce
+// identical results.
+class SignalTimerTable {
+public:
+    enum class Kernel {
+        SCALAR,
+        AVX2
+    };
+    
+    static constexpr int32_t NO_EVENT = INT32_MAX;  // Slot is held (emergency preemption) and never due
+
+private:
+    std::vector<int32_t> phaseTimers;
+    std::vector<int32_t> nextEvents;   // Phase timer value at which the slot is due
+    std::vector<int64_t> sensorRolls;  // Steady-clock nanoseconds at which the slot is due
+    std::vector<int16_t> timeLeft;     // Four per slot, in Direction order
+    std::vector<uint32_t> dueSlots;
+    Kernel kernel;
+
+public:
+    SignalTimerTable();
+    
+    void resize(size_t slots);
+    size_t size() const;
+    
+    int32_t& phaseTimer(uint32_t slot) { return phaseTimers[slot]; }
+    int32_t& nextEvent(uint32_t slot) { return nextEvents[slot]; }
+    int64_t& sensorRollAt(uint32_t slot) { return sensorRolls[slot]; }
+    int16_t& approachTimeLeft(uint32_t slot, int dir) { return timeLeft[slot * 4 + dir]; }
+    
+    // One second for every slot, ending at now; returns the due slots in
+    // ascending order. The list is reused, so it is valid until the next call.
+    const std::vector<uint32_t>& advance(std::chrono::steady_clock::time_point now);
+    
+    static int64_t toTicks(std::chrono::steady_clock::time_point time);
+    
+    // Kernel selection (defaults to the fastest supported one)
+    Kernel getKernel() const;
+    bool setKernel(Kernel requested);  // False if the CPU can't run it
+    static bool isSupported(Kernel kernel);
+    static const char* getKernelName(Kernel kernel);
+};
+
+// One intersection's view of its timers: a slot of a shared table once
+// attached, local storage otherwise. Copies are always detached, so a copied
+// Intersection never writes into the original's table.
+class SignalTimerSlot {
+private:
+    SignalTimerTable* table;
+    uint32_t slot;
+    int32_t localPhaseTimer;
+    int32_t localNextEvent;
+    int64_t localSensorRollAt;
+    std::array<int16_t, 4> localTimeLeft;
+
+public:
+    SignalTimerSlot()
+        : table(nullptr), slot(0), localPhaseTimer(0), localNextEvent(SignalTimerTable::NO_EVENT), localSensorRollAt(0) {
+        localTimeLeft.fill(0);
+    }
+    
+    SignalTimerSlot(const SignalTimerSlot& other) : SignalTimerSlot() {
+        *this = other;
+    }
+    
+    SignalTimerSlot& operator=(const SignalTimerSlot& other) {
+        if (this != &other) {
+            localPhaseTimer = other.phaseTimer();
+            localNextEvent = other.nextEvent();
+            localSensorRollAt = other.sensorRollAt();
+            for (int dir = 0; dir < 4; ++dir) {
+                localTimeLeft[dir] = other.timeLeft(dir);
+            }
+            table = nullptr;
+        }
+        return *this;
+    }
+    
+    // Moves the current values into target's slot; nullptr moves them back to local storage
+    void attach(SignalTimerTable* target, uint32_t targetSlot) {
+        SignalTimerSlot values(*this);
+        table = target;
+        slot = targetSlot;
+        phaseTimer() = values.localPhaseTimer;
+        nextEvent() = values.localNextEvent;
+        sensorRollAt() = values.localSensorRollAt;
+        for (int dir = 0; dir < 4; ++dir) {
+            timeLeft(dir) = values.localTimeLeft[dir];
+        }
+    }
+    
+    int32_t& phaseTimer() { return table ? table->phaseTimer(slot) : localPhaseTimer; }
+    int32_t phaseTimer() const { return table ? table->phaseTimer(slot) : localPhaseTimer; }
+    int32_t& nextEvent() { return table ? table->nextEvent(slot) : localNextEvent; }
+    int32_t nextEvent() const { return table ? table->nextEvent(slot) : localNextEvent; }
+    int64_t& sensorRollAt() { return table ? table->sensorRollAt(slot) : localSensorRollAt; }
+    int64_t sensorRollAt() const { return table ? table->sensorRollAt(slot) : localSensorRollAt; }
+    int16_t& timeLeft(int dir) { return table ? table->approachTimeLeft(slot, dir) : localTimeLeft[dir]; }
+    int16_t timeLeft(int dir) const { return table ? table->approachTimeLeft(slot, dir) : localTimeLeft[dir]; }
+};
\ No newline at end of file
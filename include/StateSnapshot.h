@@ -0,0 +1,107 @@
+#pragma once
+
+#include "TrafficLight.h"
+#include "TrafficStats.h"
+#include "RealTimeScheduler.h"
+#include "LookaheadController.h"
+#include "CongestionIndex.h"
+#include <atomic>
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <ostream>
+
+struct LightSnapshot {
+    Direction direction;
+    TrafficState state;
+    int timeLeft;
+};
+
+struct IntersectionSnapshot {
+    std::string id;
+    bool emergencyMode = false;
+    int currentPhase = 0;
+    std::vector<LightSnapshot> lights;
+    std::array<int, 4> queueLengths = {0, 0, 0, 0};   // NORTH, SOUTH, EAST, WEST
+    double averageWaitTime = 0.0;
+    
+    int getTotalVehicleCount() const;
+    void display() const;
+};
+
+// One place in a congestion ranking
+struct CongestionRank {
+    std::string id;         // Intersection
+    int approach = -1;      // Direction, for CongestionMetric::APPROACH_QUEUE
+    double value = 0.0;     // In the metric's unit
+};
+
+// Immutable view of the whole system as of the end of one controller tick
+struct SystemSnapshot {
+    uint64_t epoch = 0;
+    bool running = false;
+    bool emergencyActive = false;
+    int simulationSpeed = 1;
+    bool realTimeMode = true;
+    SchedulingMode schedulingMode = SchedulingMode::BEST_EFFORT;
+    TickTimingStats timing;
+    ControlStrategy controlStrategy = ControlStrategy::FIXED_TIME;
+    uint64_t lookaheadDecisions = 0;
+    double lookaheadAverageMs = 0.0;
+    bool idleSkipping = true;
+    size_t activeIntersections = 0;       // With queued vehicles, as of the end of the tick
+    int64_t queuedVehicles = 0;           // Network-wide
+    double meanLoad = 0.0;                // Queued vehicles per intersection
+    std::array<std::vector<CongestionRank>, 4> worst;   // By CongestionMetric, worst first, up to RANKED each
+    std::vector<IntersectionSnapshot> intersections;
+    TrafficStats statistics;
+    
+    static constexpr size_t RANKED = 10;
+    
+    void display() const;
+    void displayCongestion(std::ostream& out, size_t count) const;   // The worst count of each ranking
+};
+
+// Double-buffered snapshot publication with a single writer (the controller
+// thread) and any number of readers. Readers pin the front buffer with a
+// per-buffer reader count; the writer only fills the back buffer when nobody
+// is pinning it and otherwise skips that tick's publication, so neither side
+// ever waits on the other.
+class SnapshotBuffer {
+private:
+    SystemSnapshot buffers[2];
+    std::atomic<int> front;
+    mutable std::atomic<int> readers[2];
+    std::atomic<uint64_t> epoch;
+    std::atomic<uint64_t> skippedPublications;
+
+public:
+    class ReadGuard {
+    private:
+        const SnapshotBuffer* owner;
+        int index;
+    
+    public:
+        ReadGuard(const SnapshotBuffer* buffer, int slot);
+        ReadGuard(ReadGuard&& other) noexcept;
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ~ReadGuard();
+        
+        const SystemSnapshot& operator*() const;
+        const SystemSnapshot* operator->() const;
+    };
+    
+    SnapshotBuffer();
+    
+    // Writer side: fill the returned buffer, then publish it
+    SystemSnapshot* beginWrite();
+    void publish();
+    
+    // Reader side
+    ReadGuard read() const;
+    SystemSnapshot copy() const;
+    uint64_t getEpoch() const;
+    uint64_t getSkippedPublications() const;
+};
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Compile-time switch for stage-level trace points. Configure with
+// -DENABLE_TRACING=OFF (or define TRAFFIC_TRACING=0) and every
+// TRAFFIC_TRACE_* macro expands to nothing.
+#ifndef TRAFFIC_TRACING
+#define TRAFFIC_TRACING 1
+#endif
+
+struct TraceEvent {
+    const char* name;          // Must be a string literal (stored, never copied)
+    int64_t startNs;
+    int64_t durationNs;
+};
+
+// Fixed-size ring owned by exactly one thread; old events are overwritten
+class TraceBuffer {
+public:
+    static const size_t CAPACITY = 1 << 16;
+
+private:
+    std::array<TraceEvent, CAPACITY> events;
+    std::atomic<uint64_t> written;
+    uint32_t threadId;
+    std::string threadName;
+
+public:
+    explicit TraceBuffer(uint32_t id);
+    
+    void append(const char* name, int64_t startNs, int64_t durationNs);
+    void setThreadName(const std::string& name);
+    void clear();
+    void reassign(uint32_t id);   // Empty again, for a new thread
+    
+    uint32_t getThreadId() const;
+    const std::string& getThreadName() const;
+    std::vector<TraceEvent> collect() const;
+};
+
+// Rings outlive their threads so a dump still shows short-lived workers.
+// A thread's ring is retired when it exits and handed to the next new
+// thread once it has been written out (or cleared); past MAX_BUFFERS the
+// oldest retired ring is reused even unwritten, so repeated worker pools
+// never grow the profiler without bound.
+class TraceProfiler {
+public:
+    static const size_t MAX_BUFFERS = 64;
+
+private:
+    struct Retired {
+        TraceBuffer* buffer;
+        bool flushed;              // Its events are in a dump already
+    };
+    
+    std::atomic<bool> enabled;
+    mutable std::mutex registryMutex;    // Only taken when a thread first traces or exits, or on dump
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    mutable std::vector<Retired> retired;   // Oldest first
+    uint32_t nextThreadId;
+    
+    TraceProfiler();
+    TraceBuffer& localBuffer();
+    TraceBuffer* acquireBuffer();
+    void retireBuffer(TraceBuffer* buffer);
+
+public:
+    static TraceProfiler& instance();
+    static int64_t nowNs();
+    
+    // Control
+    void setEnabled(bool on);
+    bool isEnabled() const;
+    void clear();
+    
+    // Recording (called from the traced thread)
+    void record(const char* name, int64_t startNs, int64_t durationNs);
+    void setThreadName(const std::string& name);
+    
+    // Chrome trace-event JSON (load in chrome://tracing or Perfetto).
+    // Dump while the traced threads are stopped or paused for a clean capture.
+    bool writeChromeTrace(const std::string& filename) const;
+    size_t getEventCount() const;
+};
+
+// Times the enclosing scope into the calling thread's ring
+class ScopedTrace {
+private:
+    const char* name;
+    int64_t start;
+
+public:
+    explicit ScopedTrace(const char* scopeName);
+    ~ScopedTrace();
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+};
+
+#if TRAFFIC_TRACING
+#define TRAFFIC_TRACE_CONCAT_INNER(a, b) a##b
+#define TRAFFIC_TRACE_CONCAT(a, b) TRAFFIC_TRACE_CONCAT_INNER(a, b)
+#define TRAFFIC_TRACE_SCOPE(name) ScopedTrace TRAFFIC_TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define TRAFFIC_TRACE_THREAD(name) TraceProfiler::instance().setThreadName(name)
+#else
+#define TRAFFIC_TRACE_SCOPE(name) ((void)0)
+#define TRAFFIC_TRACE_THREAD(name) ((void)0)
+#endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "NetworkRegion.h"
+#include <memory>
+#include <vector>
+
+struct AssignmentConfig {
+    int iterations = 20;
+    double gapTarget = 0.02;        // Stop once the relative gap is below this
+    double rerouteFraction = 0.0;   // Share of improvable OD pairs moved per iteration; 0: 1 / (k + 2)
+    NetworkRunConfig run;           // Every iteration's simulation
+};
+
+struct AssignmentIteration {
+    int iteration = 0;
+    double relativeGap = 0.0;       // Of the routes this iteration simulated
+    uint32_t improvablePairs = 0;
+    uint32_t reroutedPairs = 0;
+    uint64_t tripsStarted = 0;
+    uint64_t tripsCompleted = 0;
+    double averageTimeInNetwork = 0.0;
+    double simulateSeconds = 0.0;   // Wall-clock time of the network run
+    double rerouteSeconds = 0.0;    // ... and of re-routing every OD pair
+};
+
+struct AssignmentResult {
+    std::vector<AssignmentIteration> iterations;
+    bool converged = false;
+    double wallSeconds = 0.0;
+};
+
+// Iterative dynamic traffic assignment over a scenario's OD trips. Each
+// iteration simulates the network from the same starting state with the
+// current routes (ShardedSimulation), gathers every link's experienced
+// travel time in a TrafficStats (averaged over iterations; unused links are
+// charged free-flow plus the mean delay), then searches all OD pairs again
+// against those times and moves a share of the pairs that have a faster route onto
+// it. By default the share shrinks as 1 / (k + 2), the method of successive
+// averages. It stops once the demand-weighted relative gap between current
+// and shortest route times falls below the target.
+//
+// The intersections are put back as they were when it finishes; the route
+// table keeps the last routes.
+class TrafficAssignment {
+private:
+    const ScenarioFile& scenario;
+    std::vector<std::unique_ptr<Intersection>>& intersections;
+    RouteTable& routes;
+    AssignmentConfig config;
+
+public:
+    TrafficAssignment(const ScenarioFile& network, std::vector<std::unique_ptr<Intersection>>& nodes,
+                      RouteTable& tripRoutes, const AssignmentConfig& assignmentConfig);
+    
+    AssignmentResult run();
+};
\ No newline at end of file
@@ -2,11 +2,27 @@
 
 #include "Intersection.h"
 #include "TrafficStats.h"
+#include "StateSnapshot.h"
+#include "RealTimeScheduler.h"
+#include "ReplaySource.h"
+#include "Checkpoint.h"
+#include "LookaheadController.h"
+#include "Scenario.h"
+#include "RouteTable.h"
+#include "ShardedSimulation.h"
+#include "PartitionedSimulation.h"
+#include "TrafficAssignment.h"
+#include "LaneSimulation.h"
+#include "CorridorCoordinator.h"
+#include "PlanScheduler.h"
 #include <vector>
 #include <queue>
 #include <thread>
 #include <atomic>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <random>
 
 class TrafficController {
 private:
@@ -19,20 +35,108 @@ private:
     // System configuration
     int simulationSpeed;       // Simulation speed multiplier
     bool realTimeMode;         // Real-time vs accelerated simulation
+    SchedulingMode schedulingMode;
+    RealTimeScheduler scheduler;
+    std::atomic<ControlStrategy> controlStrategy;
+    LookaheadController lookahead;       // Used by the controller thread only
     std::chrono::steady_clock::time_point systemStartTime;
     
     // Threading
     std::thread controllerThread;
     std::thread simulationThread;
+    
+    // Wakeup primitive shared by both control threads. Guards paused, threadsActive,
+    // pendingArrivals and pendingDetections; running is also flipped under it so
+    // waits can't miss stop().
+    struct PendingArrival {
+        size_t intersection;
+        Vehicle vehicle;
+    };
+    mutable std::mutex controlMutex;
+    std::condition_variable controlWakeup;
+    bool paused;
+    bool threadsActive;        // Arrivals must go through the inbox while true
+    std::vector<PendingArrival> pendingArrivals;
+    std::vector<PendingArrival> arrivalBatch;      // Controller-thread side of the inbox
+    std::vector<DetectionEvent> pendingDetections; // Detector batches, through the same inbox
+    std::vector<DetectionEvent> detectionBatch;
+    
+    // Scratch space reused by batch detection ingestion
+    std::vector<DetectionEvent> ingestBuffer;
+    std::vector<size_t> ingestOffsets;
+    std::vector<size_t> ingestCursor;
+    
+    // Consistent views for readers, republished at the end of every tick
+    SnapshotBuffer snapshots;
+    
+    // Binary vehicle/signal event log. Every intersection holds a pointer to it
+    // for its whole life; appends are no-ops while the log is closed.
+    EventLog eventLog;
+    
+    // Phase timers and signal countdowns of every intersection, slot i for
+    // intersection i, so each second of signal time is one batch pass
+    SignalTimerTable signalTimers;
+    std::chrono::steady_clock::time_point lastSignalStep;
+    
+    // Time-of-day plan changes, driven from the controller thread once a
+    // second; new intersections start on the shared rush-hour schedule
+    PlanScheduler planScheduler;
+    std::shared_ptr<const PlanSchedule> defaultSchedule;
+    
+    // Intersections with queued vehicles. Ticks only visit these; idle ones
+    // come back when a vehicle queues, and their signal changes still happen
+    // on time through signalTimers.
+    ActiveSet activeIntersections;
+    std::atomic<bool> idleSkipping;
+    
+    // Queued vehicles per approach, per intersection and network-wide, kept
+    // as deltas by the intersections. Optimization reads these; it runs on the
+    // controller thread, which owns the queues, when the simulation thread
+    // asks for it.
+    NetworkLoad networkLoad;
+    std::atomic<bool> rebalanceRequested;
+    
+    // Loaded scenario, kept mapped for topology and demand lookups. Node i is
+    // intersection i; closed when intersections are removed or reset.
+    ScenarioFile scenario;
+    RouteTable routes;                 // Its OD trips' shortest routes, built on load
+    
+    // Random traffic generation; locked because checkpoint capture reads it too
+    std::mutex rngMutex;
+    std::mt19937 rng;
+    int vehicleCounter;
+    
+    // Checkpoints are captured between ticks and written by a background thread
+    std::atomic<bool> checkpointRequested;
+    std::string pendingCheckpoint;     // Guarded by controlMutex
+    std::mutex checkpointMutex;        // Guards checkpointWriter
+    std::thread checkpointWriter;
+    std::atomic<bool> checkpointWriting;
 
 public:
     TrafficController();
     ~TrafficController();
     
     // Intersection management
-    void addIntersection(const std::string& id);
+    // Both refuse while running: timer slots, the active set and the load
+    // aggregates are resized under the controller thread otherwise
+    bool addIntersection(const std::string& id);
     Intersection* getIntersection(const std::string& id);
-    void removeIntersection(const std::string& id);
+    bool removeIntersection(const std::string& id);
+    int getIntersectionIndex(const std::string& id) const;
+    bool loadScenario(const std::string& filename);
+    const ScenarioFile& getScenario() const;
+    const RouteTable& getRoutes() const;
+    bool setRingBarrierPlan(const std::string& id, const RingBarrierPlan& plan);  // While stopped
+    bool clearRingBarrierPlan(const std::string& id);
+    bool setPlanSchedule(const std::string& id, std::shared_ptr<const PlanSchedule> schedule);  // While stopped; nullptr: fixed timing
+    const PlanScheduler& getPlanScheduler() const;
+    
+    // Field data ingestion. While the threads run, the batch is handed to the
+    // controller thread and applied at its next wakeup; the return value is then
+    // the number of events queued rather than applied.
+    size_t ingestDetections(const DetectionEvent* events, size_t count);
+    size_t ingestDetections(const std::vector<DetectionEvent>& events);
     
     // Emergency handling
     void handleEmergencyVehicle(const Vehicle& emergency);
@@ -41,7 +145,7 @@ public:
     
     // Traffic optimization
     void optimizeTrafficFlow();
-    void adaptiveSignalTiming();
+    void adaptiveSignalTiming();       // Due time-of-day plan changes; nothing between them
     void balanceIntersectionLoad();
     
     // System control
@@ -50,34 +154,120 @@ public:
     void pause();
     void resume();
     bool isRunning() const;
+    bool isPaused() const;
     
     // Configuration
     void setSimulationSpeed(int speed);
     void setRealTimeMode(bool realTime);
-    void configureIntersection(const std::string& id, Direction dir, int greenTime, int yellowTime);
+    void setSchedulingMode(SchedulingMode mode);
+    void setLoadShedding(bool enabled);
+    void setIdleSkipping(bool enabled);    // False visits every intersection every tick
+    bool isIdleSkipping() const;
+    SchedulingMode getSchedulingMode() const;
+    void setControlStrategy(ControlStrategy strategy);
+    ControlStrategy getControlStrategy() const;
+    void setLookaheadConfig(const LookaheadConfig& config);
+    const LookaheadController& getLookahead() const;
+    // Manual timing; takes the intersection off its plan schedule, so like
+    // setPlanSchedule it refuses while running
+    bool configureIntersection(const std::string& id, Direction dir, int greenTime, int yellowTime);
     
     // Simulation
+    bool submitVehicle(const std::string& intersectionId, const Vehicle& vehicle);
     void generateRandomTraffic();
     void simulateVehicleFlow();
     void updateAllIntersections();
+    void advanceSignals(std::chrono::steady_clock::time_point now);  // One second of signal time, all intersections
+    SignalTimerTable::Kernel getSignalKernel() const;
+    bool setSignalKernel(SignalTimerTable::Kernel kernel);
+    size_t getActiveIntersectionCount() const;
+    const NetworkLoad& getNetworkLoad() const;
+    
+    // Recorded traffic. Runs on the calling thread in simulated time while the
+    // system is stopped; speedup 0 replays as fast as possible.
+    ReplayResult runReplay(ReplaySource& source, double speedup = 0.0);
+    
+    // The loaded scenario with vehicles moving between intersections, on
+    // worker threads that each own a region of the network. Simulated time,
+    // as fast as possible, while the system is stopped; vehicles still on a
+    // link at the end are dropped, queued ones stay.
+    NetworkRunResult runShardedSimulation(const NetworkRunConfig& config);
+    
+    // The same run with each region in a forked worker process, exchanging
+    // boundary vehicles through this process over Unix domain sockets. The
+    // controller's own intersections are left as they were. POSIX only.
+    NetworkRunResult runPartitionedSimulation(const NetworkRunConfig& config);
+    
+    // Iterative traffic assignment of the loaded scenario's OD trips over
+    // repeated network runs; leaves the equilibrium routes in getRoutes()
+    AssignmentResult runAssignment(const AssignmentConfig& config);
+    
+    // Car-following microsimulation on lanes up to every signalled approach
+    // (as many lanes, as long, as the scenario link feeding it, if any), with
+    // copies of the signals; the intersections themselves are left as they were
+    LaneRunResult runLaneSimulation(const LaneRunConfig& config);
+    
+    // Green-wave offsets along a corridor of intersections (in the outbound
+    // order), on a common cycle; applied to the intersections themselves,
+    // which leave their plan schedules
+    CorridorResult coordinateCorridor(const CorridorConfig& config);
+    
+    // Event logging
+    bool startEventLog(const std::string& filename);
+    void stopEventLog();
+    bool isEventLogging() const;
+    
+    // Checkpoint/restore. Saving while running is deferred to the next tick boundary;
+    // restoring replaces all intersections, queues, stats and RNG state while stopped.
+    bool saveCheckpoint(const std::string& filename);
+    bool restoreCheckpoint(const std::string& filename);
+    void waitForCheckpoint();
+    bool isCheckpointWriting() const;
     
     // Statistics and reporting
     TrafficStats& getStatistics();
     void generateSystemReport() const;
     void saveReportToFile(const std::string& filename) const;
     void displaySystemStatus() const;
+    void displayWorstCongestion(size_t count) const;   // Top count of each ranking, at most SystemSnapshot::RANKED
+    SystemSnapshot getSnapshot() const;
+    uint64_t getSnapshotEpoch() const;
     
     // Utility methods
     void reset();
     int getIntersectionCount() const;
     std::vector<std::string> getIntersectionIds() const;
-    
+
 private:
+    enum class WakeReason {
+        DEADLINE,      // The requested time has arrived
+        RESUMED,       // Came back from a pause; any schedule is stale
+        STOPPING
+    };
+    
     // Internal helper methods
+    std::unique_ptr<Intersection> createIntersection(const std::string& id, uint8_t approachMask);
+    WakeReason waitUntil(std::chrono::steady_clock::time_point deadline, bool drainArrivals);
+    void postArrival(size_t intersectionIndex, const Vehicle& vehicle);
+    void applyArrival(size_t intersectionIndex, const Vehicle& vehicle);
+    size_t applyDetections(const DetectionEvent* events, size_t count);
     void controllerLoop();
+    std::chrono::steady_clock::duration getTickPeriod() const;
     void simulationLoop();
     void processIntersection(Intersection& intersection);
     void checkEmergencyConditions();
+    size_t stepReplaySecond(std::chrono::steady_clock::time_point simulatedNow);
+    size_t serviceIntersections(std::chrono::steady_clock::time_point now, bool controlStep);
+    void applyControlStrategy(Intersection& intersection, std::chrono::steady_clock::time_point now);
+    void captureSnapshot(SystemSnapshot& out) const;
+    void attachEventLogToIntersections();
+    void attachSignalTimersToIntersections();
+    void attachActiveSetToIntersections();
+    void attachNetworkLoadToIntersections();   // Rebuilds the aggregates: stopped only
+    void publishSnapshot();
+    void writeCheckpoint(CheckpointWriter& out);
+    void serviceCheckpointRequest();
+    void launchCheckpointWrite(const std::string& filename, std::vector<char>&& payload);
     Direction getRandomDirection();
     VehicleType getRandomVehicleType();
 };
\ No newline at end of file
@@ -29,10 +29,13 @@ private:
 
 public:
     TrafficLight(Direction dir, TrafficState initialState = TrafficState::RED);
+    // View of one approach of an intersection's packed signal state
+    TrafficLight(Direction dir, TrafficState currentState, int stateDuration, int remaining, bool emergency);
     
     // Core functionality
     void changeState(TrafficState newState);
     void update();
+    void tick();            // Advance one second of (possibly simulated) time
     void setDuration(int seconds);
     void activateEmergency();
     void deactivateEmergency();
@@ -50,4 +53,6 @@ public:
     bool isGreen() const;
     bool isYellow() const;
     bool canProceed() const;
+    
+    static int defaultDuration(TrafficState state);
 };
\ No newline at end of file
@@ -2,9 +2,26 @@
 
 #include "TrafficLight.h"
 #include <vector>
+#include <array>
 #include <chrono>
+#include <cstdint>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+// One detector actuation as reported by field equipment
+struct DetectionEvent {
+    uint32_t intersection;     // Index into the controller's intersection list
+    Direction approach;
+    std::chrono::steady_clock::time_point timestamp;
+};
 
 class TrafficSensor {
+public:
+    static const int WINDOW_SLOTS = 60;             // Intervals kept in the sliding window
+    static constexpr double DEFAULT_DWELL = 0.5;    // Seconds a passing vehicle occupies the detector
+    static constexpr double EWMA_FLOOR = 1e-4;      // Smoothed estimates below this settle at zero
+
 private:
     Direction direction;
     int vehicleCount;
@@ -12,6 +29,25 @@ private:
     bool isActive;
     double detectionRange;     // Detection range in meters
     
+    // Sliding-window flow estimation (ring of per-interval counts)
+    std::array<int, WINDOW_SLOTS> intervalCounts;
+    int windowHead;                 // Slot of the interval currently being filled
+    int windowCount;                // Running sum of intervalCounts
+    double currentOccupied;         // Occupied seconds in the current interval
+    long long currentInterval;      // Interval index held at windowHead
+    std::chrono::steady_clock::time_point windowStart;
+    std::chrono::steady_clock::time_point intervalEnd;  // Rolling the window earlier is a no-op
+    std::chrono::milliseconds intervalLength;
+    
+    // Exponentially weighted estimates, folded in as each interval closes
+    double smoothing;               // Weight of the newest interval (0..1]
+    double ewmaCount;               // Vehicles per interval
+    double ewmaOccupancy;           // Occupied fraction of an interval
+    double ewmaHeadway;             // Seconds between consecutive detections
+    bool headwayValid;
+    
+    void resetWindow(std::chrono::steady_clock::time_point now);
+    
 public:
     TrafficSensor(Direction dir, double range = 50.0);
     
@@ -33,4 +69,20 @@ public:
     double getTrafficDensity() const;
     bool hasRecentActivity(int seconds = 30) const;
     void incrementCount();
+    
+    // Sliding-window estimation
+    void recordDetection(std::chrono::steady_clock::time_point when, double dwellSeconds = DEFAULT_DWELL);
+    void advanceWindow(std::chrono::steady_clock::time_point now);
+    std::chrono::steady_clock::time_point getIntervalEnd() const;  // Next time advanceWindow has work
+    bool isAtRest() const;               // Window empty and estimates zero: rolling changes nothing
+    void setIntervalLength(std::chrono::milliseconds length);
+    void setSmoothing(double alpha);
+    double getFlowRate() const;          // Smoothed vehicles per minute
+    double getWindowFlowRate() const;    // Vehicles per minute over the whole window
+    double getOccupancy() const;         // Smoothed detector occupancy (0..1)
+    double getAverageHeadway() const;    // Smoothed seconds between vehicles, 0 if unknown
+    
+    // Checkpointing
+    void writeCheckpoint(CheckpointWriter& out) const;
+    void readCheckpoint(CheckpointReader& in);
 };
\ No newline at end of file
@@ -4,6 +4,10 @@
 #include <chrono>
 #include <map>
 #include <vector>
+#include <cstdint>
+
+class CheckpointWriter;
+class CheckpointReader;
 
 class TrafficStats {
 private:
@@ -22,6 +26,11 @@ private:
     double systemEfficiency;
     int totalCycles;
     int emergencyOverrides;
+    
+    // Network runs: experienced travel time per scenario link (link, then the
+    // wait to leave the intersection at its end), summed over traversals
+    std::vector<double> linkTravelSeconds;
+    std::vector<uint32_t> linkTraversals;
 
 public:
     TrafficStats();
@@ -34,6 +43,7 @@ public:
     void updateSystemEfficiency(double efficiency);
     void updateCycleCount();
     void updateEmergencyOverride();
+    void updateLinkTravelTimes(const std::vector<double>& seconds, const std::vector<uint32_t>& traversals);
     
     // Calculation methods
     double getAverageWaitTime() const;
@@ -48,6 +58,8 @@ public:
     double getTotalRunTime() const;  // Runtime in seconds
     int getTotalCycles() const;
     int getEmergencyOverrides() const;
+    double getLinkTravelTime(uint32_t link, double unobserved) const;  // Mean, or unobserved if never traversed
+    uint32_t getLinkTraversals(uint32_t link) const;
     
     // Direction-specific getters
     int getVehiclesByDirection(const std::string& direction) const;
@@ -62,4 +74,8 @@ public:
     // Display methods
     void displayRealTimeStats() const;
     void displaySummary() const;
+    
+    // Checkpointing
+    void writeCheckpoint(CheckpointWriter& out) const;
+    void readCheckpoint(CheckpointReader& in);
 };
\ No newline at end of file
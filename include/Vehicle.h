@@ -1,7 +1,13 @@
 #pragma once
 
+#include "TrafficLight.h"
+#include "Movement.h"
 #include <string>
 #include <chrono>
+#include <cstdint>
+
+class CheckpointWriter;
+class CheckpointReader;
 
 enum class VehicleType {
     CAR,
@@ -15,28 +21,44 @@ enum class VehicleType {
 };
 
 class Vehicle {
+public:
+    static const uint32_t NO_ROUTE = 0xFFFFFFFFu;
+
 private:
     std::string id;
+    uint32_t serial;           // Process-unique number for fixed-width logs
     VehicleType type;
     Direction direction;
+    Turn turn;
     int priority;              // Higher number = higher priority
     std::chrono::steady_clock::time_point arrivalTime;
     bool hasPassedIntersection;
+    uint32_t routeId;          // Into the RouteTable, NO_ROUTE for vehicles without a destination
+    uint32_t routeCursor;      // Next link of the route to take
 
 public:
-    Vehicle(const std::string& vehicleId, VehicleType vehType, Direction dir);
+    Vehicle(const std::string& vehicleId, VehicleType vehType, Direction dir, Turn vehTurn = Turn::THROUGH);
     
     // Core functionality
     void setPriority(int newPriority);
     void markAsPassed();
+    void setArrivalTime(std::chrono::steady_clock::time_point when);  // For replayed/simulated arrivals
+    void setApproach(Direction dir, Turn vehTurn);  // Moving on to the next intersection
+    void setRoute(uint32_t route);                  // Starts at its first link
+    void advanceRoute();
     
     // Getters
     std::string getId() const;
+    uint32_t getSerial() const;
     VehicleType getType() const;
     Direction getDirection() const;
+    Turn getTurn() const;
+    int getMovement() const;   // Index into the 12 approach/turn movements
     int getPriority() const;
     std::chrono::steady_clock::time_point getArrivalTime() const;
     bool hasPassed() const;
+    uint32_t getRouteId() const;
+    uint32_t getRouteCursor() const;
     
     // Type checking
     bool isEmergencyVehicle() const;
@@ -50,4 +72,8 @@ public:
     // Comparison operators for priority queue
     bool operator<(const Vehicle& other) const;
     bool operator>(const Vehicle& other) const;
+    
+    // Checkpointing
+    void writeCheckpoint(CheckpointWriter& out) const;
+    void readCheckpoint(CheckpointReader& in);
 };
\ No newline at end of file
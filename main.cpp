@@ -2,10 +2,17 @@
 #include "include/TrafficLight.h"
 #include "include/Vehicle.h"
 #include "include/Intersection.h"
+#include "include/TraceProfiler.h"
+#include "include/ReplaySource.h"
 #include <iostream>
 #include <string>
 #include <thread>
 #include <chrono>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <memory>
 
 class TrafficManagementDemo {
 private:
@@ -28,6 +35,21 @@ public:
         std::cout << "7. Run Demo Simulation\n";
         std::cout << "8. Configure Intersection\n";
         std::cout << "9. Stop System\n";
+        std::cout << "10. Pause/Resume System\n";
+        std::cout << "11. Start/Stop Performance Trace\n";
+        std::cout << "12. Start/Stop Binary Event Log\n";
+        std::cout << "13. Replay Detector Log\n";
+        std::cout << "14. Save Checkpoint\n";
+        std::cout << "15. Restore Checkpoint\n";
+        std::cout << "16. Toggle Lookahead Signal Control\n";
+        std::cout << "17. Load Scenario File\n";
+        std::cout << "18. Configure Ring-and-Barrier Phasing\n";
+        std::cout << "19. Run Sharded Network Simulation\n";
+        std::cout << "20. Run Traffic Assignment\n";
+        std::cout << "21. Run Lane Microsimulation\n";
+        std::cout << "22. Coordinate Corridor Green Wave\n";
+        std::cout << "23. Configure Time-of-Day Plans\n";
+        std::cout << "24. Show Worst Congestion\n";
         std::cout << "0. Exit\n";
         std::cout << std::string(60, '-') << "\n";
         std::cout << "Enter your choice: ";
@@ -55,7 +77,439 @@ public:
         std::cout << "Traffic management system stopped.\n";
     }
 
+    void togglePause() {
+        if (!controller.isRunning()) {
+            std::cout << "Please start the system first!\n";
+            return;
+        }
+        
+        if (controller.isPaused()) {
+            controller.resume();
+        } else {
+            controller.pause();
+        }
+    }
+
+    void toggleTrace() {
+#if TRAFFIC_TRACING
+        TraceProfiler& profiler = TraceProfiler::instance();
+        if (!profiler.isEnabled()) {
+            profiler.clear();
+            profiler.setEnabled(true);
+            std::cout << "Trace capture started.\n";
+            return;
+        }
+        
+        profiler.setEnabled(false);
+        std::string filename;
+        std::cout << "Enter trace filename (e.g. trace.json): ";
+        std::cin.ignore();
+        std::getline(std::cin, filename);
+        profiler.writeChromeTrace(filename);
+#else
+        std::cout << "Tracing is not available in this build (ENABLE_TRACING=OFF).\n";
+#endif
+    }
+
+    void toggleEventLog() {
+        if (controller.isEventLogging()) {
+            controller.stopEventLog();
+            return;
+        }
+        
+        std::string filename;
+        std::cout << "Enter event log filename (e.g. events.tlog): ";
+        std::cin.ignore();
+        std::getline(std::cin, filename);
+        controller.startEventLog(filename);
+    }
+
+    void replayDetectorLog() {
+        if (controller.isRunning()) {
+            std::cout << "Please stop the system before replaying a log!\n";
+            return;
+        }
+        
+        std::string filename;
+        std::cout << "Enter detector log filename (CSV or binary): ";
+        std::cin.ignore();
+        std::getline(std::cin, filename);
+        
+        ReplaySource source;
+        if (!source.open(filename)) {
+            return;
+        }
+        
+        double speedup;
+        std::cout << "Enter replay speedup (0 = as fast as possible): ";
+        std::cin >> speedup;
+        
+        // Records address intersections by index
+        if (controller.getIntersectionCount() == 0) {
+            controller.addIntersection("Main_Street_Intersection");
+        }
+        
+        ReplayResult result = controller.runReplay(source, speedup);
+        std::cout << "Replayed " << result.arrivals << " arrivals over "
+                  << result.simulatedSeconds << " simulated seconds in "
+                  << result.wallSeconds << " s (" << result.getSpeedup() << "x real time).\n";
+        std::cout << "Departures: " << result.departures
+                  << ", malformed: " << result.malformedRecords
+                  << ", unknown intersection: " << result.skippedRecords
+                  << ", out of order: " << result.outOfOrderRecords << "\n";
+    }
+
+    void saveCheckpoint() {
+        std::string filename;
+        std::cout << "Enter checkpoint filename (e.g. traffic.ckpt): ";
+        std::cin.ignore();
+        std::getline(std::cin, filename);
+        
+        if (controller.saveCheckpoint(filename)) {
+            std::cout << "Checkpoint scheduled; it is written in the background.\n";
+        }
+    }
+
+    void restoreCheckpoint() {
+        if (controller.isRunning()) {
+            std::cout << "Please stop the system before restoring a checkpoint!\n";
+            return;
+        }
+        
+        std::string filename;
+        std::cout << "Enter checkpoint filename: ";
+        std::cin.ignore();
+        std::getline(std::cin, filename);
+        controller.restoreCheckpoint(filename);
+    }
+
+    void toggleLookahead() {
+        if (controller.getControlStrategy() == ControlStrategy::LOOKAHEAD) {
+            controller.setControlStrategy(ControlStrategy::FIXED_TIME);
+        } else {
+            controller.setControlStrategy(ControlStrategy::LOOKAHEAD);
+        }
+    }
+
+    void loadScenario() {
+        if (controller.isRunning()) {
+            std::cout << "Please stop the system before loading a scenario!\n";
+            return;
+        }
+        
+        std::string filename;
+        std::cout << "Enter scenario filename (e.g. city.tscn): ";
+        std::cin.ignore();
+        std::getline(std::cin, filename);
+        controller.loadScenario(filename);
+    }
+
+    void runShardedSimulation() {
+        if (controller.isRunning()) {
+            std::cout << "Please stop the system before running a sharded simulation!\n";
+            return;
+        }
+        if (!controller.getScenario().isOpen()) {
+            std::cout << "Load a scenario first (option 17); its links carry vehicles between intersections.\n";
+            return;
+        }
+        
+        NetworkRunConfig config;
+        int minutes;
+        int mode;
+        std::cout << "Run regions on (1) worker threads or (2) worker processes: ";
+        std::cin >> mode;
+        std::cout << "Enter workers (0 = one per CPU): ";
+        std::cin >> config.workers;
+        std::cout << "Enter simulated minutes: ";
+        std::cin >> minutes;
+        config.seconds = static_cast<int64_t>(std::max(1, minutes)) * 60;
+        
+        NetworkRunResult result = mode == 2 ? controller.runPartitionedSimulation(config)
+                                            : controller.runShardedSimulation(config);
+        std::cout << "Simulated " << result.simulatedSeconds << " s on " << result.workers << " workers in "
+                  << result.wallSeconds << " s (" << result.getSpeedup() << "x real time).\n";
+        std::cout << "Entered: " << result.vehiclesEntered << ", exited: " << result.vehiclesExited
+                  << ", still in network: " << result.vehiclesInNetwork
+                  << ", average time in network: " << result.getAverageTimeInNetwork() << " s\n";
+        if (result.tripsStarted > 0) {
+            std::cout << "OD trips started: " << result.tripsStarted << ", reached their destination: "
+                      << result.tripsCompleted << "\n";
+        }
+        std::cout << "Link moves: " << result.linkTransfers << " (" << result.boundaryTransfers
+                  << " across " << result.cutLinks << " cut links)\n";
+        if (result.heldDischarges > 0 || result.entriesRefused > 0) {
+            std::cout << "Spillback: " << result.heldDischarges << " discharges held by full links, "
+                      << result.entriesRefused << " entries refused, " << result.fullLinks << " links full at the end\n";
+        }
+    }
+    
+    void runTrafficAssignment() {
+        if (controller.isRunning()) {
+            std::cout << "Please stop the system before running a traffic assignment!\n";
+            return;
+        }
+        if (controller.getRoutes().getRouteCount() == 0) {
+            std::cout << "Load a scenario with OD trips first (option 17).\n";
+            return;
+        }
+        
+        AssignmentConfig config;
+        int minutes;
+        std::cout << "Enter maximum iterations: ";
+        std::cin >> config.iterations;
+        std::cout << "Enter target relative gap (e.g. 0.02): ";
+        std::cin >> config.gapTarget;
+        std::cout << "Enter simulated minutes per iteration: ";
+        std::cin >> minutes;
+        config.run.seconds = static_cast<int64_t>(std::max(1, minutes)) * 60;
+        
+        AssignmentResult result = controller.runAssignment(config);
+        std::cout << "Iter  Rel. gap  Rerouted  Completed  Avg in network  Simulate  Reroute\n";
+        for (const auto& iteration : result.iterations) {
+            std::cout << std::setw(4) << iteration.iteration << "  " << std::setw(8) << std::fixed
+                      << std::setprecision(4) << iteration.relativeGap << "  " << std::setw(8) << iteration.reroutedPairs
+                      << "  " << std::setw(9) << iteration.tripsCompleted << "  " << std::setw(12)
+                      << std::setprecision(1) << iteration.averageTimeInNetwork << " s  " << std::setw(6)
+                      << std::setprecision(2) << iteration.simulateSeconds << " s  " << std::setw(5)
+                      << iteration.rerouteSeconds << " s\n";
+        }
+        std::cout << (result.converged ? "Converged" : "Not converged") << " after " << result.iterations.size()
+                  << " iterations in " << result.wallSeconds << " s.\n";
+        std::cout.unsetf(std::ios::fixed);
+    }
+    
+    void runLaneSimulation() {
+        if (controller.isRunning()) {
+            std::cout << "Please stop the system before running a lane simulation!\n";
+            return;
+        }
+        if (controller.getIntersectionCount() == 0) {
+            std::cout << "No intersections available. Please add an intersection first.\n";
+            return;
+        }
+        
+        LaneRunConfig config;
+        int minutes;
+        std::cout << "Enter simulated minutes: ";
+        std::cin >> minutes;
+        std::cout << "Enter lanes per approach (where no scenario link sets it): ";
+        std::cin >> config.lanesPerApproach;
+        std::cout << "Enter demand per lane (vehicles/hour): ";
+        std::cin >> config.demandPerLaneHour;
+        config.seconds = static_cast<int64_t>(std::max(1, minutes)) * 60;
+        
+        LaneRunResult result = controller.runLaneSimulation(config);
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "Simulated " << result.simulatedSeconds << " s on " << result.lanes << " lanes at "
+                  << result.stepsPerSecond << " Hz in " << result.wallSeconds << " s ("
+                  << result.getRealTimeFactor() << "x real time).\n";
+        std::cout << "Entered: " << result.vehiclesEntered << ", left: " << result.vehiclesLeft
+                  << ", on lanes: " << result.vehiclesOnLanes << " (peak " << result.peakVehicles
+                  << "), waiting to enter: " << result.entryBacklog << "\n";
+        std::cout << "Average travel time: " << result.getAverageTravelTime() << " s, stops per vehicle: "
+                  << result.getStopsPerVehicle() << "\n";
+        std::cout.unsetf(std::ios::fixed);
+    }
+    
+    void coordinateCorridor() {
+        if (controller.isRunning()) {
+            std::cout << "Please stop the system before coordinating a corridor!\n";
+            return;
+        }
+        if (controller.getIntersectionCount() < 2) {
+            std::cout << "A corridor needs at least two intersections.\n";
+            return;
+        }
+        
+        CorridorConfig config;
+        std::string line;
+        std::cout << "Enter intersection IDs in the direction of travel (blank for all): ";
+        std::cin.ignore();
+        std::getline(std::cin, line);
+        std::istringstream ids(line);
+        for (std::string id; ids >> id;) {
+            config.intersections.push_back(id);
+        }
+        std::cout << "Enter common cycle length in seconds (0 to search up to " << config.maxCycleSeconds << " s): ";
+        std::cin >> config.cycleSeconds;
+        
+        CorridorResult result = controller.coordinateCorridor(config);
+        if (!result.applied) {
+            return;
+        }
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "Offsets applied to " << result.offsets.size() << " intersections on a "
+                  << result.cycleSeconds << " s cycle (" << result.optimizeMilliseconds << " ms).\n";
+        std::cout << "Bandwidth outbound: " << result.outboundBandwidth << " s, inbound: "
+                  << result.inboundBandwidth << " s\n";
+        const char* names[2] = {"Outbound", "Inbound"};
+        for (int d = 0; d < 2; ++d) {
+            std::cout << names[d] << " stops per vehicle: " << result.before.stopsPerVehicle[d] << " -> "
+                      << result.after.stopsPerVehicle[d] << ", travel time: " << result.before.travelSeconds[d]
+                      << " s -> " << result.after.travelSeconds[d] << " s\n";
+        }
+        std::cout.unsetf(std::ios::fixed);
+    }
+
+    void configurePhasing() {
+        if (controller.isRunning()) {
+            std::cout << "Please stop the system before changing phasing!\n";
+            return;
+        }
+        if (controller.getIntersectionCount() == 0) {
+            std::cout << "No intersections available. Please add an intersection first.\n";
+            return;
+        }
+        
+        std::cout << "Available intersections:\n";
+        auto ids = controller.getIntersectionIds();
+        for (size_t i = 0; i < ids.size(); ++i) {
+            std::cout << i + 1 << ". " << ids[i] << "\n";
+        }
+        
+        int choice;
+        std::cout << "Select intersection: ";
+        std::cin >> choice;
+        if (choice <= 0 || choice > (int)ids.size()) {
+            std::cout << "Invalid choice!\n";
+            return;
+        }
+        std::string intersectionId = ids[choice - 1];
+        
+        std::cout << "Select phasing:\n";
+        std::cout << "0. Two-phase N-S / E-W cycle (default)\n";
+        std::cout << "1. Eight-phase ring-and-barrier, protected lefts\n";
+        std::cout << "2. Ring-and-barrier, one phase per approach, permitted lefts\n";
+        std::cout << "3. Show movement conflict matrix\n";
+        std::cout << "Choice: ";
+        int planChoice;
+        std::cin >> planChoice;
+        
+        if (planChoice == 0) {
+            controller.clearRingBarrierPlan(intersectionId);
+        } else if (planChoice == 1) {
+            int throughMax, leftMax;
+            std::cout << "Enter max green for through phases (seconds): ";
+            std::cin >> throughMax;
+            std::cout << "Enter max green for left-turn phases (seconds): ";
+            std::cin >> leftMax;
+            controller.setRingBarrierPlan(intersectionId, RingBarrierPlan::standardEightPhase(throughMax, leftMax));
+        } else if (planChoice == 2) {
+            int maxGreen;
+            std::cout << "Enter max green (seconds): ";
+            std::cin >> maxGreen;
+            controller.setRingBarrierPlan(intersectionId, RingBarrierPlan::twoPhasePermitted(maxGreen));
+        } else if (planChoice == 3) {
+            ConflictMatrix::instance().display();
+        } else {
+            std::cout << "Invalid choice!\n";
+        }
+    }
+    
+    void configurePlanSchedule() {
+        if (controller.isRunning()) {
+            std::cout << "Please stop the system before changing plan schedules!\n";
+            return;
+        }
+        if (controller.getIntersectionCount() == 0) {
+            std::cout << "No intersections available. Please add an intersection first.\n";
+            return;
+        }
+        
+        std::cout << "Available intersections:\n";
+        auto ids = controller.getIntersectionIds();
+        for (size_t i = 0; i < ids.size(); ++i) {
+            std::cout << i + 1 << ". " << ids[i] << "\n";
+        }
+        int choice;
+        std::cout << "Select intersection (0 for all): ";
+        std::cin >> choice;
+        if (choice < 0 || choice > (int)ids.size()) {
+            std::cout << "Invalid choice!\n";
+            return;
+        }
+        
+        auto schedule = std::make_shared<PlanSchedule>();
+        int planCount;
+        std::cout << "Enter number of plans: ";
+        std::cin >> planCount;
+        for (int p = 0; p < planCount; ++p) {
+            TimingPlan plan;
+            int yellow;
+            std::cout << "Plan " << p << " - green N S E W (seconds): ";
+            std::cin >> plan.greenSeconds[0] >> plan.greenSeconds[1] >> plan.greenSeconds[2] >> plan.greenSeconds[3];
+            std::cout << "Plan " << p << " - yellow (seconds): ";
+            std::cin >> yellow;
+            plan.yellowSeconds.fill(static_cast<uint16_t>(yellow));
+            std::cout << "Plan " << p << " - offset (seconds, -1 for free running): ";
+            std::cin >> plan.offset;
+            schedule->addPlan(plan);
+        }
+        
+        int periodCount;
+        std::cout << "Enter number of time-of-day periods: ";
+        std::cin >> periodCount;
+        for (int p = 0; p < periodCount; ++p) {
+            std::string days, start;
+            int planIndex;
+            std::cout << "Period " << p << " - days (digits, 0 = Sunday, e.g. 12345): ";
+            std::cin >> days;
+            std::cout << "Period " << p << " - start (HH:MM): ";
+            std::cin >> start;
+            std::cout << "Period " << p << " - plan: ";
+            std::cin >> planIndex;
+            
+            PlanPeriod period;
+            period.days = 0;
+            for (char c : days) {
+                if (c >= '0' && c <= '6') {
+                    period.days |= static_cast<uint8_t>(1u << (c - '0'));
+                }
+            }
+            size_t colon = start.find(':');
+            period.startMinute = colon == std::string::npos ? -1
+                : std::atoi(start.substr(0, colon).c_str()) * 60 + std::atoi(start.substr(colon + 1).c_str());
+            period.plan = static_cast<uint16_t>(std::max(0, planIndex));
+            std::string error;
+            if (!schedule->addPeriod(period, error)) {
+                std::cout << "Period rejected: " << error << "\n";
+            }
+        }
+        schedule->compile();
+        schedule->display();
+        
+        std::shared_ptr<const PlanSchedule> shared = schedule->getTransitions().empty() ? nullptr : schedule;
+        for (size_t i = 0; i < ids.size(); ++i) {
+            if (choice == 0 || choice == (int)i + 1) {
+                controller.setPlanSchedule(ids[i], shared);
+            }
+        }
+        std::cout << (shared ? "Plan schedule set.\n" : "No plans given; fixed timing.\n");
+    }
+    
+    void showWorstCongestion() {
+        if (controller.getIntersectionCount() == 0) {
+            std::cout << "No intersections available. Please add an intersection first.\n";
+            return;
+        }
+        
+        int count;
+        std::cout << "How many of each (1-" << SystemSnapshot::RANKED << "): ";
+        std::cin >> count;
+        if (count < 1 || count > static_cast<int>(SystemSnapshot::RANKED)) {
+            std::cout << "Invalid count!\n";
+            return;
+        }
+        controller.displayWorstCongestion(static_cast<size_t>(count));
+    }
+
     void addIntersection() {
+        if (controller.isRunning()) {
+            std::cout << "Please stop the system before adding intersections!\n";
+            return;
+        }
+
         std::string id;
         std::cout << "Enter intersection ID: ";
         std::cin.ignore();
@@ -88,24 +542,22 @@ public:
         std::cout << "Choice: ";
         std::cin >> dirChoice;
         
-        if (typeChoice >= 0 && typeChoice <= 7 && dirChoice >= 0 && dirChoice <= 3) {
+        int turnChoice;
+        std::cout << "Select turn:\n";
+        std::cout << "0. Left  1. Through  2. Right\n";
+        std::cout << "Choice: ";
+        std::cin >> turnChoice;
+        
+        if (typeChoice >= 0 && typeChoice <= 7 && dirChoice >= 0 && dirChoice <= 3 && turnChoice >= 0 && turnChoice <= 2) {
             VehicleType type = static_cast<VehicleType>(typeChoice);
             Direction dir = static_cast<Direction>(dirChoice);
             
-            Vehicle vehicle(id, type, dir);
+            Vehicle vehicle(id, type, dir, static_cast<Turn>(turnChoice));
             
             // Add to first intersection
             auto intersectionIds = controller.getIntersectionIds();
             if (!intersectionIds.empty()) {
-                Intersection* intersection = controller.getIntersection(intersectionIds[0]);
-                if (intersection) {
-                    intersection->addVehicle(vehicle);
-                    controller.getStatistics().updateVehicleCount();
-                    
-                    if (vehicle.isEmergencyVehicle()) {
-                        controller.handleEmergencyVehicle(vehicle);
-                    }
-                    
+                if (controller.submitVehicle(intersectionIds[0], vehicle)) {
                     std::cout << "Vehicle " << id << " added successfully!\n";
                 }
             } else {
@@ -138,15 +590,10 @@ public:
             Direction dir = static_cast<Direction>(dirChoice);
             Vehicle emergency(id, VehicleType::AMBULANCE, dir);
             
-            controller.handleEmergencyVehicle(emergency);
-            
-            // Also add to intersection
+            // Queued and prioritized by the controller thread as soon as it wakes
             auto intersectionIds = controller.getIntersectionIds();
             if (!intersectionIds.empty()) {
-                Intersection* intersection = controller.getIntersection(intersectionIds[0]);
-                if (intersection) {
-                    intersection->addVehicle(emergency);
-                }
+                controller.submitVehicle(intersectionIds[0], emergency);
             }
             
             std::cout << "Emergency vehicle " << id << " added and prioritized!\n";
@@ -205,20 +652,12 @@ public:
                 
                 auto intersectionIds = controller.getIntersectionIds();
                 if (!intersectionIds.empty()) {
-                    Intersection* intersection = controller.getIntersection(intersectionIds[0]);
-                    if (intersection) {
-                        intersection->addVehicle(vehicle);
-                        controller.getStatistics().updateVehicleCount();
-                        
-                        if (vehicle.isEmergencyVehicle()) {
-                            controller.handleEmergencyVehicle(vehicle);
-                        }
-                    }
+                    controller.submitVehicle(intersectionIds[0], vehicle);
                 }
             }
             
             // Display real-time stats
-            controller.getStatistics().displayRealTimeStats();
+            controller.getSnapshot().statistics.displayRealTimeStats();
             
             vehicleCounter++;
             std::this_thread::sleep_for(std::chrono::milliseconds(1000));
@@ -262,8 +701,9 @@ public:
                 std::cout << "Enter yellow light duration (seconds): ";
                 std::cin >> yellowTime;
                 
-                controller.configureIntersection(intersectionId, dir, greenTime, yellowTime);
-                std::cout << "Intersection configured successfully!\n";
+                if (controller.configureIntersection(intersectionId, dir, greenTime, yellowTime)) {
+                    std::cout << "Intersection configured successfully!\n";
+                }
             } else {
                 std::cout << "Invalid direction!\n";
             }
@@ -309,6 +749,51 @@ public:
                 case 9:
                     stopSystem();
                     break;
+                case 10:
+                    togglePause();
+                    break;
+                case 11:
+                    toggleTrace();
+                    break;
+                case 12:
+                    toggleEventLog();
+                    break;
+                case 13:
+                    replayDetectorLog();
+                    break;
+                case 14:
+                    saveCheckpoint();
+                    break;
+                case 15:
+                    restoreCheckpoint();
+                    break;
+                case 16:
+                    toggleLookahead();
+                    break;
+                case 17:
+                    loadScenario();
+                    break;
+                case 18:
+                    configurePhasing();
+                    break;
+                case 19:
+                    runShardedSimulation();
+                    break;
+                case 20:
+                    runTrafficAssignment();
+                    break;
+                case 21:
+                    runLaneSimulation();
+                    break;
+                case 22:
+                    coordinateCorridor();
+                    break;
+                case 23:
+                    configurePlanSchedule();
+                    break;
+                case 24:
+                    showWorstCongestion();
+                    break;
                 case 0:
                     std::cout << "Exiting system...\n";
                     if (demoRunning) {
@@ -0,0 +1,56 @@
+#include "../include/ActiveSet.h"
+#include <algorithm>
+
+ActiveSet::ActiveSet() : sorted(true), wakeCount(0) {
+}
+
+void ActiveSet::resize(size_t count) {
+    if (count < active.size()) {
+        retain([count](uint32_t index) { return index < count; });
+    }
+    active.resize(count, 0);
+}
+
+void ActiveSet::clear() {
+    for (uint32_t index : members) {
+        active[index] = 0;
+    }
+    members.clear();
+    sorted = true;
+}
+
+void ActiveSet::wake(uint32_t index) {
+    if (index >= active.size() || active[index]) {
+        return;
+    }
+    active[index] = 1;
+    if (!members.empty() && members.back() > index) {
+        sorted = false;
+    }
+    members.push_back(index);
+    wakeCount++;
+}
+
+bool ActiveSet::isActive(uint32_t index) const {
+    return index < active.size() && active[index];
+}
+
+size_t ActiveSet::size() const {
+    return members.size();
+}
+
+size_t ActiveSet::capacity() const {
+    return active.size();
+}
+
+uint64_t ActiveSet::getWakeCount() const {
+    return wakeCount;
+}
+
+const std::vector<uint32_t>& ActiveSet::getMembers() {
+    if (!sorted) {
+        std::sort(members.begin(), members.end());
+        sorted = true;
+    }
+    return members;
+}
\ No newline at end of file
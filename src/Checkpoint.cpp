@@ -0,0 +1,157 @@
+#include "../include/Checkpoint.h"
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+
+namespace {
+
+const char FILE_MAGIC[8] = {'T', 'R', 'F', 'C', 'K', 'P', 'T', '1'};
+const uint32_t FORMAT_VERSION = 6;
+const size_t HEADER_SIZE = 32;
+
+uint64_t checksum(const char* data, size_t size) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+}  // namespace
+
+CheckpointWriter::CheckpointWriter(std::chrono::steady_clock::time_point captureTime)
+    : base(captureTime) {
+    buffer.reserve(64 * 1024);
+}
+
+void CheckpointWriter::putString(const std::string& value) {
+    put(static_cast<uint32_t>(value.size()));
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+void CheckpointWriter::putTime(std::chrono::steady_clock::time_point value) {
+    put(static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(value - base).count()));
+}
+
+std::vector<char>& CheckpointWriter::data() {
+    return buffer;
+}
+
+bool CheckpointWriter::writeFile(const std::string& path, const std::vector<char>& payload) {
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            std::cerr << "Error: Could not open file " << tempPath << " for writing.\n";
+            return false;
+        }
+        
+        uint32_t version = FORMAT_VERSION;
+        uint32_t reserved = 0;
+        uint64_t size = payload.size();
+        uint64_t sum = checksum(payload.data(), payload.size());
+        out.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+        out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        out.write(reinterpret_cast<const char*>(&reserved), sizeof(reserved));
+        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        out.write(reinterpret_cast<const char*>(&sum), sizeof(sum));
+        out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        out.flush();
+        if (!out) {
+            std::cerr << "Error: Failed writing checkpoint " << tempPath << ".\n";
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    std::remove(path.c_str());  // rename() won't replace an existing file on Windows
+#endif
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::cerr << "Error: Could not replace checkpoint " << path << ".\n";
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+CheckpointReader::CheckpointReader()
+    : cursor(nullptr), end(nullptr), failed(true) {
+}
+
+bool CheckpointReader::open(const std::string& path, std::chrono::steady_clock::time_point restoreTime) {
+    failed = true;
+    base = restoreTime;
+    if (!file.open(path)) {
+        return false;
+    }
+    
+    const char* data = file.data();
+    if (file.size() < HEADER_SIZE || std::memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        std::cerr << "Error: " << path << " is not a controller checkpoint.\n";
+        return false;
+    }
+    
+    uint32_t version;
+    uint64_t size;
+    uint64_t sum;
+    std::memcpy(&version, data + 8, sizeof(version));
+    std::memcpy(&size, data + 16, sizeof(size));
+    std::memcpy(&sum, data + 24, sizeof(sum));
+    if (version != FORMAT_VERSION) {
+        std::cerr << "Error: Unsupported checkpoint version " << version << ".\n";
+        return false;
+    }
+    if (size != file.size() - HEADER_SIZE || checksum(data + HEADER_SIZE, size) != sum) {
+        std::cerr << "Error: Checkpoint " << path << " is corrupt.\n";
+        return false;
+    }
+    
+    cursor = data + HEADER_SIZE;
+    end = cursor + size;
+    failed = false;
+    return true;
+}
+
+void CheckpointReader::openBuffer(const char* data, size_t size, std::chrono::steady_clock::time_point restoreTime) {
+    file.close();
+    base = restoreTime;
+    cursor = data;
+    end = data + size;
+    failed = false;
+}
+
+std::string CheckpointReader::getString() {
+    uint32_t length = getCount(1);
+    if (failed) {
+        return std::string();
+    }
+    std::string value(cursor, length);
+    cursor += length;
+    return value;
+}
+
+std::chrono::steady_clock::time_point CheckpointReader::getTime() {
+    return base + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::nanoseconds(get<int64_t>()));
+}
+
+uint32_t CheckpointReader::getCount(size_t minElementBytes) {
+    uint32_t count = get<uint32_t>();
+    if (!failed && static_cast<uint64_t>(count) * minElementBytes > static_cast<uint64_t>(end - cursor)) {
+        failed = true;
+    }
+    return failed ? 0 : count;
+}
+
+void CheckpointReader::fail() {
+    failed = true;
+}
+
+bool CheckpointReader::ok() const {
+    return !failed;
+}
+
+bool CheckpointReader::atEnd() const {
+    return cursor == end;
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "../include/CongestionIndex.h"
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <utility>
+
+namespace {
+
+const double NO_WAIT = std::numeric_limits<double>::lowest();
+
+}  // namespace
+
+void IndexedHeap::place(size_t at, uint32_t slot) {
+    heap[at] = slot;
+    position[slot] = static_cast<uint32_t>(at);
+}
+
+void IndexedHeap::siftUp(size_t at) {
+    uint32_t slot = heap[at];
+    while (at > 0) {
+        size_t parent = (at - 1) / 2;
+        if (keys[heap[parent]] >= keys[slot]) {
+            break;
+        }
+        place(at, heap[parent]);
+        at = parent;
+    }
+    place(at, slot);
+}
+
+void IndexedHeap::siftDown(size_t at) {
+    uint32_t slot = heap[at];
+    for (;;) {
+        size_t child = at * 2 + 1;
+        if (child >= heap.size()) {
+            break;
+        }
+        if (child + 1 < heap.size() && keys[heap[child + 1]] > keys[heap[child]]) {
+            ++child;
+        }
+        if (keys[heap[child]] <= keys[slot]) {
+            break;
+        }
+        place(at, heap[child]);
+        at = child;
+    }
+    place(at, slot);
+}
+
+void IndexedHeap::resize(size_t count, double key) {
+    if (count < keys.size()) {
+        keys.resize(count);
+        assign(std::move(keys));
+        return;
+    }
+    while (keys.size() < count) {
+        uint32_t slot = static_cast<uint32_t>(keys.size());
+        keys.push_back(key);
+        heap.push_back(slot);
+        position.push_back(slot);
+        siftUp(slot);
+    }
+}
+
+void IndexedHeap::update(uint32_t slot, double key) {
+    double old = keys[slot];
+    keys[slot] = key;
+    if (key > old) {
+        siftUp(position[slot]);
+    } else if (key < old) {
+        siftDown(position[slot]);
+    }
+}
+
+void IndexedHeap::assign(std::vector<double> newKeys) {
+    keys = std::move(newKeys);
+    heap.resize(keys.size());
+    position.resize(keys.size());
+    for (size_t at = 0; at < keys.size(); ++at) {
+        place(at, static_cast<uint32_t>(at));
+    }
+    for (size_t at = heap.size() / 2; at-- > 0;) {
+        siftDown(at);
+    }
+}
+
+void IndexedHeap::top(size_t k, std::vector<uint32_t>& out) const {
+    out.clear();
+    if (heap.empty() || k == 0) {
+        return;
+    }
+    
+    // The next largest is always a child of one already taken, so only the
+    // frontier below the taken ones is kept (at most k + 1 entries)
+    std::priority_queue<std::pair<double, uint32_t>> frontier;
+    frontier.push({keys[heap[0]], 0});
+    while (!frontier.empty() && out.size() < k) {
+        size_t at = frontier.top().second;
+        frontier.pop();
+        out.push_back(heap[at]);
+        for (size_t child = at * 2 + 1; child <= at * 2 + 2 && child < heap.size(); ++child) {
+            frontier.push({keys[heap[child]], static_cast<uint32_t>(child)});
+        }
+    }
+}
+
+double IndexedHeap::getKey(uint32_t slot) const {
+    return keys[slot];
+}
+
+size_t IndexedHeap::size() const {
+    return keys.size();
+}
+
+CongestionIndex::CongestionIndex() : baselineSeconds(-1.0), windowStartSeconds(-1.0) {
+}
+
+void CongestionIndex::resize(size_t count) {
+    byQueue.resize(count, 0.0);
+    byWait.resize(count, NO_WAIT);
+    byGrowth.resize(count, 0.0);
+    byApproach.resize(count * 4, 0.0);
+    baseline.resize(count, 0);
+    windowStartLoad.resize(count, 0);
+}
+
+void CongestionIndex::clear() {
+    size_t count = baseline.size();
+    byQueue.assign(std::vector<double>(count, 0.0));
+    byWait.assign(std::vector<double>(count, NO_WAIT));
+    byGrowth.assign(std::vector<double>(count, 0.0));
+    byApproach.assign(std::vector<double>(count * 4, 0.0));
+    std::fill(baseline.begin(), baseline.end(), 0);
+    std::fill(windowStartLoad.begin(), windowStartLoad.end(), 0);
+    baselineSeconds = -1.0;
+    windowStartSeconds = -1.0;
+}
+
+void CongestionIndex::updateApproach(uint32_t index, int approach, int32_t queued) {
+    byApproach.update(index * 4 + static_cast<uint32_t>(approach), queued);
+}
+
+void CongestionIndex::updateIntersection(uint32_t index, int32_t load, double arrivalSum) {
+    byQueue.update(index, load);
+    byWait.update(index, load > 0 ? -arrivalSum / load : NO_WAIT);
+    byGrowth.update(index, load - baseline[index]);
+}
+
+void CongestionIndex::rollGrowthWindow(double nowSeconds, const std::vector<int32_t>& load) {
+    if (windowStartSeconds >= 0.0 && nowSeconds - windowStartSeconds < GROWTH_WINDOW_SECONDS) {
+        return;
+    }
+    
+    // The first roll only starts measuring: growth is counted from the loads as of now
+    bool first = windowStartSeconds < 0.0;
+    baseline = first ? load : windowStartLoad;
+    baselineSeconds = first ? nowSeconds : windowStartSeconds;
+    windowStartLoad = load;
+    windowStartSeconds = nowSeconds;
+    
+    std::vector<double> growth(load.size());
+    for (size_t i = 0; i < load.size(); ++i) {
+        growth[i] = load[i] - baseline[i];
+    }
+    byGrowth.assign(std::move(growth));
+}
+
+void CongestionIndex::top(CongestionMetric metric, size_t k, double nowSeconds,
+                          std::vector<CongestionEntry>& out) const {
+    out.clear();
+    if (metric == CongestionMetric::GROWTH_RATE && windowStartSeconds < 0.0) {
+        return;   // Not measuring yet
+    }
+    
+    const IndexedHeap& heap = metric == CongestionMetric::QUEUE_LENGTH ? byQueue
+                            : metric == CongestionMetric::AVERAGE_WAIT ? byWait
+                            : metric == CongestionMetric::GROWTH_RATE ? byGrowth : byApproach;
+    std::vector<uint32_t> slots;
+    heap.top(k, slots);
+    
+    double perMinute = 60.0 / std::max(1.0, nowSeconds - baselineSeconds);
+    for (uint32_t slot : slots) {
+        double key = heap.getKey(slot);
+        if (key <= 0.0 && metric != CongestionMetric::AVERAGE_WAIT) {
+            break;   // Largest first, so nothing after this has anything to report either
+        }
+        if (key == NO_WAIT) {
+            break;
+        }
+        
+        CongestionEntry entry = {slot, -1, key};
+        if (metric == CongestionMetric::APPROACH_QUEUE) {
+            entry.index = slot / 4;
+            entry.approach = static_cast<int>(slot % 4);
+        } else if (metric == CongestionMetric::AVERAGE_WAIT) {
+            entry.value = std::max(0.0, nowSeconds + key);
+        } else if (metric == CongestionMetric::GROWTH_RATE) {
+            entry.value = key * perMinute;
+        }
+        out.push_back(entry);
+    }
+}
\ No newline at end of file
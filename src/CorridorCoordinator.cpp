@@ -0,0 +1,263 @@
+#include "../include/CorridorCoordinator.h"
+#include "../include/TraceProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+double wrap(double value, double cycle) {
+    double wrapped = std::fmod(value, cycle);
+    return wrapped < 0.0 ? wrapped + cycle : wrapped;
+}
+
+struct Interval {
+    double lo;
+    double hi;
+};
+
+}  // namespace
+
+CorridorCoordinator::CorridorCoordinator(const std::vector<Intersection*>& corridor,
+                                         const std::vector<CorridorLink>& outboundLinks,
+                                         const std::vector<CorridorLink>& inboundLinks,
+                                         const CorridorConfig& corridorConfig)
+    : signals(corridor), outbound(outboundLinks), inbound(inboundLinks), config(corridorConfig) {
+}
+
+int CorridorCoordinator::corridorPhase(size_t signal) const {
+    // The phase serving the outbound approach; the inbound one is opposite it
+    Direction approach = outbound[signal > 0 ? signal - 1 : 0].heading;
+    return approach == Direction::NORTH || approach == Direction::SOUTH ? 0 : 1;
+}
+
+double CorridorCoordinator::maximizeBandwidth(double cycle, const std::vector<double>& greens,
+                                              const std::vector<double>& outboundSeconds,
+                                              const std::vector<double>& inboundSeconds, double resolution,
+                                              double balance, std::vector<double>& greenStart) {
+    size_t n = greens.size();
+    greenStart.assign(n, 0.0);
+    if (n == 0 || cycle <= 0.0) {
+        return 0.0;
+    }
+    double shortest = *std::min_element(greens.begin(), greens.end());
+    
+    // One-way progression always fits: the outbound band as wide as the
+    // shortest green, the inbound direction left to chance. Only allowed
+    // without a balance; otherwise any two-way pair beats it.
+    bool oneWay = balance <= 0.0;
+    double best = oneWay ? shortest : 0.0;
+    bool twoWay = false;
+    double bestY = 0.0, bestW = oneWay ? shortest : 0.0, bestV = 0.0;
+    
+    // With the outbound band [0, w) and the inbound one at [y, y + v), signal i
+    // fits both exactly when v <= p_i or w <= q_i (derived from where its
+    // green may start for each band). For a given y, sorting by p gives every
+    // (w, v) worth trying in one sweep.
+    std::vector<double> delta(n), p(n), q(n), prefixMin(n + 1);
+    std::vector<size_t> order(n);
+    for (double y = 0.0; y < cycle; y += std::max(resolution, 0.01)) {
+        for (size_t i = 0; i < n; ++i) {
+            delta[i] = wrap(y - outboundSeconds[i] + inboundSeconds[i], cycle);
+            p[i] = greens[i] - delta[i];
+            q[i] = greens[i] - cycle + delta[i];
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return p[a] < p[b]; });
+        prefixMin[0] = std::numeric_limits<double>::infinity();
+        for (size_t k = 0; k < n; ++k) {
+            prefixMin[k + 1] = std::min(prefixMin[k], q[order[k]]);
+        }
+        
+        // Candidate v: every p up to the shortest green, and that green. The
+        // signals with p below v must take the outbound band through q.
+        size_t below = 0;
+        auto tryWidth = [&](double v) {
+            while (below < n && p[order[below]] < v) {
+                below++;
+            }
+            double w = std::min(shortest, prefixMin[below]);
+            if (balance > 0.0) {
+                w = std::min(w, v / balance);   // A narrower outbound band still fits
+            }
+            double score = w + v + 1e-6 * std::min(w, v);   // Ties go to the more even split
+            if (w > 0.0 && score > best) {
+                best = score;
+                twoWay = true;
+                bestY = y;
+                bestW = w;
+                bestV = v;
+            }
+        };
+        for (size_t k = 0; k < n; ++k) {
+            double v = p[order[k]];
+            if (v > 0.0 && v < shortest) {
+                tryWidth(v);
+            }
+        }
+        tryWidth(shortest);
+    }
+    
+    // Each green start in the middle of the range that keeps the band(s)
+    for (size_t i = 0; i < n; ++i) {
+        double outboundSlack = greens[i] - bestW;
+        double lo = -outboundSlack;
+        double hi = 0.0;
+        if (twoWay) {
+            double d = wrap(bestY - outboundSeconds[i] + inboundSeconds[i], cycle);
+            double inboundSlack = greens[i] - bestV;
+            if (d > inboundSlack) {
+                d -= cycle;   // The inbound range lies just before the outbound one
+            }
+            lo = std::max(lo, d - inboundSlack);
+            hi = std::min(hi, d);
+        }
+        double start = lo <= hi ? 0.5 * (lo + hi) : 0.0;
+        greenStart[i] = wrap(start + outboundSeconds[i], cycle);
+    }
+    return twoWay || oneWay ? bestW + bestV : 0.0;
+}
+
+double CorridorCoordinator::bandwidth(double cycle, const std::vector<double>& starts, const std::vector<double>& greens) {
+    if (starts.empty()) {
+        return 0.0;
+    }
+    
+    // Intersect every arc with the first one, kept as intervals in its frame
+    std::vector<Interval> band = {{0.0, std::min(greens[0], cycle)}};
+    std::vector<Interval> next;
+    for (size_t i = 1; i < starts.size() && !band.empty(); ++i) {
+        double u = wrap(starts[i] - starts[0], cycle);
+        next.clear();
+        for (const Interval& piece : {Interval{u, u + greens[i]}, Interval{u - cycle, u - cycle + greens[i]}}) {
+            for (const Interval& current : band) {
+                double lo = std::max(current.lo, piece.lo);
+                double hi = std::min(current.hi, piece.hi);
+                if (lo < hi) {
+                    next.push_back({lo, hi});
+                }
+            }
+        }
+        band.swap(next);
+    }
+    
+    double widest = 0.0;
+    for (const Interval& interval : band) {
+        widest = std::max(widest, interval.hi - interval.lo);
+    }
+    return widest;
+}
+
+CorridorMeasures CorridorCoordinator::measure() const {
+    CorridorMeasures measures;
+    std::vector<const Intersection*> copies(signals.begin(), signals.end());
+    size_t n = signals.size();
+    
+    for (int direction = 0; direction < 2; ++direction) {
+        LaneSimulation simulation(copies, config.evaluation);
+        for (size_t k = 0; k < n; ++k) {
+            // Outbound lane k ends at signal k; inbound lane k at signal n - 1 - k
+            size_t signal = direction == 0 ? k : n - 1 - k;
+            const CorridorLink& link = direction == 0 ? outbound[k > 0 ? k - 1 : 0]
+                                                      : inbound[signal < n - 1 ? signal : n - 2];
+            LaneSpec spec;
+            spec.lengthMeters = link.meters;
+            spec.signal = static_cast<int32_t>(signal);
+            spec.approach = link.heading;
+            spec.next = k + 1 < n ? static_cast<int32_t>(k + 1) : -1;
+            spec.demandPerHour = k == 0 ? config.evaluation.demandPerLaneHour : 0.0f;
+            simulation.addLane(spec);
+        }
+        LaneRunResult run = simulation.run();
+        measures.stopsPerVehicle[direction] = run.getStopsPerVehicle();
+        measures.travelSeconds[direction] = run.getAverageTravelTime();
+        measures.vehicles[direction] = run.vehiclesLeft;
+    }
+    return measures;
+}
+
+CorridorResult CorridorCoordinator::run() {
+    TRAFFIC_TRACE_SCOPE("CorridorCoordinator::run");
+    
+    CorridorResult result;
+    size_t n = signals.size();
+    if (n < 2 || outbound.size() != n - 1 || inbound.size() != n - 1) {
+        std::cerr << "Error: A corridor needs at least two signals and a link between each pair.\n";
+        return result;
+    }
+    for (const Intersection* signal : signals) {
+        if (signal->hasRingBarrierPlan() || signal->isEmergencyMode()) {
+            std::cerr << "Error: Intersection " << signal->getId()
+                      << " is not on the two-phase cycle; offsets cannot be applied to it.\n";
+            return result;
+        }
+    }
+    
+    result.before = measure();
+    auto start = std::chrono::steady_clock::now();
+    
+    std::vector<double> outboundSeconds(n, 0.0), inboundSeconds(n, 0.0);
+    for (size_t i = 1; i < n; ++i) {
+        outboundSeconds[i] = outboundSeconds[i - 1] + outbound[i - 1].meters / std::max(0.1f, outbound[i - 1].speed);
+    }
+    for (size_t i = n - 1; i-- > 0;) {
+        inboundSeconds[i] = inboundSeconds[i + 1] + inbound[i].meters / std::max(0.1f, inbound[i].speed);
+    }
+    
+    // Common cycle: no shorter than the critical (longest) member cycle, the
+    // others giving their extra time to the corridor phase
+    int longest = 0;
+    for (const Intersection* signal : signals) {
+        longest = std::max(longest, signal->getCycleLength());
+    }
+    int firstCycle = std::max(config.cycleSeconds, longest);
+    int lastCycle = config.cycleSeconds > 0 ? firstCycle : std::max(firstCycle, config.maxCycleSeconds);
+    
+    int cycle = firstCycle;
+    double bestShare = -1.0;
+    std::vector<double> greens(n), candidateGreens(n), greenStart, candidateStart;
+    for (int candidate = firstCycle; candidate <= lastCycle; ++candidate) {
+        for (size_t i = 0; i < n; ++i) {
+            int phase = corridorPhase(i);
+            candidateGreens[i] = signals[i]->getPlannedPhaseLength(phase) - signals[i]->getPlannedYellow(phase) +
+                                 candidate - signals[i]->getCycleLength();
+        }
+        double share = maximizeBandwidth(candidate, candidateGreens, outboundSeconds, inboundSeconds, config.resolution,
+                                         config.balance, candidateStart) / candidate;
+        if (share > bestShare) {   // Ties keep the shorter cycle
+            bestShare = share;
+            cycle = candidate;
+            greens.swap(candidateGreens);
+            greenStart.swap(candidateStart);
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        int phase = corridorPhase(i);
+        int yellow = signals[i]->getPlannedYellow(phase);
+        int green = static_cast<int>(greens[i]);
+        signals[i]->configureTiming(phase == 0 ? Direction::NORTH : Direction::EAST, green, yellow);
+        signals[i]->configureTiming(phase == 0 ? Direction::SOUTH : Direction::WEST, green, yellow);
+    }
+    
+    // Signals run in whole seconds; the bands are reported for the rounded offsets
+    std::vector<double> outboundStarts(n), inboundStarts(n);
+    result.offsets.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        result.offsets[i] = static_cast<int>(std::lround(greenStart[i])) % cycle;
+        outboundStarts[i] = result.offsets[i] - outboundSeconds[i];
+        inboundStarts[i] = result.offsets[i] - inboundSeconds[i];
+        
+        int phaseStart = corridorPhase(i) == 0 ? 0 : signals[i]->getPlannedPhaseLength(0);
+        signals[i]->setCyclePosition(phaseStart - result.offsets[i]);
+    }
+    result.cycleSeconds = cycle;
+    result.outboundBandwidth = bandwidth(cycle, outboundStarts, greens);
+    result.inboundBandwidth = bandwidth(cycle, inboundStarts, greens);
+    result.optimizeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    
+    result.after = measure();
+    result.applied = true;
+    return result;
+}
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "../include/EventLog.h"
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+namespace {
+
+const char FILE_MAGIC[8] = {'T', 'R', 'A', 'F', 'L', 'O', 'G', '1'};
+const char SEGMENT_MAGIC[4] = {'S', 'E', 'G', '1'};
+const size_t STREAM_BUFFER_BYTES = 4 << 20;
+
+std::atomic<uint64_t> nextSessionId(1);
+
+// The chunk the current thread is filling, and which log session it belongs to
+struct ThreadSlot {
+    uint64_t sessionId = 0;
+    EventChunk* chunk = nullptr;
+};
+
+// One slot per log the thread appends to, most recently used first, so a
+// thread alternating between logs keeps filling each one's chunk. Sessions
+// are unique across logs, which is what keys a slot to its log.
+const size_t THREAD_SLOTS = 4;
+
+thread_local ThreadSlot threadSlots[THREAD_SLOTS];
+
+ThreadSlot& slotFor(uint64_t session) {
+    size_t i = 0;
+    while (i + 1 < THREAD_SLOTS && threadSlots[i].sessionId != session) {
+        ++i;
+    }
+    // A miss reuses the least recently used slot; a chunk left there stays with
+    // its log until that log closes
+    std::rotate(threadSlots, threadSlots + i, threadSlots + i + 1);
+    return threadSlots[0];
+}
+
+template <typename T>
+void writeColumn(std::ofstream& file, const T* column, uint32_t count) {
+    file.write(reinterpret_cast<const char*>(column), static_cast<std::streamsize>(sizeof(T) * count));
+}
+
+template <typename T>
+bool readColumn(std::ifstream& file, std::vector<T>& column, uint32_t count) {
+    column.resize(count);
+    file.read(reinterpret_cast<char*>(column.data()), static_cast<std::streamsize>(sizeof(T) * count));
+    return static_cast<bool>(file);
+}
+
+}  // namespace
+
+EventLog::EventLog()
+    : sessionId(0), accepting(false), writerStop(false), eventsWritten(0), segmentsWritten(0) {
+}
+
+EventLog::~EventLog() {
+    close();
+}
+
+bool EventLog::open(const std::string& filename) {
+    close();
+    
+    // The stream buffer has to be installed before the file is opened to take effect
+    streamBuffer.resize(STREAM_BUFFER_BYTES);
+    file.rdbuf()->pubsetbuf(streamBuffer.data(), static_cast<std::streamsize>(streamBuffer.size()));
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open event log " << filename << " for writing.\n";
+        return false;
+    }
+    
+    startTime = std::chrono::steady_clock::now();
+    int64_t wallClockNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    uint32_t version = FORMAT_VERSION;
+    uint32_t capacity = EventChunk::CAPACITY;
+    file.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    file.write(reinterpret_cast<const char*>(&capacity), sizeof(capacity));
+    file.write(reinterpret_cast<const char*>(&wallClockNs), sizeof(wallClockNs));
+    
+    eventsWritten = 0;
+    segmentsWritten = 0;
+    writerStop = false;
+    sessionId.store(nextSessionId.fetch_add(1));
+    accepting.store(true);
+    writerThread = std::thread(&EventLog::writerLoop, this);
+    return true;
+}
+
+void EventLog::close() {
+    if (!accepting.exchange(false)) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        
+        // Pairs with the busy/accepting handshake in append(): once accepting is
+        // false, a producer either sees it and backs off or has already raised
+        // busy, in which case we wait for it to finish the record it is writing.
+        for (EventChunk* chunk : activeChunks) {
+            while (chunk->busy.load()) {
+                std::this_thread::yield();
+            }
+            if (chunk->count > 0) {
+                writeQueue.push_back(chunk);
+            } else {
+                freeChunks.push_back(chunk);
+            }
+        }
+        activeChunks.clear();
+        writerStop = true;
+    }
+    writerWakeup.notify_one();
+    
+    if (writerThread.joinable()) {
+        writerThread.join();
+    }
+    file.close();
+}
+
+bool EventLog::isOpen() const {
+    return accepting.load(std::memory_order_relaxed);
+}
+
+void EventLog::append(EventType type, uint32_t intersection, uint8_t approach, uint32_t subject) {
+    if (!accepting.load(std::memory_order_acquire)) {
+        return;
+    }
+    
+    uint64_t session = sessionId.load(std::memory_order_relaxed);
+    ThreadSlot& slot = slotFor(session);
+    if (slot.sessionId != session) {
+        slot.chunk = acquireChunk();
+        slot.sessionId = session;
+    }
+    EventChunk* chunk = slot.chunk;
+    if (chunk == nullptr) {
+        return;
+    }
+    
+    chunk->busy.store(true);
+    if (!accepting.load()) {
+        chunk->busy.store(false);
+        return;
+    }
+    
+    uint32_t i = chunk->count;
+    chunk->timestampNs[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+    chunk->intersection[i] = intersection;
+    chunk->subject[i] = subject;
+    chunk->type[i] = static_cast<uint8_t>(type);
+    chunk->approach[i] = approach;
+    chunk->count = i + 1;
+    bool full = chunk->count == EventChunk::CAPACITY;
+    chunk->busy.store(false, std::memory_order_release);
+    
+    // After busy drops the chunk may belong to close(), so only the local copy is used
+    if (full) {
+        submitChunk(chunk);
+        slot.chunk = acquireChunk();
+    }
+}
+
+EventChunk* EventLog::acquireChunk() {
+    std::lock_guard<std::mutex> lock(poolMutex);
+    if (!accepting.load()) {
+        return nullptr;
+    }
+    
+    EventChunk* chunk;
+    if (!freeChunks.empty()) {
+        chunk = freeChunks.back();
+        freeChunks.pop_back();
+    } else {
+        chunks.push_back(std::make_unique<EventChunk>());
+        chunk = chunks.back().get();
+    }
+    chunk->count = 0;
+    activeChunks.push_back(chunk);
+    return chunk;
+}
+
+void EventLog::submitChunk(EventChunk* chunk) {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        
+        // close() may already have flushed it
+        auto it = std::find(activeChunks.begin(), activeChunks.end(), chunk);
+        if (it == activeChunks.end()) {
+            return;
+        }
+        activeChunks.erase(it);
+        writeQueue.push_back(chunk);
+    }
+    writerWakeup.notify_one();
+}
+
+void EventLog::writerLoop() {
+    std::unique_lock<std::mutex> lock(poolMutex);
+    while (true) {
+        writerWakeup.wait(lock, [this] { return writerStop || !writeQueue.empty(); });
+        if (writeQueue.empty()) {
+            break;  // Stopping and fully drained
+        }
+        
+        EventChunk* chunk = writeQueue.front();
+        writeQueue.pop_front();
+        
+        lock.unlock();
+        writeSegment(*chunk);
+        lock.lock();
+        
+        chunk->count = 0;
+        freeChunks.push_back(chunk);
+    }
+}
+
+void EventLog::writeSegment(const EventChunk& chunk) {
+    uint32_t count = chunk.count;
+    file.write(SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    writeColumn(file, chunk.timestampNs, count);
+    writeColumn(file, chunk.intersection, count);
+    writeColumn(file, chunk.subject, count);
+    writeColumn(file, chunk.type, count);
+    writeColumn(file, chunk.approach, count);
+    
+    eventsWritten += count;
+    segmentsWritten++;
+}
+
+uint64_t EventLog::getEventsWritten() const {
+    return eventsWritten.load();
+}
+
+uint64_t EventLog::getSegmentsWritten() const {
+    return segmentsWritten.load();
+}
+
+bool EventLog::readFile(const std::string& filename, std::vector<LoggedEvent>& events) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open event log " << filename << " for reading.\n";
+        return false;
+    }
+    
+    char magic[8];
+    uint32_t version = 0;
+    uint32_t capacity = 0;
+    int64_t wallClockNs = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&capacity), sizeof(capacity));
+    file.read(reinterpret_cast<char*>(&wallClockNs), sizeof(wallClockNs));
+    if (!file || std::memcmp(magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || version != FORMAT_VERSION) {
+        std::cerr << "Error: " << filename << " is not a version " << FORMAT_VERSION << " event log.\n";
+        return false;
+    }
+    
+    std::vector<int64_t> timestamps;
+    std::vector<uint32_t> intersections;
+    std::vector<uint32_t> subjects;
+    std::vector<uint8_t> types;
+    std::vector<uint8_t> approaches;
+    
+    char segmentMagic[4];
+    uint32_t count = 0;
+    while (file.read(segmentMagic, sizeof(segmentMagic))) {
+        file.read(reinterpret_cast<char*>(&count), sizeof(count));
+        if (!file || std::memcmp(segmentMagic, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) != 0 || count > capacity) {
+            std::cerr << "Error: Corrupt segment in event log " << filename << ".\n";
+            return false;
+        }
+        
+        if (!readColumn(file, timestamps, count) || !readColumn(file, intersections, count) ||
+            !readColumn(file, subjects, count) || !readColumn(file, types, count) ||
+            !readColumn(file, approaches, count)) {
+            std::cerr << "Error: Truncated segment in event log " << filename << ".\n";
+            return false;
+        }
+        
+        for (uint32_t i = 0; i < count; ++i) {
+            events.push_back({timestamps[i], intersections[i], subjects[i],
+                              static_cast<EventType>(types[i]), approaches[i]});
+        }
+    }
+    
+    return true;
+}
\ No newline at end of file
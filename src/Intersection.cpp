@@ -1,14 +1,30 @@
 #include "../include/Intersection.h"
+#include "../include/TraceProfiler.h"
+#include "../include/Checkpoint.h"
 #include <iostream>
 #include <algorithm>
 #include <chrono>
 
+namespace {
+
+double arrivalSeconds(const Vehicle& vehicle) {
+    return std::chrono::duration<double>(vehicle.getArrivalTime().time_since_epoch()).count();
+}
+
+}  // namespace
+
 Intersection::Intersection(const std::string& intersectionId)
-    : id(intersectionId), emergencyMode(false), cycleTime(120), currentPhase(0),
-      redDuration(2), lastUpdate(std::chrono::steady_clock::now()) {
+    : id(intersectionId), signalEmergencyMask(0), queuedMovements(0), queuedArrivalSeconds(0.0), eventLog(nullptr), logIndex(0),
+      activeSet(nullptr), activeIndex(0), networkLoad(nullptr), loadIndex(0),
+      emergencyMode(false), cycleTime(120),
+      currentPhase(0), phaseLength(0), redDuration(2), lastUpdate(std::chrono::steady_clock::now()),
+      ringBarrierActive(false) {
     
     // Initialize vehicle queues for all directions
-    vehicleQueues.resize(4);  // NORTH, SOUTH, EAST, WEST
+    vehicleQueues.resize(MOVEMENT_COUNT);  // Left, through, right for NORTH, SOUTH, EAST, WEST
+    sensorIndex.fill(-1);
+    signalDuration.fill(0);
+    approachCapacity.fill(0);
     
     // Default timing configuration
     greenDuration[Direction::NORTH] = 30;
@@ -20,176 +36,496 @@ Intersection::Intersection(const std::string& intersectionId)
     yellowDuration[Direction::SOUTH] = 5;
     yellowDuration[Direction::EAST] = 5;
     yellowDuration[Direction::WEST] = 5;
+    
+    phaseLength = getPlannedPhaseLength(currentPhase);
+    scheduleNextEvent();
 }
 
 void Intersection::addTrafficLight(Direction dir) {
-    lights.emplace_back(dir, TrafficState::RED);
+    SignalState next = signals;
+    next.set(dir, TrafficState::RED);
+    applySignals(next);
+}
+
+void Intersection::applySignals(SignalState next) {
+    // Approaches whose indication changed start that indication's default countdown
+    uint8_t changed = next.changedFrom(signals);
+    signals = next;
+    for (int i = 0; i < 4; ++i) {
+        if (changed & (1u << i)) {
+            signalDuration[i] = static_cast<int16_t>(TrafficLight::defaultDuration(signals.get(static_cast<Direction>(i))));
+            timers.timeLeft(i) = signalDuration[i];
+        }
+    }
 }
 
 void Intersection::addTrafficSensor(Direction dir) {
+    sensorIndex[static_cast<int>(dir)] = static_cast<int>(sensors.size());
     sensors.emplace_back(dir);
+    scheduleSensorRoll();
 }
 
 void Intersection::configureTiming(Direction dir, int greenTime, int yellowTime) {
     greenDuration[dir] = greenTime;
     yellowDuration[dir] = yellowTime;
+    scheduleNextEvent();  // The current phase's yellow onset may have moved
+}
+
+void Intersection::attachEventLog(EventLog* log, uint32_t index) {
+    eventLog = log;
+    logIndex = index;
+}
+
+void Intersection::attachSignalTimers(SignalTimerTable* table, uint32_t slot) {
+    timers.attach(table, slot);
+}
+
+void Intersection::attachActiveSet(ActiveSet* set, uint32_t index) {
+    activeSet = set;
+    activeIndex = index;
+    if (activeSet && queuedMovements) {
+        activeSet->wake(activeIndex);
+    }
+}
+
+void Intersection::attachNetworkLoad(NetworkLoad* load, uint32_t index) {
+    networkLoad = load;
+    loadIndex = index;
+    if (networkLoad) {
+        networkLoad->set(loadIndex, {getQueueLength(Direction::NORTH), getQueueLength(Direction::SOUTH),
+                                     getQueueLength(Direction::EAST), getQueueLength(Direction::WEST)},
+                         queuedArrivalSeconds);
+    }
+}
+
+void Intersection::setApproachCapacity(Direction dir, int vehicles) {
+    approachCapacity[static_cast<int>(dir)] = static_cast<uint16_t>(std::max(0, std::min(vehicles, 0xFFFF)));
 }
 
-void Intersection::addVehicle(const Vehicle& vehicle) {
-    int dirIndex = static_cast<int>(vehicle.getDirection());
-    if (dirIndex >= 0 && dirIndex < vehicleQueues.size()) {
-        vehicleQueues[dirIndex].push(vehicle);
+bool Intersection::addVehicle(const Vehicle& vehicle) {
+    int movement = vehicle.getMovement();
+    if (movement >= 0 && movement < MOVEMENT_COUNT) {
+        // Emergency vehicles are never turned away
+        if (isApproachFull(vehicle.getDirection()) && !vehicle.isEmergencyVehicle()) {
+            return false;
+        }
+        enqueueVehicle(movement, vehicle);
         
-        // Update sensor count
-        for (auto& sensor : sensors) {
-            if (sensor.getDirection() == vehicle.getDirection()) {
-                sensor.incrementCount();
-                break;
-            }
+        // Update sensor count at the vehicle's own arrival time so replayed
+        // traffic lands in the right detector interval
+        TrafficSensor* sensor = getSensor(vehicle.getDirection());
+        if (sensor) {
+            sensor->recordDetection(vehicle.getArrivalTime());
+            wakeSensorRoll(*sensor);
         }
     }
+    return true;
 }
 
-void Intersection::processVehicleQueues() {
-    for (size_t i = 0; i < vehicleQueues.size(); ++i) {
-        if (!vehicleQueues[i].empty()) {
-            Direction dir = static_cast<Direction>(i);
-            
-            // Find corresponding traffic light
-            auto lightIt = std::find_if(lights.begin(), lights.end(),
-                [dir](const TrafficLight& light) {
-                    return light.getDirection() == dir;
-                });
-            
-            if (lightIt != lights.end() && lightIt->canProceed()) {
-                // Process vehicles when light is green
-                if (!vehicleQueues[i].empty()) {
-                    Vehicle vehicle = vehicleQueues[i].front();
-                    vehicleQueues[i].pop();
-                    
-                    // Mark vehicle as processed
-                    vehicle.markAsPassed();
+size_t Intersection::applyDetections(const DetectionEvent* first, const DetectionEvent* last) {
+    size_t applied = 0;
+    for (const DetectionEvent* event = first; event != last; ++event) {
+        TrafficSensor* sensor = getSensor(event->approach);
+        if (sensor && sensor->getActiveStatus()) {
+            sensor->recordDetection(event->timestamp);
+            wakeSensorRoll(*sensor);
+            applied++;
+        }
+    }
+    return applied;
+}
+
+size_t Intersection::processVehicleQueues() {
+    return dischargeVehicles(nullptr, nullptr, nullptr);
+}
+
+size_t Intersection::processVehicleQueues(std::vector<Vehicle>& departed) {
+    return dischargeVehicles(&departed, nullptr, nullptr);
+}
+
+size_t Intersection::processVehicleQueues(std::vector<Vehicle>& departed, std::array<int32_t, 4>& exitRoom, size_t& held) {
+    return dischargeVehicles(&departed, &exitRoom, &held);
+}
+
+size_t Intersection::dischargeVehicles(std::vector<Vehicle>* departed, std::array<int32_t, 4>* exitRoom, size_t* held) {
+    TRAFFIC_TRACE_SCOPE("Intersection::processVehicleQueues");
+    
+    // Movements into a full exit stay at the stop line and so block nothing else
+    MovementMask blocked = 0;
+    for (int movement = 0; exitRoom && movement < MOVEMENT_COUNT; ++movement) {
+        if ((*exitRoom)[static_cast<int>(turnHeading(movementApproach(movement), movementTurn(movement)))] <= 0) {
+            blocked |= static_cast<MovementMask>(1u << movement);
+        }
+    }
+    
+    // Protected movements discharge a vehicle every second; permitted ones only
+    // while no conflicting protected movement has a vehicle waiting
+    MovementMask protectedGo = getProtectedGreen() & queuedMovements;
+    MovementMask permittedGo = getPermittedGreen() & queuedMovements &
+                               ~ConflictMatrix::instance().conflictsOfSet(protectedGo & ~blocked);
+    
+    size_t discharged = 0;
+    MovementMask go = protectedGo | permittedGo;
+    for (int movement = 0; go; ++movement, go >>= 1) {
+        if (go & 1u) {
+            if (exitRoom) {
+                // Two movements may share an exit with room for only one of them
+                int32_t& room = (*exitRoom)[static_cast<int>(turnHeading(movementApproach(movement), movementTurn(movement)))];
+                if (room <= 0) {
+                    (*held)++;
+                    continue;
                 }
+                room--;
+            }
+            Vehicle vehicle = dequeueVehicle(movement);
+            
+            // Mark vehicle as processed
+            vehicle.markAsPassed();
+            discharged++;
+            if (departed) {
+                departed->push_back(std::move(vehicle));
             }
         }
     }
+    return discharged;
 }
 
 Vehicle Intersection::removeVehicle(Direction dir) {
-    int dirIndex = static_cast<int>(dir);
-    if (dirIndex >= 0 && dirIndex < vehicleQueues.size() && !vehicleQueues[dirIndex].empty()) {
-        Vehicle vehicle = vehicleQueues[dirIndex].front();
-        vehicleQueues[dirIndex].pop();
-        return vehicle;
+    // The approach's longest-waiting vehicle, whatever its turn
+    int oldest = -1;
+    for (int movement = movementIndex(dir, Turn::LEFT); movement <= movementIndex(dir, Turn::RIGHT); ++movement) {
+        if (!vehicleQueues[movement].empty() &&
+            (oldest < 0 || vehicleQueues[movement].front().getArrivalTime() < vehicleQueues[oldest].front().getArrivalTime())) {
+            oldest = movement;
+        }
+    }
+    if (oldest >= 0) {
+        return dequeueVehicle(oldest);
     }
     
     // Return dummy vehicle if queue is empty
     return Vehicle("NONE", VehicleType::CAR, dir);
 }
 
-void Intersection::updateSignals() {
+void Intersection::enqueueVehicle(int movement, const Vehicle& vehicle) {
+    if (!queuedMovements && activeSet) {
+        activeSet->wake(activeIndex);
+    }
+    vehicleQueues[movement].push_back(vehicle);
+    queuedMovements |= static_cast<MovementMask>(1u << movement);
+    queuedArrivalSeconds += arrivalSeconds(vehicle);
+    if (networkLoad) {
+        networkLoad->add(loadIndex, static_cast<int>(movementApproach(movement)), 1, arrivalSeconds(vehicle));
+    }
+    
+    if (eventLog) {
+        eventLog->append(EventType::ARRIVAL, logIndex, static_cast<uint8_t>(vehicle.getDirection()), vehicle.getSerial());
+    }
+}
+
+Vehicle Intersection::dequeueVehicle(int movement) {
+    Vehicle vehicle = vehicleQueues[movement].front();
+    vehicleQueues[movement].pop_front();
+    if (vehicleQueues[movement].empty()) {
+        queuedMovements &= static_cast<MovementMask>(~(1u << movement));
+    }
+    queuedArrivalSeconds -= arrivalSeconds(vehicle);
+    if (networkLoad) {
+        networkLoad->add(loadIndex, static_cast<int>(movementApproach(movement)), -1, arrivalSeconds(vehicle));
+    }
+    
+    if (eventLog) {
+        eventLog->append(EventType::DEPARTURE, logIndex, static_cast<uint8_t>(vehicle.getDirection()), vehicle.getSerial());
+    }
+    
+    // Reset exactly once the intersection drains so rounding never accumulates
+    if (getTotalVehicleCount() == 0) {
+        queuedArrivalSeconds = 0.0;
+    }
+    return vehicle;
+}
+
+bool Intersection::updateSignals() {
+    TRAFFIC_TRACE_SCOPE("Intersection::updateSignals");
+    
     auto now = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - lastUpdate).count();
     
-    if (elapsed >= 1) {  // Update every second
-        // Update all traffic lights
-        for (auto& light : lights) {
-            light.update();
-        }
-        
-        // Check if phase should change
-        if (!emergencyMode) {
-            switchToNextPhase();
-        }
-        
-        lastUpdate = now;
+    bool stepped = elapsed >= 1;
+    if (stepped) {  // Update every second
+        stepSecond(now);
     }
     
     processVehicleQueues();
+    return stepped;
 }
 
-void Intersection::handleEmergencyVehicle(Direction emergencyDir) {
-    emergencyMode = true;
+void Intersection::stepSecond(std::chrono::steady_clock::time_point now) {
+    // Count down every approach's indication
+    for (int i = 0; i < 4; ++i) {
+        if (timers.timeLeft(i) > 0) {
+            timers.timeLeft(i)--;
+        }
+    }
     
-    // Set all lights to red
-    for (auto& light : lights) {
-        light.activateEmergency();
-        light.changeState(TrafficState::RED);
+    // SignalTimerTable::advance does the same for a whole table
+    timers.phaseTimer()++;
+    completeSecond(now);
+    lastUpdate = now;
+}
+
+void Intersection::completeSecond(std::chrono::steady_clock::time_point now) {
+    // Check if phase should change
+    if (timers.phaseTimer() >= timers.nextEvent()) {
+        switchToNextPhase();
     }
     
-    // Set emergency direction to green
-    for (auto& light : lights) {
-        if (light.getDirection() == emergencyDir) {
-            light.changeState(TrafficState::GREEN);
-            break;
+    if (SignalTimerTable::toTicks(now) >= timers.sensorRollAt()) {
+        rollSensorWindows(now);
+    }
+}
+
+void Intersection::rollSensorWindows(std::chrono::steady_clock::time_point now) {
+    // Roll sensor windows so idle approaches decay towards zero flow
+    for (auto& sensor : sensors) {
+        sensor.advanceWindow(now);
+    }
+    scheduleSensorRoll();
+}
+
+void Intersection::scheduleSensorRoll() {
+    // Detections only move a sensor's interval end later, so the earliest one
+    // stays a safe wakeup; rolling a sensor that isn't due is a no-op. Sensors
+    // at rest aren't rolled at all until a detection wakes them.
+    int64_t earliest = INT64_MAX;
+    for (const auto& sensor : sensors) {
+        if (!sensor.isAtRest()) {
+            earliest = std::min(earliest, SignalTimerTable::toTicks(sensor.getIntervalEnd()));
         }
     }
+    timers.sensorRollAt() = earliest;
+}
+
+void Intersection::wakeSensorRoll(const TrafficSensor& sensor) {
+    int64_t due = SignalTimerTable::toTicks(sensor.getIntervalEnd());
+    if (due < timers.sensorRollAt()) {
+        timers.sensorRollAt() = due;
+    }
+}
+
+void Intersection::scheduleNextEvent() {
+    // While green shows, the next change is the yellow onset; after it, the end of the phase.
+    // Emergency operation holds the lights, and the phase timer restarts when it ends.
+    // Actuated ring-and-barrier phasing looks at its queues every second.
+    int32_t& nextEvent = timers.nextEvent();
+    if (emergencyMode) {
+        nextEvent = SignalTimerTable::NO_EVENT;
+    } else if (ringBarrierActive) {
+        nextEvent = timers.phaseTimer() + 1;
+    } else if (signals.proceedMask() && timers.phaseTimer() < phaseLength) {
+        nextEvent = phaseLength - getPlannedYellow(currentPhase);
+    } else {
+        nextEvent = phaseLength;
+    }
+}
+
+void Intersection::handleEmergencyVehicle(Direction emergencyDir) {
+    emergencyMode = true;
+    
+    if (eventLog) {
+        eventLog->append(EventType::PREEMPTION, logIndex, static_cast<uint8_t>(emergencyDir), 0);
+    }
+    
+    // All lights red except the emergency direction, which turns green
+    SignalState next = signals;
+    next.setPhase(static_cast<uint8_t>(1u << static_cast<int>(emergencyDir)));
+    signals = SignalState();  // Preemption restarts every approach's countdown
+    applySignals(next);
+    signalEmergencyMask = signals.present();
+    scheduleNextEvent();
 }
 
 void Intersection::normalOperation() {
+    if (emergencyMode && eventLog) {
+        eventLog->append(EventType::PREEMPTION_END, logIndex, 0, 0);
+    }
     emergencyMode = false;
     
     // Deactivate emergency mode for all lights
-    for (auto& light : lights) {
-        light.deactivateEmergency();
-    }
+    signalEmergencyMask = 0;
     
     // Resume normal cycle
     currentPhase = 0;
+    timers.phaseTimer() = 0;
+    phaseLength = getPlannedPhaseLength(currentPhase);
+    if (ringBarrierActive) {
+        ringBarrier.restart();
+        applyRingBarrierSignals();
+    }
+    scheduleNextEvent();
 }
 
 void Intersection::switchToNextPhase() {
+    if (ringBarrierActive) {
+        advanceRingBarrier();
+        return;
+    }
+    
     // Simple 4-phase operation: North-South, then East-West
-    static int phaseTimer = 0;
-    phaseTimer++;
+    int32_t& phaseTimer = timers.phaseTimer();
     
-    if (phaseTimer >= 35) {  // 35 seconds per phase (30 green + 5 yellow)
+    if (phaseTimer >= phaseLength) {  // Phase plan: longest green + yellow of the approaches served
         currentPhase = (currentPhase + 1) % 2;  // Toggle between 0 and 1
         phaseTimer = 0;
+        phaseLength = getPlannedPhaseLength(currentPhase);
         
-        if (currentPhase == 0) {
-            // North-South Green, East-West Red
-            for (auto& light : lights) {
-                if (light.getDirection() == Direction::NORTH || 
-                    light.getDirection() == Direction::SOUTH) {
-                    light.changeState(TrafficState::GREEN);
-                } else {
-                    light.changeState(TrafficState::RED);
-                }
-            }
-        } else {
-            // East-West Green, North-South Red
-            for (auto& light : lights) {
-                if (light.getDirection() == Direction::EAST || 
-                    light.getDirection() == Direction::WEST) {
-                    light.changeState(TrafficState::GREEN);
-                } else {
-                    light.changeState(TrafficState::RED);
-                }
-            }
+        if (eventLog) {
+            eventLog->append(EventType::PHASE_CHANGE, logIndex, 0, static_cast<uint32_t>(currentPhase));
         }
-    } else if (phaseTimer == 30) {
-        // Change to yellow 5 seconds before phase change
-        for (auto& light : lights) {
-            if (light.getState() == TrafficState::GREEN) {
-                light.changeState(TrafficState::YELLOW);
-            }
+        
+        // Phase 0: North-South Green, East-West Red. Phase 1: the reverse.
+        SignalState next = signals;
+        next.setPhase(IntersectionFork::phaseGreenMask(currentPhase));
+        applySignals(next);
+    } else {
+        // Change to yellow ahead of the phase change
+        SignalState next = signals;
+        next.greenToYellow();
+        applySignals(next);
+    }
+    
+    scheduleNextEvent();
+}
+
+void Intersection::advanceRingBarrier() {
+    // Phase timer and current phase follow the barrier: group 0 is N-S, group 1 is E-W
+    if (ringBarrier.step(queuedMovements)) {
+        currentPhase = ringBarrier.getBarrierGroup();
+        timers.phaseTimer() = 0;
+        
+        if (eventLog) {
+            eventLog->append(EventType::PHASE_CHANGE, logIndex, 0, static_cast<uint32_t>(currentPhase));
         }
     }
+    
+    applyRingBarrierSignals();
+    scheduleNextEvent();
+}
+
+void Intersection::applyRingBarrierSignals() {
+    // An approach head shows green if any of its movements may go, yellow if one is clearing
+    uint8_t green = movementApproaches(ringBarrier.getProtectedGreen() | ringBarrier.getPermittedGreen());
+    uint8_t yellow = movementApproaches(ringBarrier.getYellow()) & ~green;
+    
+    SignalState next = signals;
+    next.setPhase(green);
+    next.set(static_cast<uint8_t>(yellow & next.present()), TrafficState::YELLOW);
+    applySignals(next);
+}
+
+bool Intersection::setRingBarrierPlan(const RingBarrierPlan& plan, std::string& error) {
+    if (!plan.validate(error)) {
+        return false;
+    }
+    if (movementApproaches(plan.servedMovements()) & ~signals.present()) {
+        error = "Plan serves an approach without a signal head";
+        return false;
+    }
+    
+    ringBarrier = RingBarrierState(plan);
+    ringBarrierActive = true;
+    currentPhase = 0;
+    timers.phaseTimer() = 0;
+    if (!emergencyMode) {
+        applyRingBarrierSignals();
+    }
+    scheduleNextEvent();
+    return true;
+}
+
+void Intersection::clearRingBarrierPlan() {
+    if (!ringBarrierActive) {
+        return;
+    }
+    ringBarrierActive = false;
+    ringBarrier = RingBarrierState();
+    
+    currentPhase = 0;
+    timers.phaseTimer() = 0;
+    phaseLength = getPlannedPhaseLength(currentPhase);
+    if (!emergencyMode) {
+        SignalState next = signals;
+        next.setPhase(IntersectionFork::phaseGreenMask(currentPhase));
+        applySignals(next);
+    }
+    scheduleNextEvent();
+}
+
+bool Intersection::hasRingBarrierPlan() const {
+    return ringBarrierActive;
+}
+
+const RingBarrierState& Intersection::getRingBarrier() const {
+    return ringBarrier;
+}
+
+MovementMask Intersection::getProtectedGreen() const {
+    if (ringBarrierActive && !emergencyMode) {
+        return ringBarrier.getProtectedGreen();
+    }
+    
+    // Two-phase cycle: a green approach has right of way for through and right
+    // turns, its lefts yield. Under preemption the green approach clears outright.
+    MovementMask green = approachMaskMovements(signals.proceedMask());
+    return emergencyMode ? green : static_cast<MovementMask>(green & ~turnMovements(Turn::LEFT));
+}
+
+MovementMask Intersection::getPermittedGreen() const {
+    if (ringBarrierActive && !emergencyMode) {
+        return ringBarrier.getPermittedGreen();
+    }
+    if (emergencyMode) {
+        return 0;
+    }
+    return approachMaskMovements(signals.proceedMask()) & turnMovements(Turn::LEFT);
 }
 
 std::string Intersection::getId() const {
     return id;
 }
 
-std::vector<TrafficLight>& Intersection::getLights() {
-    return lights;
+std::vector<TrafficLight> Intersection::getLights() const {
+    std::vector<TrafficLight> views;
+    for (int i = 0; i < 4; ++i) {
+        if (signals.has(static_cast<Direction>(i))) {
+            views.push_back(getLight(static_cast<Direction>(i)));
+        }
+    }
+    return views;
+}
+
+TrafficLight Intersection::getLight(Direction dir) const {
+    int i = static_cast<int>(dir);
+    return TrafficLight(dir, signals.get(dir), signalDuration[i], timers.timeLeft(i),
+                        (signalEmergencyMask >> i) & 1u);
+}
+
+SignalState Intersection::getSignalState() const {
+    return signals;
 }
 
 std::vector<TrafficSensor>& Intersection::getSensors() {
     return sensors;
 }
 
+TrafficSensor* Intersection::getSensor(Direction dir) {
+    int dirIndex = static_cast<int>(dir);
+    if (dirIndex < 0 || dirIndex >= static_cast<int>(sensorIndex.size()) || sensorIndex[dirIndex] < 0) {
+        return nullptr;
+    }
+    return &sensors[sensorIndex[dirIndex]];
+}
+
 bool Intersection::isEmergencyMode() const {
     return emergencyMode;
 }
@@ -198,33 +534,108 @@ int Intersection::getCurrentPhase() const {
     return currentPhase;
 }
 
+int Intersection::getPhaseTimer() const {
+    return timers.phaseTimer();
+}
+
+int Intersection::getPhaseLength() const {
+    return phaseLength;
+}
+
+void Intersection::setPhaseLength(int seconds) {
+    // A phase can be cut short, but never below what has already elapsed plus its yellow
+    phaseLength = std::max(seconds, timers.phaseTimer() + 1 + getPlannedYellow(currentPhase));
+    scheduleNextEvent();
+}
+
+int Intersection::getCycleLength() const {
+    return getPlannedPhaseLength(0) + getPlannedPhaseLength(1);
+}
+
+int Intersection::getCyclePosition() const {
+    return currentPhase == 0 ? timers.phaseTimer() : getPlannedPhaseLength(0) + timers.phaseTimer();
+}
+
+void Intersection::setCyclePosition(int second) {
+    // Offsets apply to the two-phase cycle; actuated and preempted operation have none
+    if (ringBarrierActive || emergencyMode) {
+        return;
+    }
+    
+    int cycle = getCycleLength();
+    int position = ((second % cycle) + cycle) % cycle;
+    currentPhase = position < getPlannedPhaseLength(0) ? 0 : 1;
+    timers.phaseTimer() = currentPhase == 0 ? position : position - getPlannedPhaseLength(0);
+    phaseLength = getPlannedPhaseLength(currentPhase);
+    
+    SignalState next = signals;
+    next.setPhase(IntersectionFork::phaseGreenMask(currentPhase));
+    if (timers.phaseTimer() >= phaseLength - getPlannedYellow(currentPhase)) {
+        next.greenToYellow();
+    }
+    applySignals(next);
+    scheduleNextEvent();
+}
+
+void Intersection::setPlanSchedule(std::shared_ptr<const PlanSchedule> schedule) {
+    planSchedule = std::move(schedule);
+}
+
+const std::shared_ptr<const PlanSchedule>& Intersection::getPlanSchedule() const {
+    return planSchedule;
+}
+
+int Intersection::getPlannedPhaseLength(int phase) const {
+    Direction first = phase == 0 ? Direction::NORTH : Direction::EAST;
+    Direction second = phase == 0 ? Direction::SOUTH : Direction::WEST;
+    return std::max(greenDuration.at(first), greenDuration.at(second)) + getPlannedYellow(phase);
+}
+
+int Intersection::getPlannedYellow(int phase) const {
+    Direction first = phase == 0 ? Direction::NORTH : Direction::EAST;
+    Direction second = phase == 0 ? Direction::SOUTH : Direction::WEST;
+    return std::max(yellowDuration.at(first), yellowDuration.at(second));
+}
+
 int Intersection::getQueueLength(Direction dir) const {
     int dirIndex = static_cast<int>(dir);
-    if (dirIndex >= 0 && dirIndex < vehicleQueues.size()) {
-        return vehicleQueues[dirIndex].size();
+    if (dirIndex < 0 || dirIndex >= 4) {
+        return 0;
     }
-    return 0;
+    int total = 0;
+    for (int turn = 0; turn < 3; ++turn) {
+        total += vehicleQueues[dirIndex * 3 + turn].size();
+    }
+    return total;
 }
 
-std::queue<Vehicle>& Intersection::getQueue(Direction dir) {
-    int dirIndex = static_cast<int>(dir);
-    return vehicleQueues[dirIndex];
+int Intersection::getMovementQueueLength(Direction dir, Turn turn) const {
+    return vehicleQueues[movementIndex(dir, turn)].size();
+}
+
+const std::deque<Vehicle>& Intersection::getQueue(Direction dir, Turn turn) const {
+    return vehicleQueues[movementIndex(dir, turn)];
 }
 
 double Intersection::getAverageWaitTime() const {
-    double totalWaitTime = 0.0;
-    int totalVehicles = 0;
-    
-    for (const auto& queue : vehicleQueues) {
-        std::queue<Vehicle> tempQueue = queue;
-        while (!tempQueue.empty()) {
-            totalWaitTime += tempQueue.front().getWaitTime();
-            totalVehicles++;
-            tempQueue.pop();
-        }
+    // Mean wait = now - mean arrival time, kept up to date on every enqueue/dequeue
+    int totalVehicles = getTotalVehicleCount();
+    if (totalVehicles == 0) {
+        return 0.0;
     }
     
-    return totalVehicles > 0 ? totalWaitTime / totalVehicles : 0.0;
+    double nowSeconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return nowSeconds - queuedArrivalSeconds / totalVehicles;
+}
+
+int Intersection::getApproachCapacity(Direction dir) const {
+    return approachCapacity[static_cast<int>(dir)];
+}
+
+bool Intersection::isApproachFull(Direction dir) const {
+    int capacity = approachCapacity[static_cast<int>(dir)];
+    return capacity > 0 && getQueueLength(dir) >= capacity;
 }
 
 int Intersection::getTotalVehicleCount() const {
@@ -235,30 +646,194 @@ int Intersection::getTotalVehicleCount() const {
     return total;
 }
 
+bool Intersection::hasQueuedVehicles() const {
+    return queuedMovements != 0;
+}
+
 void Intersection::clearQueues() {
     for (auto& queue : vehicleQueues) {
-        while (!queue.empty()) {
-            queue.pop();
+        queue.clear();
+    }
+    queuedMovements = 0;
+    queuedArrivalSeconds = 0.0;
+    if (networkLoad) {
+        networkLoad->set(loadIndex, {0, 0, 0, 0}, 0.0);
+    }
+}
+
+void Intersection::shiftArrivalTimes(std::chrono::steady_clock::duration by) {
+    for (auto& queue : vehicleQueues) {
+        for (auto& vehicle : queue) {
+            vehicle.setArrivalTime(vehicle.getArrivalTime() + by);
+        }
+    }
+    queuedArrivalSeconds += std::chrono::duration<double>(by).count() * getTotalVehicleCount();
+    if (networkLoad) {
+        networkLoad->set(loadIndex, {getQueueLength(Direction::NORTH), getQueueLength(Direction::SOUTH),
+                                     getQueueLength(Direction::EAST), getQueueLength(Direction::WEST)},
+                         queuedArrivalSeconds);
+    }
+}
+
+IntersectionFork Intersection::fork(std::chrono::steady_clock::time_point now) const {
+    auto base = std::make_shared<IntersectionForkBase>();
+    for (int phase = 0; phase < 2; ++phase) {
+        base->phaseLength[phase] = getPlannedPhaseLength(phase);
+        base->yellowSeconds[phase] = getPlannedYellow(phase);
+    }
+    
+    for (int i = 0; i < 4; ++i) {
+        // Demand forecast from the smoothed detector flow
+        const TrafficSensor* sensor = sensorIndex[i] >= 0 ? &sensors[sensorIndex[i]] : nullptr;
+        base->arrivalRate[i] = sensor ? sensor->getFlowRate() / 60.0 : 0.0;
+        
+        // The fork models approaches, so the approach's movement queues are pooled
+        auto& forked = base->queues[i];
+        forked.reserve(getQueueLength(static_cast<Direction>(i)));
+        for (int turn = 0; turn < 3; ++turn) {
+            for (const auto& vehicle : vehicleQueues[i * 3 + turn]) {
+                float waited = std::chrono::duration<float>(now - vehicle.getArrivalTime()).count();
+                forked.push_back({std::max(0.0f, waited), std::max(1, vehicle.getPriority()) / 10.0f});  // Car = 1
+            }
         }
     }
+    
+    // Emergency operation holds its lights; the fork keeps them until the phase ends
+    return IntersectionFork(base, currentPhase, timers.phaseTimer(), phaseLength, signals.proceedMask());
+}
+
+void Intersection::captureSnapshot(IntersectionSnapshot& out) const {
+    out.id = id;
+    out.emergencyMode = emergencyMode;
+    out.currentPhase = currentPhase;
+    
+    out.lights.clear();
+    for (int i = 0; i < 4; ++i) {
+        Direction dir = static_cast<Direction>(i);
+        if (signals.has(dir)) {
+            out.lights.push_back({dir, signals.get(dir), timers.timeLeft(i)});
+        }
+    }
+    
+    for (int i = 0; i < 4; ++i) {
+        out.queueLengths[i] = getQueueLength(static_cast<Direction>(i));
+    }
+    out.averageWaitTime = getAverageWaitTime();
 }
 
 void Intersection::displayStatus() const {
-    std::cout << "\n=== Intersection " << id << " Status ===\n";
-    std::cout << "Emergency Mode: " << (emergencyMode ? "YES" : "NO") << "\n";
-    std::cout << "Current Phase: " << currentPhase << "\n";
+    IntersectionSnapshot snapshot;
+    captureSnapshot(snapshot);
+    snapshot.display();
+}
+
+void Intersection::writeCheckpoint(CheckpointWriter& out) const {
+    out.putString(id);
+    out.put(static_cast<uint8_t>(emergencyMode));
+    out.put(static_cast<int32_t>(cycleTime));
+    out.put(static_cast<int32_t>(currentPhase));
+    out.put(static_cast<int32_t>(timers.phaseTimer()));
+    out.put(static_cast<int32_t>(phaseLength));
+    out.put(static_cast<int32_t>(redDuration));
+    out.putTime(lastUpdate);
     
-    std::cout << "\nTraffic Lights:\n";
-    for (const auto& light : lights) {
-        std::cout << "  " << light.getDirectionString() << ": " 
-                  << light.getStateString() << " (" << light.getTimeLeft() << "s)\n";
+    for (int i = 0; i < 4; ++i) {
+        Direction dir = static_cast<Direction>(i);
+        out.put(static_cast<int32_t>(greenDuration.at(dir)));
+        out.put(static_cast<int32_t>(yellowDuration.at(dir)));
     }
+    out.put(approachCapacity);
     
-    std::cout << "\nVehicle Queues:\n";
-    const std::string directions[] = {"NORTH", "SOUTH", "EAST", "WEST"};
+    out.put(signals.raw());
+    out.put(signalDuration);
     for (int i = 0; i < 4; ++i) {
-        std::cout << "  " << directions[i] << ": " << vehicleQueues[i].size() << " vehicles\n";
+        out.put(timers.timeLeft(i));
+    }
+    out.put(signalEmergencyMask);
+    out.put(static_cast<uint8_t>(ringBarrierActive));
+    if (ringBarrierActive) {
+        ringBarrier.writeCheckpoint(out);
+    }
+    
+    out.put(static_cast<uint32_t>(sensors.size()));
+    for (const auto& sensor : sensors) {
+        sensor.writeCheckpoint(out);
     }
     
-    std::cout << "Average Wait Time: " << getAverageWaitTime() << " seconds\n";
+    for (const auto& queue : vehicleQueues) {
+        out.put(static_cast<uint32_t>(queue.size()));
+        for (const auto& vehicle : queue) {
+            vehicle.writeCheckpoint(out);
+        }
+    }
+}
+
+void Intersection::readCheckpoint(CheckpointReader& in) {
+    id = in.getString();
+    emergencyMode = in.get<uint8_t>() != 0;
+    cycleTime = in.get<int32_t>();
+    currentPhase = in.get<int32_t>();
+    timers.phaseTimer() = in.get<int32_t>();
+    phaseLength = in.get<int32_t>();
+    redDuration = in.get<int32_t>();
+    lastUpdate = in.getTime();
+    
+    for (int i = 0; i < 4; ++i) {
+        Direction dir = static_cast<Direction>(i);
+        greenDuration[dir] = in.get<int32_t>();
+        yellowDuration[dir] = in.get<int32_t>();
+    }
+    approachCapacity = in.get<std::array<uint16_t, 4>>();
+    
+    signals = SignalState(in.get<uint32_t>());
+    signalDuration = in.get<std::array<int16_t, 4>>();
+    for (int i = 0; i < 4; ++i) {
+        timers.timeLeft(i) = in.get<int16_t>();
+    }
+    signalEmergencyMask = in.get<uint8_t>();
+    if (signals.raw() >> (SignalState::STATE_COUNT * 4)) {
+        in.fail();
+    }
+    ringBarrierActive = in.get<uint8_t>() != 0;
+    ringBarrier = RingBarrierState();
+    if (ringBarrierActive) {
+        ringBarrier.readCheckpoint(in);
+    }
+    scheduleNextEvent();
+    
+    sensors.clear();
+    sensorIndex.fill(-1);
+    uint32_t sensorCount = in.getCount(1);
+    for (uint32_t i = 0; i < sensorCount && in.ok(); ++i) {
+        sensors.emplace_back(Direction::NORTH);
+        sensors.back().readCheckpoint(in);
+        sensorIndex[static_cast<int>(sensors.back().getDirection())] = static_cast<int>(i);
+    }
+    scheduleSensorRoll();
+    
+    // Queues are rebuilt directly: restored vehicles are not new arrivals
+    queuedArrivalSeconds = 0.0;
+    queuedMovements = 0;
+    for (int movement = 0; movement < MOVEMENT_COUNT; ++movement) {
+        auto& queue = vehicleQueues[movement];
+        queue.clear();
+        uint32_t count = in.getCount(1);
+        for (uint32_t i = 0; i < count && in.ok(); ++i) {
+            Vehicle vehicle("", VehicleType::CAR, Direction::NORTH);
+            vehicle.readCheckpoint(in);
+            if (vehicle.getMovement() != movement) {
+                in.fail();
+            }
+            queuedArrivalSeconds += arrivalSeconds(vehicle);
+            queue.push_back(vehicle);
+        }
+        if (!queue.empty()) {
+            queuedMovements |= static_cast<MovementMask>(1u << movement);
+        }
+    }
+    if (networkLoad) {
+        networkLoad->set(loadIndex, {getQueueLength(Direction::NORTH), getQueueLength(Direction::SOUTH),
+                                     getQueueLength(Direction::EAST), getQueueLength(Direction::WEST)},
+                         queuedArrivalSeconds);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include "../include/IntersectionFork.h"
+#include <algorithm>
+#include <utility>
+
+IntersectionFork::IntersectionFork(std::shared_ptr<const IntersectionForkBase> sharedBase, int phase,
+                                   int timer, int length, uint8_t green)
+    : base(std::move(sharedBase)), greenMask(green), currentPhase(phase), phaseTimer(timer),
+      phaseLength(length), elapsedSeconds(0), cost(0.0) {
+    discharged.fill(0);
+    predictedQueue.fill(0.0);
+}
+
+uint8_t IntersectionFork::phaseGreenMask(int phase) {
+    // Phase 0 serves North/South, phase 1 East/West (see Intersection::switchToNextPhase)
+    return phase == 0 ? 0x3 : 0xC;
+}
+
+double IntersectionFork::departureCost(const ForkedVehicle& vehicle, const ForkCostModel& model) const {
+    double wait = vehicle.waitedSeconds + elapsedSeconds;
+    double over = std::max(0.0, wait - model.maxWaitSeconds);
+    return vehicle.weight * (elapsedSeconds + over * model.starvationWeight);
+}
+
+void IntersectionFork::step(const ForkCostModel& model) {
+    elapsedSeconds++;
+    
+    // Signal timing
+    phaseTimer++;
+    if (phaseTimer >= phaseLength) {
+        currentPhase = (currentPhase + 1) % 2;
+        phaseTimer = 0;
+        phaseLength = base->phaseLength[currentPhase];
+        greenMask = phaseGreenMask(currentPhase);
+    } else if (phaseTimer == phaseLength - base->yellowSeconds[currentPhase]) {
+        greenMask = 0;  // Yellow doesn't discharge
+    }
+    
+    for (int i = 0; i < 4; ++i) {
+        predictedQueue[i] += base->arrivalRate[i];
+        
+        if (greenMask & (1u << i)) {
+            // Vehicles queued at fork time leave first, then predicted arrivals
+            double capacity = model.saturationFlow;
+            const auto& queue = base->queues[i];
+            while (capacity >= 1.0 && discharged[i] < queue.size()) {
+                cost += departureCost(queue[discharged[i]], model);
+                discharged[i]++;
+                capacity -= 1.0;
+            }
+            predictedQueue[i] -= std::min(capacity, predictedQueue[i]);
+        }
+        
+        // Predicted arrivals accumulate delay as a fluid queue
+        cost += predictedQueue[i];
+    }
+}
+
+void IntersectionFork::run(int seconds, const ForkCostModel& model) {
+    for (int s = 0; s < seconds; ++s) {
+        step(model);
+    }
+}
+
+void IntersectionFork::setPhaseLength(int seconds) {
+    phaseLength = seconds;
+}
+
+int IntersectionFork::getCurrentPhase() const {
+    return currentPhase;
+}
+
+int IntersectionFork::getPhaseTimer() const {
+    return phaseTimer;
+}
+
+int IntersectionFork::getPhaseLength() const {
+    return phaseLength;
+}
+
+int IntersectionFork::getElapsedSeconds() const {
+    return elapsedSeconds;
+}
+
+int IntersectionFork::getYellowSeconds() const {
+    return base->yellowSeconds[currentPhase];
+}
+
+double IntersectionFork::getQueuedVehicles() const {
+    double total = 0.0;
+    for (int i = 0; i < 4; ++i) {
+        total += (base->queues[i].size() - discharged[i]) + predictedQueue[i];
+    }
+    return total;
+}
+
+double IntersectionFork::getCost(const ForkCostModel& model) const {
+    // Vehicles still queued at the horizon are charged as if they left now
+    double total = cost;
+    for (int i = 0; i < 4; ++i) {
+        const auto& queue = base->queues[i];
+        for (size_t v = discharged[i]; v < queue.size(); ++v) {
+            total += departureCost(queue[v], model);
+        }
+    }
+    return total;
+}
\ No newline at end of file
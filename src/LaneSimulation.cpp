@@ -0,0 +1,309 @@
+#include "../include/LaneSimulation.h"
+#include "../include/TraceProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+namespace {
+
+const float MOVING_SPEED = 3.0f;    // A stopped vehicle counts as moving again above this
+const float STOPPED_SPEED = 0.5f;   // ... and a moving one as stopped below this
+const float FREE_ROAD = 1.0e4f;     // Distance to a leader that is not there
+
+struct IdmCoefficients {
+    float maxAcceleration;
+    float inverseDesiredSpeed;
+    float minGap;
+    float timeHeadway;
+    float inverseTwoRootAb;         // 1 / (2 sqrt(a b))
+    float vehicleLength;
+};
+
+inline float idmAcceleration(float position, float speed, float leaderPosition, float leaderSpeed,
+                             const IdmCoefficients& c) {
+    float gap = std::max(leaderPosition - position - c.vehicleLength, 0.1f);
+    float desiredGap = c.minGap + std::max(0.0f, speed * c.timeHeadway + speed * (speed - leaderSpeed) * c.inverseTwoRootAb);
+    float ratio = speed * c.inverseDesiredSpeed;
+    ratio *= ratio;
+    float interaction = desiredGap / gap;
+    return c.maxAcceleration * (1.0f - ratio * ratio - interaction * interaction);
+}
+
+// Every vehicle but the first follows the one before it: no branches, no
+// gathers, so this compiles to packed SIMD arithmetic
+void followLeaders(const float* position, const float* speed, float* acceleration, uint32_t count,
+                   const IdmCoefficients& c) {
+    for (uint32_t i = 1; i < count; ++i) {
+        acceleration[i] = idmAcceleration(position[i], speed[i], position[i - 1], speed[i - 1], c);
+    }
+}
+
+// Ballistic update; a vehicle that would reverse stops instead
+void integrateLane(float* position, float* speed, const float* acceleration, uint32_t count, float dt) {
+    for (uint32_t i = 0; i < count; ++i) {
+        float v = speed[i];
+        float next = std::max(0.0f, v + acceleration[i] * dt);
+        position[i] += 0.5f * (v + next) * dt;
+        speed[i] = next;
+    }
+}
+
+// Stops, with hysteresis, as arithmetic on 0/1 floats. Kept out of
+// integrateLane: with five arrays in one loop GCC no longer vectorizes it.
+void countStops(const float* speed, float* stops, float* moving, uint32_t count) {
+    for (uint32_t i = 0; i < count; ++i) {
+        float started = speed[i] > MOVING_SPEED ? 1.0f : 0.0f;
+        float stopped = speed[i] < STOPPED_SPEED ? 1.0f : 0.0f;
+        float was = moving[i];
+        float now = started + (1.0f - started - stopped) * was;
+        stops[i] += was * (1.0f - now);
+        moving[i] = now;
+    }
+}
+
+IdmCoefficients coefficientsFor(const IdmParameters& idm) {
+    IdmCoefficients c;
+    c.maxAcceleration = idm.maxAcceleration;
+    c.inverseDesiredSpeed = 1.0f / std::max(0.1f, idm.desiredSpeed);
+    c.minGap = idm.minGap;
+    c.timeHeadway = idm.timeHeadway;
+    c.inverseTwoRootAb = 1.0f / (2.0f * std::sqrt(std::max(0.01f, idm.maxAcceleration * idm.comfortDeceleration)));
+    c.vehicleLength = idm.vehicleLength;
+    return c;
+}
+
+}  // namespace
+
+LaneSimulation::LaneSimulation(const std::vector<const Intersection*>& signalSources, const LaneRunConfig& runConfig)
+    : config(runConfig) {
+    config.stepsPerSecond = std::max(1, config.stepsPerSecond);
+    signals.reserve(signalSources.size());
+    for (const Intersection* source : signalSources) {
+        signals.push_back(*source);
+        signals.back().attachEventLog(nullptr, 0);     // The copy's signal changes are not the network's
+        signals.back().attachActiveSet(nullptr, 0);
+        signals.back().attachNetworkLoad(nullptr, 0);
+    }
+}
+
+int32_t LaneSimulation::addLane(const LaneSpec& spec) {
+    Lane lane;
+    lane.spec = spec;
+    lane.spec.lengthMeters = std::max(spec.lengthMeters, config.idm.vehicleLength + config.idm.minGap);
+    lane.stopAtLine = false;
+    lane.yellowAtLine = false;
+    lane.committed = false;
+    lane.head = 0;
+    lane.pending = 0;
+    lanes.push_back(std::move(lane));
+    return static_cast<int32_t>(lanes.size() - 1);
+}
+
+void LaneSimulation::readSignals() {
+    for (Lane& lane : lanes) {
+        lane.stopAtLine = false;
+        lane.yellowAtLine = false;
+        if (lane.spec.signal < 0) {
+            continue;
+        }
+        SignalState state = signals[lane.spec.signal].getSignalState();
+        if (!state.has(lane.spec.approach)) {
+            continue;   // No signal head: nothing to stop for
+        }
+        TrafficState shown = state.get(lane.spec.approach);
+        lane.stopAtLine = shown == TrafficState::RED || shown == TrafficState::YELLOW;
+        lane.yellowAtLine = shown == TrafficState::YELLOW;
+        if (!lane.stopAtLine) {
+            lane.committed = false;
+        }
+    }
+}
+
+void LaneSimulation::computeAccelerations() {
+    const IdmCoefficients c = coefficientsFor(config.idm);
+    for (Lane& lane : lanes) {
+        uint32_t count = lane.size();
+        if (count == 0) {
+            continue;
+        }
+        const float* position = lane.position.data() + lane.head;
+        const float* speed = lane.speed.data() + lane.head;
+        float* acceleration = lane.acceleration.data() + lane.head;
+        followLeaders(position, speed, acceleration, count, c);
+        
+        // The front vehicle follows the tail of the next lane, if any, and the stop line
+        float leaderPosition = position[0] + FREE_ROAD;
+        float leaderSpeed = config.idm.desiredSpeed;
+        if (lane.spec.next >= 0 && lanes[lane.spec.next].size() > 0) {
+            const Lane& next = lanes[lane.spec.next];
+            leaderPosition = lane.spec.lengthMeters + next.position.back();
+            leaderSpeed = next.speed.back();
+        }
+        float front = idmAcceleration(position[0], speed[0], leaderPosition, leaderSpeed, c);
+        if (lane.stopAtLine && !lane.committed) {
+            // On yellow, a vehicle too close to stop comfortably goes on through
+            float toLine = lane.spec.lengthMeters - position[0];
+            if (lane.yellowAtLine && speed[0] * speed[0] > 2.0f * config.idm.comfortDeceleration * toLine) {
+                lane.committed = true;
+            } else {
+                front = std::min(front, idmAcceleration(position[0], speed[0], lane.spec.lengthMeters + c.vehicleLength, 0.0f, c));
+            }
+        }
+        acceleration[0] = front;
+    }
+}
+
+void LaneSimulation::integrate(float dt) {
+    for (Lane& lane : lanes) {
+        uint32_t count = lane.size();
+        if (count > 0) {
+            integrateLane(lane.position.data() + lane.head, lane.speed.data() + lane.head,
+                          lane.acceleration.data() + lane.head, count, dt);
+            countStops(lane.speed.data() + lane.head, lane.stops.data() + lane.head, lane.moving.data() + lane.head, count);
+        }
+    }
+}
+
+void LaneSimulation::moveAcrossStopLines(float now, LaneRunResult& result) {
+    for (Lane& lane : lanes) {
+        while (lane.head < lane.position.size() && lane.position[lane.head] >= lane.spec.lengthMeters) {
+            uint32_t i = lane.head++;
+            result.stopLineCrossings++;
+            lane.committed = false;
+            if (lane.spec.next >= 0) {
+                append(lanes[lane.spec.next], lane.position[i] - lane.spec.lengthMeters, lane.speed[i], lane.entered[i],
+                       lane.stops[i], lane.moving[i]);
+            } else {
+                result.vehiclesLeft++;
+                result.travelSeconds += now - lane.entered[i];
+                result.stops += lane.stops[i];
+            }
+        }
+        compact(lane);
+    }
+}
+
+void LaneSimulation::admitArrivals(Lane& lane, float now, LaneRunResult& result) {
+    // Enters at the lane start once the last vehicle has moved clear of it
+    if (lane.pending == 0) {
+        return;
+    }
+    float speed = config.idm.desiredSpeed;
+    if (lane.size() > 0) {
+        float gap = lane.position.back() - config.idm.vehicleLength;
+        if (gap < config.idm.minGap) {
+            return;
+        }
+        if (gap < config.idm.minGap + config.idm.desiredSpeed * config.idm.timeHeadway) {
+            speed = std::min(speed, lane.speed.back());
+        }
+    }
+    append(lane, 0.0f, speed, now, 0.0f, speed > MOVING_SPEED ? 1.0f : 0.0f);
+    lane.pending--;
+    result.vehiclesEntered++;
+}
+
+void LaneSimulation::append(Lane& lane, float position, float speed, float entered, float stops, float moving) {
+    // Two lanes merging into one may hand over out of order; never overtake the tail
+    if (lane.size() > 0) {
+        position = std::min(position, lane.position.back());
+    }
+    lane.position.push_back(position);
+    lane.speed.push_back(speed);
+    lane.acceleration.push_back(0.0f);
+    lane.entered.push_back(entered);
+    lane.stops.push_back(stops);
+    lane.moving.push_back(moving);
+}
+
+void LaneSimulation::compact(Lane& lane) {
+    // Drop the vehicles that left once they are half the arrays, so a lane
+    // costs its occupancy rather than everything that ever used it
+    if (lane.head < 1024 || lane.head * 2 < lane.position.size()) {
+        return;
+    }
+    for (std::vector<float>* column : {&lane.position, &lane.speed, &lane.acceleration, &lane.entered, &lane.stops,
+                                       &lane.moving}) {
+        column->erase(column->begin(), column->begin() + lane.head);
+    }
+    lane.head = 0;
+}
+
+LaneRunResult LaneSimulation::run() {
+    TRAFFIC_TRACE_SCOPE("LaneSimulation::run");
+    
+    LaneRunResult result;
+    for (size_t i = 0; i < lanes.size(); ++i) {
+        const LaneSpec& spec = lanes[i].spec;
+        if (spec.next >= static_cast<int32_t>(lanes.size()) || spec.next == static_cast<int32_t>(i) ||
+            spec.signal >= static_cast<int32_t>(signals.size())) {
+            std::cerr << "Error: Lane " << i << " names a lane or signal that does not exist.\n";
+            return result;
+        }
+    }
+    result.lanes = static_cast<uint32_t>(lanes.size());
+    result.stepsPerSecond = config.stepsPerSecond;
+    if (lanes.empty() || config.seconds <= 0) {
+        return result;
+    }
+    
+    std::mt19937_64 rng(config.seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    const float dt = 1.0f / config.stepsPerSecond;
+    auto wallStart = std::chrono::steady_clock::now();
+    readSignals();
+    for (int64_t second = 1; second <= config.seconds; ++second) {
+        for (int step = 1; step <= config.stepsPerSecond; ++step) {
+            float now = static_cast<float>(second - 1) + step * dt;
+            computeAccelerations();
+            integrate(dt);
+            moveAcrossStopLines(now, result);
+            for (Lane& lane : lanes) {
+                result.vehicleUpdates += lane.size();
+                if (lane.spec.demandPerHour > 0.0f &&
+                    uniform(rng) < lane.spec.demandPerHour / (3600.0 * config.stepsPerSecond)) {
+                    lane.pending++;
+                }
+                admitArrivals(lane, now, result);
+            }
+        }
+        
+        // Signal time advances on whole seconds, as in every other run mode
+        for (Intersection& signal : signals) {
+            signal.stepSecond(wallStart + std::chrono::seconds(second));
+        }
+        readSignals();
+        
+        uint64_t onLanes = 0;
+        for (const Lane& lane : lanes) {
+            onLanes += lane.size();
+        }
+        result.peakVehicles = std::max(result.peakVehicles, onLanes);
+    }
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    result.simulatedSeconds = config.seconds;
+    
+    for (const Lane& lane : lanes) {
+        result.vehiclesOnLanes += lane.size();
+        result.entryBacklog += lane.pending;
+    }
+    return result;
+}
+
+double LaneRunResult::getStopsPerVehicle() const {
+    return vehiclesLeft > 0 ? stops / vehiclesLeft : 0.0;
+}
+
+double LaneRunResult::getAverageTravelTime() const {
+    return vehiclesLeft > 0 ? travelSeconds / vehiclesLeft : 0.0;
+}
+
+double LaneRunResult::getRealTimeFactor() const {
+    return wallSeconds > 0.0 ? simulatedSeconds / wallSeconds : 0.0;
+}
+
+double LaneRunResult::getUpdatesPerSecond() const {
+    return wallSeconds > 0.0 ? vehicleUpdates / wallSeconds : 0.0;
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "../include/LookaheadController.h"
+#include "../include/TraceProfiler.h"
+#include <algorithm>
+#include <chrono>
+
+LookaheadController::LookaheadController()
+    : decisions(0), candidatesEvaluated(0), totalDecisionMs(0.0), maxDecisionMs(0.0) {
+}
+
+void LookaheadController::setConfig(const LookaheadConfig& newConfig) {
+    config = newConfig;
+    config.candidateStepSeconds = std::max(1, config.candidateStepSeconds);
+    config.replanSeconds = std::max(1, config.replanSeconds);
+}
+
+const LookaheadConfig& LookaheadController::getConfig() const {
+    return config;
+}
+
+bool LookaheadController::isDecisionPoint(int phaseTimer, int phaseLength, int yellowSeconds) const {
+    if (phaseTimer >= phaseLength - yellowSeconds) {
+        return false;  // Already committed to yellow
+    }
+    return phaseTimer >= config.minGreenSeconds &&
+           (phaseTimer - config.minGreenSeconds) % config.replanSeconds == 0;
+}
+
+LookaheadDecision LookaheadController::decide(const IntersectionFork& root) {
+    TRAFFIC_TRACE_SCOPE("LookaheadController::decide");
+    auto start = std::chrono::steady_clock::now();
+    
+    LookaheadDecision decision;
+    int timer = root.getPhaseTimer();
+    
+    // Baseline: keep the current plan
+    IntersectionFork fixedTime = root;
+    fixedTime.run(config.horizonSeconds, config.costModel);
+    decision.fixedTimeCost = fixedTime.getCost(config.costModel);
+    
+    int maxExtra = std::max(0, config.maxGreenSeconds - (timer + 1));
+    bool first = true;
+    for (int extra = 0; extra <= maxExtra; extra += config.candidateStepSeconds) {
+        IntersectionFork branch = root;  // Shares the queued vehicles with the root
+        branch.setPhaseLength(timer + 1 + extra + root.getYellowSeconds());
+        branch.run(config.horizonSeconds, config.costModel);
+        double cost = branch.getCost(config.costModel);
+        decision.candidates++;
+        
+        if (first || cost < decision.cost) {
+            decision.cost = cost;
+            decision.extraGreenSeconds = extra;
+            first = false;
+        }
+    }
+    
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    decisions++;
+    candidatesEvaluated += decision.candidates;
+    totalDecisionMs += elapsedMs;
+    maxDecisionMs = std::max(maxDecisionMs, elapsedMs);
+    return decision;
+}
+
+uint64_t LookaheadController::getDecisions() const {
+    return decisions;
+}
+
+uint64_t LookaheadController::getCandidatesEvaluated() const {
+    return candidatesEvaluated;
+}
+
+double LookaheadController::getAverageDecisionMs() const {
+    return decisions > 0 ? totalDecisionMs / decisions : 0.0;
+}
+
+double LookaheadController::getMaxDecisionMs() const {
+    return maxDecisionMs;
+}
\ No newline at end of file
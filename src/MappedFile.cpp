@@ -0,0 +1,156 @@
+#include "../include/MappedFile.h"
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : mappedData(nullptr), mappedSize(0),
+#ifdef _WIN32
+      fileHandle(nullptr), mappingHandle(nullptr) {
+#else
+      fileDescriptor(-1) {
+#endif
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Could not open file " << path << " for reading.\n";
+        return false;
+    }
+    
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        std::cerr << "Error: Could not determine the size of " << path << ".\n";
+        return false;
+    }
+    fileHandle = file;
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+    if (mappedSize == 0) {
+        return true;  // Nothing to map; an empty file is still a valid open
+    }
+    
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        close();
+        std::cerr << "Error: Could not map " << path << ".\n";
+        return false;
+    }
+    mappingHandle = mapping;
+    
+    mappedData = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (mappedData == nullptr) {
+        close();
+        std::cerr << "Error: Could not map " << path << ".\n";
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (mappedData) {
+        UnmapViewOfFile(mappedData);
+    }
+    if (mappingHandle) {
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+    }
+    if (fileHandle) {
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+    }
+    mappedData = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+    mappedSize = 0;
+}
+
+void MappedFile::adviseSequential() {
+    // FILE_FLAG_SEQUENTIAL_SCAN at open already tells the cache manager
+}
+
+bool MappedFile::isOpen() const {
+    return fileHandle != nullptr;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Could not open file " << path << " for reading.\n";
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        std::cerr << "Error: Could not determine the size of " << path << ".\n";
+        return false;
+    }
+    fileDescriptor = fd;
+    mappedSize = static_cast<size_t>(info.st_size);
+    if (mappedSize == 0) {
+        return true;  // mmap rejects zero-length mappings; an empty file is still a valid open
+    }
+    
+    void* address = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) {
+        close();
+        std::cerr << "Error: Could not map " << path << ".\n";
+        return false;
+    }
+    mappedData = static_cast<const char*>(address);
+    return true;
+}
+
+void MappedFile::close() {
+    if (mappedData) {
+        munmap(const_cast<char*>(mappedData), mappedSize);
+    }
+    if (fileDescriptor >= 0) {
+        ::close(fileDescriptor);
+    }
+    mappedData = nullptr;
+    fileDescriptor = -1;
+    mappedSize = 0;
+}
+
+void MappedFile::adviseSequential() {
+    if (mappedData) {
+        madvise(const_cast<char*>(mappedData), mappedSize, MADV_SEQUENTIAL);
+    }
+}
+
+bool MappedFile::isOpen() const {
+    return fileDescriptor >= 0;
+}
+
+#endif
+
+const char* MappedFile::data() const {
+    return mappedData;
+}
+
+size_t MappedFile::size() const {
+    return mappedSize;
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "../include/Movement.h"
+#include <iostream>
+#include <iomanip>
+
+namespace {
+
+// Legs in clockwise order (N, E, S, W) rather than Direction order
+int clockwisePosition(Direction approach) {
+    static const int positions[4] = {0, 2, 1, 3};  // NORTH, SOUTH, EAST, WEST
+    return positions[static_cast<int>(approach)];
+}
+
+// Boundary points, clockwise: every leg has its inbound lanes first, then its
+// outbound lanes (drivers keep right). Left turns exit one leg clockwise,
+// throughs two, rights three.
+struct Chord {
+    int entry;
+    int exit;
+};
+
+Chord movementChord(int movement) {
+    int leg = clockwisePosition(movementApproach(movement));
+    int exitLeg = (leg + 1 + static_cast<int>(movementTurn(movement))) % 4;
+    return {leg * 2, exitLeg * 2 + 1};
+}
+
+// Strictly inside the clockwise arc from a to b
+bool insideArc(int point, int a, int b) {
+    int span = (b - a + 8) % 8;
+    int offset = (point - a + 8) % 8;
+    return offset > 0 && offset < span;
+}
+
+bool chordsCross(Chord first, Chord second) {
+    if (first.entry == second.entry || first.exit == second.exit ||
+        first.entry == second.exit || first.exit == second.entry) {
+        return false;  // Shared endpoint: same approach or a merge
+    }
+    return insideArc(second.entry, first.entry, first.exit) != insideArc(second.exit, first.entry, first.exit);
+}
+
+}  // namespace
+
+uint8_t movementApproaches(MovementMask movements) {
+    uint8_t approaches = 0;
+    for (int dir = 0; dir < 4; ++dir) {
+        if (movements & approachMovements(static_cast<Direction>(dir))) {
+            approaches |= static_cast<uint8_t>(1u << dir);
+        }
+    }
+    return approaches;
+}
+
+MovementMask approachMaskMovements(uint8_t approaches) {
+    MovementMask movements = 0;
+    for (int dir = 0; dir < 4; ++dir) {
+        if (approaches & (1u << dir)) {
+            movements |= approachMovements(static_cast<Direction>(dir));
+        }
+    }
+    return movements;
+}
+
+Direction opposingApproach(Direction approach) {
+    switch (approach) {
+        case Direction::NORTH: return Direction::SOUTH;
+        case Direction::SOUTH: return Direction::NORTH;
+        case Direction::EAST: return Direction::WEST;
+        case Direction::WEST: return Direction::EAST;
+    }
+    return approach;
+}
+
+Direction turnHeading(Direction heading, Turn turn) {
+    // Right-hand traffic: a left turn is a quarter turn counter-clockwise
+    static const Direction lefts[4] = {Direction::WEST, Direction::EAST, Direction::NORTH, Direction::SOUTH};
+    switch (turn) {
+        case Turn::LEFT: return lefts[static_cast<int>(heading)];
+        case Turn::RIGHT: return opposingApproach(lefts[static_cast<int>(heading)]);
+        case Turn::THROUGH: break;
+    }
+    return heading;
+}
+
+bool turnBetween(Direction heading, Direction exitHeading, Turn& turn) {
+    for (Turn candidate : {Turn::THROUGH, Turn::RIGHT, Turn::LEFT}) {
+        if (turnHeading(heading, candidate) == exitHeading) {
+            turn = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool approachFor(uint8_t approaches, Direction exitHeading, Direction& approach, Turn& turn) {
+    for (Turn candidate : {Turn::THROUGH, Turn::RIGHT, Turn::LEFT}) {
+        for (int dir = 0; dir < 4; ++dir) {
+            if ((approaches & (1u << dir)) && turnHeading(static_cast<Direction>(dir), candidate) == exitHeading) {
+                approach = static_cast<Direction>(dir);
+                turn = candidate;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::string movementName(int movement) {
+    static const char approaches[] = {'N', 'S', 'E', 'W'};
+    static const char turns[] = {'L', 'T', 'R'};
+    if (movement < 0 || movement >= MOVEMENT_COUNT) {
+        return "?";
+    }
+    return std::string(1, approaches[movement / 3]) + "-" + turns[movement % 3];
+}
+
+ConflictMatrix::ConflictMatrix() {
+    for (int a = 0; a < MOVEMENT_COUNT; ++a) {
+        rows[a] = 0;
+        for (int b = 0; b < MOVEMENT_COUNT; ++b) {
+            if (movementApproach(a) != movementApproach(b) && chordsCross(movementChord(a), movementChord(b))) {
+                rows[a] |= static_cast<MovementMask>(1u << b);
+            }
+        }
+    }
+    
+    // Each set's union extends the set without its highest bit by one row
+    unions[0] = 0;
+    for (size_t set = 1; set < unions.size(); ++set) {
+        int highest = 0;
+        while ((set >> (highest + 1)) != 0) {
+            highest++;
+        }
+        unions[set] = unions[set & ~(size_t(1) << highest)] | rows[highest];
+    }
+}
+
+const ConflictMatrix& ConflictMatrix::instance() {
+    static const ConflictMatrix matrix;
+    return matrix;
+}
+
+void ConflictMatrix::display() const {
+    std::cout << "\nMovement conflict matrix (X = paths cross)\n     ";
+    for (int b = 0; b < MOVEMENT_COUNT; ++b) {
+        std::cout << std::setw(4) << movementName(b);
+    }
+    std::cout << "\n";
+    for (int a = 0; a < MOVEMENT_COUNT; ++a) {
+        std::cout << std::setw(5) << std::left << movementName(a) << std::right;
+        for (int b = 0; b < MOVEMENT_COUNT; ++b) {
+            std::cout << std::setw(4) << ((rows[a] >> b) & 1u ? "X" : ".");
+        }
+        std::cout << "\n";
+    }
+}
\ No newline at end of file
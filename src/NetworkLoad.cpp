@@ -0,0 +1,90 @@
+#include "../include/NetworkLoad.h"
+#include <algorithm>
+
+NetworkLoad::NetworkLoad() : totalQueued(0) {
+}
+
+void NetworkLoad::setLong(uint32_t index, bool isLong) {
+    uint8_t& count = longApproaches[index];
+    count = static_cast<uint8_t>(isLong ? count + 1 : count - 1);
+    if (count > 0 && congestedSlot[index] == NOT_LISTED) {
+        congestedSlot[index] = static_cast<uint32_t>(congested.size());
+        congested.push_back(index);
+    } else if (count == 0 && congestedSlot[index] != NOT_LISTED) {
+        // Swap-remove: the last member takes the leaver's place
+        uint32_t slot = congestedSlot[index];
+        uint32_t moved = congested.back();
+        congested[slot] = moved;
+        congestedSlot[moved] = slot;
+        congested.pop_back();
+        congestedSlot[index] = NOT_LISTED;
+    }
+}
+
+void NetworkLoad::resize(size_t count) {
+    for (size_t index = count; index < load.size(); ++index) {
+        set(static_cast<uint32_t>(index), {0, 0, 0, 0}, 0.0);
+    }
+    approachQueued.resize(count * 4, 0);
+    load.resize(count, 0);
+    arrivalSum.resize(count, 0.0);
+    longApproaches.resize(count, 0);
+    congestedSlot.resize(count, NOT_LISTED);
+    congestion.resize(count);
+}
+
+void NetworkLoad::clear() {
+    std::fill(approachQueued.begin(), approachQueued.end(), 0);
+    std::fill(load.begin(), load.end(), 0);
+    std::fill(arrivalSum.begin(), arrivalSum.end(), 0.0);
+    std::fill(longApproaches.begin(), longApproaches.end(), 0);
+    std::fill(congestedSlot.begin(), congestedSlot.end(), NOT_LISTED);
+    congested.clear();
+    totalQueued = 0;
+    congestion.clear();
+}
+
+void NetworkLoad::set(uint32_t index, const std::array<int32_t, 4>& queued, double queuedArrivalSum) {
+    for (int approach = 0; approach < 4; ++approach) {
+        add(index, approach, queued[approach] - approachQueued[index * 4 + approach], 0.0);
+    }
+    arrivalSum[index] = load[index] > 0 ? queuedArrivalSum : 0.0;
+    congestion.updateIntersection(index, load[index], arrivalSum[index]);
+}
+
+void NetworkLoad::rollGrowthWindow(double nowSeconds) {
+    congestion.rollGrowthWindow(nowSeconds, load);
+}
+
+size_t NetworkLoad::size() const {
+    return load.size();
+}
+
+int64_t NetworkLoad::getTotalQueued() const {
+    return totalQueued;
+}
+
+double NetworkLoad::getMeanLoad() const {
+    return load.empty() ? 0.0 : static_cast<double>(totalQueued) / load.size();
+}
+
+int32_t NetworkLoad::getLoad(uint32_t index) const {
+    return load[index];
+}
+
+int32_t NetworkLoad::getApproachQueued(uint32_t index, Direction dir) const {
+    return approachQueued[index * 4 + static_cast<int>(dir)];
+}
+
+Direction NetworkLoad::getLongestApproach(uint32_t index) const {
+    auto first = approachQueued.begin() + index * 4;
+    return static_cast<Direction>(std::max_element(first, first + 4) - first);
+}
+
+const std::vector<uint32_t>& NetworkLoad::getCongested() const {
+    return congested;
+}
+
+const CongestionIndex& NetworkLoad::getCongestionIndex() const {
+    return congestion;
+}
\ No newline at end of file
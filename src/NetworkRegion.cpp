@@ -0,0 +1,499 @@
+#include "../include/NetworkRegion.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+namespace {
+
+const uint64_t DEMAND_SALT = 0x64656d616e64ull;
+const uint64_t TURN_SALT = 0x7475726e73ull;
+const uint64_t TRIP_SALT = 0x7472697073ull;
+const uint32_t NO_REPORT = 0xFFFFFFFFu;
+
+uint64_t mix(uint64_t x) {
+    // splitmix64 finaliser
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// Uniform in [0, 1), a pure function of its arguments
+double draw(uint64_t seed, uint64_t a, uint64_t b, uint64_t c, uint64_t salt) {
+    uint64_t h = mix(seed ^ salt);
+    h = mix(h ^ a);
+    h = mix(h ^ b);
+    h = mix(h ^ c);
+    return static_cast<double>(h >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Same split as generated traffic: 20% left, 15% right, the rest straight through
+Turn pickTurn(uint64_t seed, uint32_t node, int64_t second, uint32_t ordinal) {
+    double u = draw(seed, node, static_cast<uint64_t>(second), ordinal, TURN_SALT);
+    if (u < 0.20) {
+        return Turn::LEFT;
+    }
+    if (u < 0.35) {
+        return Turn::RIGHT;
+    }
+    return Turn::THROUGH;
+}
+
+struct Extent {
+    float minX, maxX, minY, maxY;
+};
+
+void bisect(const ScenarioFile& network, std::vector<uint32_t>& nodes, size_t begin, size_t end,
+            uint32_t firstPart, int parts, std::vector<uint32_t>& owner) {
+    if (parts <= 1 || end - begin <= 1) {
+        for (size_t i = begin; i < end; ++i) {
+            owner[nodes[i]] = firstPart;
+        }
+        return;
+    }
+    
+    Extent extent = {network.getNode(nodes[begin]).x, network.getNode(nodes[begin]).x,
+                     network.getNode(nodes[begin]).y, network.getNode(nodes[begin]).y};
+    for (size_t i = begin; i < end; ++i) {
+        const ScenarioNode& node = network.getNode(nodes[i]);
+        extent.minX = std::min(extent.minX, node.x);
+        extent.maxX = std::max(extent.maxX, node.x);
+        extent.minY = std::min(extent.minY, node.y);
+        extent.maxY = std::max(extent.maxY, node.y);
+    }
+    
+    // Cut across the longer side, sized so both halves get whole parts
+    bool byX = extent.maxX - extent.minX >= extent.maxY - extent.minY;
+    int lowParts = parts / 2;
+    size_t mid = begin + (end - begin) * lowParts / parts;
+    std::nth_element(nodes.begin() + begin, nodes.begin() + mid, nodes.begin() + end,
+                     [&](uint32_t a, uint32_t b) {
+                         const ScenarioNode& na = network.getNode(a);
+                         const ScenarioNode& nb = network.getNode(b);
+                         float ka = byX ? na.x : na.y;
+                         float kb = byX ? nb.x : nb.y;
+                         return ka < kb || (ka == kb && a < b);
+                     });
+    bisect(network, nodes, begin, mid, firstPart, lowParts, owner);
+    bisect(network, nodes, mid, end, firstPart + lowParts, parts - lowParts, owner);
+}
+
+}  // namespace
+
+NetworkTopology::NetworkTopology(const ScenarioFile& network, uint32_t nodeCount, int regions, const RouteTable* tripRoutes)
+    : scenario(network), routes(tripRoutes), regionCount(static_cast<uint32_t>(std::max(1, regions))), linkCount(0), cutLinks(0) {
+    nodeCount = std::min(nodeCount, scenario.getNodeCount());
+    nodeOwner = partition(scenario, static_cast<int>(regionCount));
+    nodeOwner.resize(nodeCount);
+    
+    linkCount = nodeCount > 0 ? static_cast<uint32_t>(scenario.outgoingEnd(nodeCount - 1) - scenario.outgoingBegin(0)) : 0;
+    outLinks.assign(static_cast<size_t>(nodeCount) * 4, -1);
+    linkSlot.assign(linkCount, 0);
+    outSlot.assign(linkCount, 0);
+    travelSeconds.assign(linkCount, 1);
+    storage.assign(linkCount, 1);
+    std::vector<uint32_t> ownedLinks(regionCount, 0);
+    std::vector<uint32_t> leavingLinks(regionCount, 0);
+    for (uint32_t l = 0; l < linkCount; ++l) {
+        if (!isSimulated(l)) {
+            continue;  // Leads off the simulated network: treated as leaving it
+        }
+        const ScenarioLink& link = getLink(l);
+        outLinks[link.from * 4 + link.heading] = static_cast<int32_t>(l);
+        linkSlot[l] = ownedLinks[nodeOwner[link.to]]++;
+        outSlot[l] = leavingLinks[nodeOwner[link.from]]++;
+        storage[l] = ScenarioFile::getStorageVehicles(link);
+        double seconds = link.freeFlowSpeed > 0.0f ? link.lengthMeters / link.freeFlowSpeed : 1.0;
+        travelSeconds[l] = std::max(1, static_cast<int32_t>(seconds + 0.999));
+        if (nodeOwner[link.from] != nodeOwner[link.to]) {
+            cutLinks++;
+        }
+    }
+}
+
+std::vector<uint32_t> NetworkTopology::partition(const ScenarioFile& network, int regions) {
+    uint32_t nodeCount = network.getNodeCount();
+    std::vector<uint32_t> owner(nodeCount, 0);
+    std::vector<uint32_t> nodes(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        nodes[i] = i;
+    }
+    bisect(network, nodes, 0, nodeCount, 0, std::max(1, regions), owner);
+    return owner;
+}
+
+bool NetworkTopology::isSimulated(uint32_t link) const {
+    const ScenarioLink& l = getLink(link);
+    return l.to < nodeOwner.size() && l.from < nodeOwner.size() && l.heading <= 3;
+}
+
+NetworkRegion::NetworkRegion(const NetworkTopology& network, uint32_t regionIndex, const NetworkRunConfig& runConfig,
+                             const std::vector<Intersection*>& byNode)
+    : topology(network), config(runConfig), region(regionIndex), entered(0), exited(0), tripsStarted(0),
+      tripsCompleted(0), departures(0),
+      linkTransfers(0), boundaryTransfers(0), entriesRefused(0), heldDischarges(0), resident(0), vehicleSeconds(0.0) {
+    uint32_t nodeCount = topology.getNodeCount();
+    std::vector<uint32_t> localIndex(nodeCount, UINT32_MAX);
+    for (uint32_t node = 0; node < nodeCount; ++node) {
+        if (topology.getRegion(node) == region) {
+            localIndex[node] = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(node);
+            local.push_back(byNode[node]);
+            resident += byNode[node]->getTotalVehicleCount();
+        }
+    }
+    
+    // Inbound links per local node, in link order
+    std::vector<uint32_t> counts(nodes.size() + 1, 0);
+    uint32_t owned = 0;
+    uint32_t leaving = 0;
+    for (uint32_t l = 0; l < topology.getLinkCount(); ++l) {
+        if (topology.isSimulated(l) && localIndex[topology.getLink(l).to] != UINT32_MAX) {
+            counts[localIndex[topology.getLink(l).to] + 1]++;
+            owned++;
+        }
+        if (topology.isSimulated(l) && localIndex[topology.getLink(l).from] != UINT32_MAX) {
+            leaving++;
+        }
+    }
+    for (size_t i = 1; i < counts.size(); ++i) {
+        counts[i] += counts[i - 1];
+    }
+    inboundBegin = counts;
+    inboundLinks.resize(owned);
+    for (uint32_t l = 0; l < topology.getLinkCount(); ++l) {
+        if (topology.isSimulated(l) && localIndex[topology.getLink(l).to] != UINT32_MAX) {
+            inboundLinks[counts[localIndex[topology.getLink(l).to]]++] = l;
+        }
+    }
+    transit.resize(owned);
+    
+    // Approach storage: what the feeding link holds, or the entry limit
+    for (Intersection* intersection : local) {
+        for (int d = 0; d < 4; ++d) {
+            intersection->setApproachCapacity(static_cast<Direction>(d), config.spillback ? config.entryStorage : 0);
+        }
+    }
+    if (config.spillback) {
+        for (uint32_t link : inboundLinks) {
+            local[localIndex[topology.getLink(link).to]]->setApproachCapacity(
+                static_cast<Direction>(topology.getLink(link).heading), static_cast<int>(topology.getStorage(link)));
+        }
+        reportedOccupancy.assign(owned, 0);
+        downstreamOccupancy.assign(leaving, 0);
+        pendingOccupancy.assign(leaving, NO_REPORT);
+        sentNow.assign(leaving, 0);
+        sentBefore.assign(leaving, 0);
+    }
+    if (config.collectLinkTimes) {
+        linkSeconds.assign(owned, 0.0);
+        linkTraversals.assign(owned, 0);
+    }
+    
+    // Routed trips by origin; a route never leaves the simulated nodes
+    const RouteTable* routes = topology.getRoutes();
+    tripBegin.assign(nodes.size() + 1, 0);
+    const ScenarioFile& scenario = topology.getScenario();
+    for (uint32_t t = 0; routes && t < scenario.getTripCount(); ++t) {
+        uint32_t route = routes->getTripRoute(t);
+        if (route != Vehicle::NO_ROUTE && localIndex.size() > scenario.getTrip(t).origin &&
+            localIndex[scenario.getTrip(t).origin] != UINT32_MAX && routeIsSimulated(route)) {
+            tripBegin[localIndex[scenario.getTrip(t).origin] + 1]++;
+        }
+    }
+    for (size_t i = 1; i < tripBegin.size(); ++i) {
+        tripBegin[i] += tripBegin[i - 1];
+    }
+    trips.resize(tripBegin.back());
+    std::vector<uint32_t> fill(tripBegin.begin(), tripBegin.end() - 1);
+    for (uint32_t t = 0; routes && t < scenario.getTripCount(); ++t) {
+        uint32_t route = routes->getTripRoute(t);
+        if (route != Vehicle::NO_ROUTE && localIndex.size() > scenario.getTrip(t).origin &&
+            localIndex[scenario.getTrip(t).origin] != UINT32_MAX && routeIsSimulated(route)) {
+            trips[fill[localIndex[scenario.getTrip(t).origin]]++] = t;
+        }
+    }
+}
+
+bool NetworkRegion::routeIsSimulated(uint32_t route) const {
+    const RouteTable& routes = *topology.getRoutes();
+    for (uint32_t i = 0; i < routes.getLength(route); ++i) {
+        if (routes.getLink(route, i) >= topology.getLinkCount() || !topology.isSimulated(routes.getLink(route, i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void NetworkRegion::receive(VehicleTransfer&& transfer) {
+    transit[topology.getLinkSlot(transfer.link)].push_back({transfer.readySecond, std::move(transfer.vehicle)});
+}
+
+void NetworkRegion::receive(const LinkOccupancy& report) {
+    if (!pendingOccupancy.empty()) {
+        pendingOccupancy[topology.getOutSlot(report.link)] = report.vehicles;
+    }
+}
+
+uint32_t NetworkRegion::getOccupancy(size_t localNode, uint32_t link) const {
+    return static_cast<uint32_t>(transit[topology.getLinkSlot(link)].size() +
+                                 local[localNode]->getQueueLength(static_cast<Direction>(topology.getLink(link).heading)));
+}
+
+void NetworkRegion::exchangeOccupancy(std::vector<BoundaryExchange>& outbox) {
+    // Last second's reports take effect; what was sent since the oldest of
+    // them is what the upstream side still has to count against the room
+    for (size_t slot = 0; slot < pendingOccupancy.size(); ++slot) {
+        if (pendingOccupancy[slot] != NO_REPORT) {
+            downstreamOccupancy[slot] = pendingOccupancy[slot];
+            pendingOccupancy[slot] = NO_REPORT;
+        }
+        sentBefore[slot] = sentNow[slot];
+        sentNow[slot] = 0;
+    }
+    
+    // Report the links ending here whose occupancy changed
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (uint32_t k = inboundBegin[i]; k < inboundBegin[i + 1]; ++k) {
+            uint32_t link = inboundLinks[k];
+            uint32_t slot = topology.getLinkSlot(link);
+            uint32_t vehicles = getOccupancy(i, link);
+            if (vehicles == reportedOccupancy[slot]) {
+                continue;
+            }
+            reportedOccupancy[slot] = vehicles;
+            uint32_t owner = topology.getRegion(topology.getLink(link).from);
+            if (owner == region) {
+                pendingOccupancy[topology.getOutSlot(link)] = vehicles;
+            } else {
+                outbox[owner].occupancy.push_back({link, vehicles});
+            }
+        }
+    }
+}
+
+void NetworkRegion::step(int64_t second, std::chrono::steady_clock::time_point now, std::vector<BoundaryExchange>& outbox) {
+    static const char directionLetters[] = {'N', 'S', 'E', 'W'};
+    
+    if (config.spillback) {
+        exchangeOccupancy(outbox);
+    }
+    
+    const ScenarioFile& scenario = topology.getScenario();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        uint32_t node = nodes[i];
+        Intersection& intersection = *local[i];
+        uint8_t approaches = scenario.getNode(node).approachMask;
+        uint32_t ordinal = 0;
+        
+        // Vehicles at the end of their link join the queue they are heading
+        // into, waiting on the link while that queue is full
+        for (uint32_t k = inboundBegin[i]; k < inboundBegin[i + 1]; ++k) {
+            uint32_t link = inboundLinks[k];
+            Direction heading = static_cast<Direction>(topology.getLink(link).heading);
+            auto& queue = transit[topology.getLinkSlot(link)];
+            while (!queue.empty() && queue.front().readySecond <= second) {
+                Vehicle& vehicle = queue.front().vehicle;
+                auto reached = now - std::chrono::seconds(second - queue.front().readySecond);
+                if (vehicle.getRouteId() != Vehicle::NO_ROUTE) {
+                    if (!arrive(intersection, vehicle, heading, reached)) {
+                        break;
+                    }
+                } else if (approaches & (1u << static_cast<int>(heading))) {
+                    vehicle.setApproach(heading, pickTurn(config.seed, node, second, ordinal++));
+                    vehicle.setArrivalTime(reached);
+                    if (!intersection.addVehicle(vehicle)) {
+                        break;
+                    }
+                } else {
+                    exited++;  // No signal head on that approach to serve it
+                }
+                queue.pop_front();
+            }
+        }
+        
+        // OD trips starting here, then approach demand
+        for (uint32_t k = tripBegin[i]; k < tripBegin[i + 1]; ++k) {
+            startTrips(intersection, trips[k], second, now);
+        }
+        for (int d = 0; d < 4; ++d) {
+            if (!(approaches & (1u << d))) {
+                continue;
+            }
+            Direction dir = static_cast<Direction>(d);
+            double perSecond = scenario.getDemandPerHour(node, dir, config.startSecondOfDay + second) / 3600.0;
+            if (perSecond > 0.0 && draw(config.seed, node, static_cast<uint64_t>(second), static_cast<uint64_t>(d), DEMAND_SALT) < perSecond) {
+                Vehicle vehicle("N" + std::to_string(node) + directionLetters[d] + std::to_string(second),
+                                VehicleType::CAR, dir, pickTurn(config.seed, node, second, ordinal++));
+                vehicle.setArrivalTime(now);
+                if (intersection.addVehicle(vehicle)) {
+                    entered++;
+                } else {
+                    entriesRefused++;
+                }
+            }
+        }
+        
+        intersection.stepSecond(now);
+        if (!intersection.hasQueuedVehicles()) {
+            continue;
+        }
+        
+        departed.clear();
+        if (config.spillback) {
+            std::array<int32_t, 4> exitRoom;
+            for (int h = 0; h < 4; ++h) {
+                int32_t link = topology.getOutLink(node, static_cast<Direction>(h));
+                if (link < 0) {
+                    exitRoom[h] = INT32_MAX;  // Leaves the network
+                    continue;
+                }
+                uint32_t slot = topology.getOutSlot(link);
+                exitRoom[h] = static_cast<int32_t>(topology.getStorage(link)) -
+                              static_cast<int32_t>(downstreamOccupancy[slot] + sentBefore[slot] + sentNow[slot]);
+            }
+            size_t held = 0;
+            departures += intersection.processVehicleQueues(departed, exitRoom, held);
+            heldDischarges += held;
+        } else {
+            departures += intersection.processVehicleQueues(departed);
+        }
+        for (Vehicle& vehicle : departed) {
+            int32_t link;
+            if (vehicle.getRouteId() != Vehicle::NO_ROUTE) {
+                recordTraversal(vehicle, now);
+                link = static_cast<int32_t>(topology.getRoutes()->getLink(vehicle.getRouteId(), vehicle.getRouteCursor()));
+                vehicle.advanceRoute();
+            } else {
+                link = topology.getOutLink(node, turnHeading(vehicle.getDirection(), vehicle.getTurn()));
+            }
+            if (link < 0) {
+                exited++;
+                continue;
+            }
+            
+            linkTransfers++;
+            if (config.spillback) {
+                sentNow[topology.getOutSlot(link)]++;
+            }
+            int64_t ready = second + topology.getTravelSeconds(link);
+            uint32_t owner = topology.getRegion(topology.getLink(link).to);
+            if (owner == region) {
+                transit[topology.getLinkSlot(link)].push_back({ready, std::move(vehicle)});
+            } else {
+                outbox[owner].vehicles.push_back({static_cast<uint32_t>(link), ready, std::move(vehicle)});
+                boundaryTransfers++;
+            }
+        }
+    }
+    
+    vehicleSeconds += static_cast<double>(resident + static_cast<int64_t>(entered) - static_cast<int64_t>(exited));
+}
+
+void NetworkRegion::startTrips(Intersection& intersection, uint32_t trip, int64_t second,
+                               std::chrono::steady_clock::time_point now) {
+    const ScenarioTrip& spec = topology.getScenario().getTrip(trip);
+    double perSecond = spec.tripsPerHour / 3600.0;
+    double whole = std::floor(perSecond);
+    int count = static_cast<int>(whole) +
+                (draw(config.seed, trip, static_cast<uint64_t>(second), 0, TRIP_SALT) < perSecond - whole ? 1 : 0);
+    if (count == 0) {
+        return;
+    }
+    
+    uint32_t route = topology.getRoutes()->getTripRoute(trip);
+    const ScenarioLink& first = topology.getLink(topology.getRoutes()->getLink(route, 0));
+    Direction approach;
+    Turn turn;
+    approachFor(topology.getScenario().getNode(spec.origin).approachMask, static_cast<Direction>(first.heading),
+                approach, turn);
+    for (int k = 0; k < count; ++k) {
+        Vehicle vehicle("T" + std::to_string(trip) + "_" + std::to_string(second) + (k > 0 ? "_" + std::to_string(k) : ""),
+                        VehicleType::CAR, approach, turn);
+        vehicle.setRoute(route);
+        vehicle.setArrivalTime(now);
+        if (!intersection.addVehicle(vehicle)) {
+            entriesRefused += static_cast<uint64_t>(count - k);
+            break;
+        }
+        entered++;
+        tripsStarted++;
+    }
+}
+
+// False when the queue it is heading into is full
+bool NetworkRegion::arrive(Intersection& intersection, Vehicle& vehicle, Direction heading,
+                           std::chrono::steady_clock::time_point now) {
+    const RouteTable& routes = *topology.getRoutes();
+    if (vehicle.getRouteCursor() >= routes.getLength(vehicle.getRouteId())) {
+        vehicle.setArrivalTime(now);
+        recordTraversal(vehicle, now);
+        exited++;  // At its destination
+        tripsCompleted++;
+        return true;
+    }
+    
+    // Routes only turn where the approach is signalled and the turn is legal
+    Turn turn = Turn::THROUGH;
+    turnBetween(heading, static_cast<Direction>(topology.getLink(routes.getLink(vehicle.getRouteId(),
+                                                                                vehicle.getRouteCursor())).heading), turn);
+    vehicle.setApproach(heading, turn);
+    vehicle.setArrivalTime(now);
+    return intersection.addVehicle(vehicle);
+}
+
+// The link a routed vehicle came in on: its travel time plus the wait since it queued at the end
+void NetworkRegion::recordTraversal(const Vehicle& vehicle, std::chrono::steady_clock::time_point now) {
+    if (linkSeconds.empty() || vehicle.getRouteCursor() == 0) {
+        return;
+    }
+    uint32_t link = topology.getRoutes()->getLink(vehicle.getRouteId(), vehicle.getRouteCursor() - 1);
+    uint32_t slot = topology.getLinkSlot(link);
+    linkSeconds[slot] += topology.getTravelSeconds(link) +
+                         std::chrono::duration<double>(now - vehicle.getArrivalTime()).count();
+    linkTraversals[slot]++;
+}
+
+void NetworkRegion::addTo(NetworkRunResult& result) const {
+    result.vehiclesEntered += entered;
+    result.vehiclesExited += exited;
+    result.tripsStarted += tripsStarted;
+    result.tripsCompleted += tripsCompleted;
+    result.departures += departures;
+    result.linkTransfers += linkTransfers;
+    result.boundaryTransfers += boundaryTransfers;
+    result.entriesRefused += entriesRefused;
+    result.heldDischarges += heldDischarges;
+    result.vehicleSeconds += vehicleSeconds;
+    for (const auto& queue : transit) {
+        result.vehiclesInNetwork += queue.size();
+    }
+    for (const Intersection* intersection : local) {
+        result.vehiclesInNetwork += static_cast<uint64_t>(intersection->getTotalVehicleCount());
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        for (uint32_t k = inboundBegin[i]; k < inboundBegin[i + 1]; ++k) {
+            if (getOccupancy(i, inboundLinks[k]) >= topology.getStorage(inboundLinks[k])) {
+                result.fullLinks++;
+            }
+        }
+    }
+    
+    if (!linkSeconds.empty()) {
+        result.linkSeconds.resize(topology.getLinkCount(), 0.0);
+        result.linkTraversals.resize(topology.getLinkCount(), 0);
+        for (uint32_t link : inboundLinks) {
+            result.linkSeconds[link] += linkSeconds[topology.getLinkSlot(link)];
+            result.linkTraversals[link] += linkTraversals[topology.getLinkSlot(link)];
+        }
+    }
+}
+
+double NetworkRunResult::getSpeedup() const {
+    return wallSeconds > 0.0 ? simulatedSeconds / wallSeconds : 0.0;
+}
+
+double NetworkRunResult::getAverageTimeInNetwork() const {
+    return vehiclesEntered > 0 ? vehicleSeconds / vehiclesEntered : 0.0;
+}
\ No newline at end of file
@@ -0,0 +1,438 @@
+#include "../include/PartitionedSimulation.h"
+#include "../include/Checkpoint.h"
+#include "../include/TraceProfiler.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace {
+
+// Frame: u32 type | u32 reserved | u64 payload size | payload.
+// TICK and STOP: i64 second | u32 segment count | segments.
+// DONE: one segment per region, in region order (its own is empty).
+// Segment: u64 byte size | u32 transfer count | (u32 link, i64 ready second, vehicle)...
+//   | u32 report count | (u32 link, u32 occupancy)...
+// The coordinator moves segments between workers without decoding them.
+enum MessageType : uint32_t {
+    READY = 1,
+    TICK,
+    DONE,
+    STOP,
+    RESULT
+};
+
+const size_t FRAME_HEADER_SIZE = 16;
+const size_t MIN_TRANSFER_BYTES = 4 + 8 + 4;
+const size_t REPORT_BYTES = 4 + 4;
+const size_t EMPTY_SEGMENT_BYTES = 4 + 4;   // After the size: both counts zero
+
+#ifndef _WIN32
+bool writeAll(int socket, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = send(socket, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int socket, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t got = read(socket, data, size);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+bool sendMessage(int socket, MessageType type, const std::vector<char>& payload) {
+    char header[FRAME_HEADER_SIZE];
+    uint32_t typeValue = type;
+    uint32_t reserved = 0;
+    uint64_t size = payload.size();
+    std::memcpy(header, &typeValue, sizeof(typeValue));
+    std::memcpy(header + 4, &reserved, sizeof(reserved));
+    std::memcpy(header + 8, &size, sizeof(size));
+    return writeAll(socket, header, sizeof(header)) && writeAll(socket, payload.data(), payload.size());
+}
+
+bool receiveMessage(int socket, MessageType expected, std::vector<char>& payload) {
+    char header[FRAME_HEADER_SIZE];
+    if (!readAll(socket, header, sizeof(header))) {
+        return false;
+    }
+    uint32_t type;
+    uint64_t size;
+    std::memcpy(&type, header, sizeof(type));
+    std::memcpy(&size, header + 8, sizeof(size));
+    if (type != expected) {
+        return false;
+    }
+    payload.resize(size);
+    return readAll(socket, payload.data(), payload.size());
+}
+#endif
+
+// Appends one segment holding an exchange, which is emptied
+void putSegment(CheckpointWriter& out, BoundaryExchange& exchange) {
+    size_t sizeAt = out.data().size();
+    out.put(static_cast<uint64_t>(0));
+    out.put(static_cast<uint32_t>(exchange.vehicles.size()));
+    for (const VehicleTransfer& transfer : exchange.vehicles) {
+        out.put(transfer.link);
+        out.put(transfer.readySecond);
+        transfer.vehicle.writeCheckpoint(out);
+    }
+    out.put(static_cast<uint32_t>(exchange.occupancy.size()));
+    for (const LinkOccupancy& report : exchange.occupancy) {
+        out.put(report.link);
+        out.put(report.vehicles);
+    }
+    uint64_t bytes = out.data().size() - sizeAt - sizeof(uint64_t);
+    std::memcpy(out.data().data() + sizeAt, &bytes, sizeof(bytes));
+    exchange.vehicles.clear();
+    exchange.occupancy.clear();
+}
+
+void pinToCpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+}  // namespace
+
+PartitionedSimulation::PartitionedSimulation(const ScenarioFile& network, std::vector<std::unique_ptr<Intersection>>& nodes,
+                                             const NetworkRunConfig& runConfig, const RouteTable* routes)
+    : scenario(network), intersections(nodes), config(runConfig) {
+    uint32_t nodeCount = std::min<uint32_t>(scenario.getNodeCount(), static_cast<uint32_t>(intersections.size()));
+    workerCount = config.workers > 0 ? config.workers : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    workerCount = std::max(1, std::min<int>(workerCount, static_cast<int>(std::max<uint32_t>(nodeCount, 1))));
+    topology = std::make_unique<NetworkTopology>(scenario, nodeCount, workerCount, routes);
+}
+
+PartitionedSimulation::~PartitionedSimulation() {
+    stopWorkers();
+}
+
+#ifndef _WIN32
+bool PartitionedSimulation::startWorkers(std::chrono::steady_clock::time_point origin) {
+    // Buffered output would otherwise be flushed once more by every child
+    std::cout.flush();
+    std::cerr.flush();
+    
+    for (int w = 0; w < workerCount; ++w) {
+        int ends[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, ends) != 0) {
+            std::cerr << "Error: Could not create a socket for partition worker " << w << ".\n";
+            return false;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "Error: Could not start partition worker " << w << ".\n";
+            close(ends[0]);
+            close(ends[1]);
+            return false;
+        }
+        if (pid == 0) {
+            close(ends[0]);
+            for (const Worker& sibling : workers) {
+                close(sibling.socket);
+            }
+            serveRegion(static_cast<uint32_t>(w), ends[1], origin);
+        }
+        close(ends[1]);
+        workers.push_back({static_cast<int>(pid), ends[0]});
+    }
+    
+    std::vector<char> payload;
+    for (int w = 0; w < workerCount; ++w) {
+        if (!receiveMessage(workers[w].socket, READY, payload)) {
+            std::cerr << "Error: Partition worker " << w << " failed to start.\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void PartitionedSimulation::stopWorkers() {
+    // Workers exit when their socket closes
+    for (const Worker& worker : workers) {
+        close(worker.socket);
+    }
+    for (const Worker& worker : workers) {
+        int status;
+        while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {
+        }
+    }
+    workers.clear();
+}
+
+void PartitionedSimulation::serveRegion(uint32_t region, int socket, std::chrono::steady_clock::time_point origin) {
+    unsigned cpus = std::thread::hardware_concurrency();
+    if (config.pinThreads && cpus > 0 && static_cast<unsigned>(workerCount) <= cpus) {
+        pinToCpu(static_cast<int>(region));
+    }
+    
+    std::vector<Intersection*> byNode(topology->getNodeCount(), nullptr);
+    for (uint32_t node = 0; node < topology->getNodeCount(); ++node) {
+        if (topology->getRegion(node) == region) {
+            byNode[node] = intersections[node].get();
+        }
+    }
+    NetworkRegion mine(*topology, region, config, byNode);
+    std::vector<BoundaryExchange> outbox(workerCount);
+    
+    std::vector<char> payload;
+    if (!sendMessage(socket, READY, payload)) {
+        _exit(1);
+    }
+    for (;;) {
+        // A TICK, or the STOP that follows the last one
+        char header[FRAME_HEADER_SIZE];
+        if (!readAll(socket, header, sizeof(header))) {
+            _exit(1);
+        }
+        uint32_t type;
+        uint64_t size;
+        std::memcpy(&type, header, sizeof(type));
+        std::memcpy(&size, header + 8, sizeof(size));
+        payload.resize(size);
+        if ((type != TICK && type != STOP) || !readAll(socket, payload.data(), payload.size())) {
+            _exit(1);
+        }
+        
+        CheckpointReader in;
+        in.openBuffer(payload.data(), payload.size(), origin);
+        int64_t second = in.get<int64_t>();
+        uint32_t segments = in.getCount(sizeof(uint64_t) + sizeof(uint32_t));
+        for (uint32_t s = 0; s < segments && in.ok(); ++s) {
+            in.get<uint64_t>();
+            uint32_t count = in.getCount(MIN_TRANSFER_BYTES);
+            for (uint32_t i = 0; i < count && in.ok(); ++i) {
+                VehicleTransfer transfer = {0, 0, Vehicle("", VehicleType::CAR, Direction::NORTH)};
+                transfer.link = in.get<uint32_t>();
+                transfer.readySecond = in.get<int64_t>();
+                transfer.vehicle.readCheckpoint(in);
+                if (transfer.link >= topology->getLinkCount() || !topology->isSimulated(transfer.link) ||
+                    topology->getRegion(topology->getLink(transfer.link).to) != region) {
+                    in.fail();
+                }
+                if (in.ok()) {
+                    mine.receive(std::move(transfer));
+                }
+            }
+            uint32_t reports = in.getCount(REPORT_BYTES);
+            for (uint32_t i = 0; i < reports && in.ok(); ++i) {
+                LinkOccupancy report;
+                report.link = in.get<uint32_t>();
+                report.vehicles = in.get<uint32_t>();
+                if (report.link >= topology->getLinkCount() || !topology->isSimulated(report.link) ||
+                    topology->getRegion(topology->getLink(report.link).from) != region) {
+                    in.fail();
+                }
+                if (in.ok()) {
+                    mine.receive(report);
+                }
+            }
+        }
+        if (!in.ok() || !in.atEnd()) {
+            _exit(1);
+        }
+        
+        CheckpointWriter out(origin);
+        if (type == STOP) {
+            NetworkRunResult result;
+            mine.addTo(result);
+            out.put(result.vehiclesEntered);
+            out.put(result.vehiclesExited);
+            out.put(result.tripsStarted);
+            out.put(result.tripsCompleted);
+            out.put(result.departures);
+            out.put(result.linkTransfers);
+            out.put(result.boundaryTransfers);
+            out.put(result.vehiclesInNetwork);
+            out.put(result.entriesRefused);
+            out.put(result.heldDischarges);
+            out.put(result.fullLinks);
+            out.put(result.vehicleSeconds);
+            
+            // Link times, only for the links that were traversed
+            uint32_t traversed = 0;
+            for (uint32_t count : result.linkTraversals) {
+                traversed += count > 0 ? 1 : 0;
+            }
+            out.put(traversed);
+            for (uint32_t link = 0; link < result.linkTraversals.size(); ++link) {
+                if (result.linkTraversals[link] > 0) {
+                    out.put(link);
+                    out.put(result.linkSeconds[link]);
+                    out.put(result.linkTraversals[link]);
+                }
+            }
+            _exit(sendMessage(socket, RESULT, out.data()) ? 0 : 1);
+        }
+        
+        mine.step(second, origin + std::chrono::seconds(second), outbox);
+        for (auto& box : outbox) {
+            putSegment(out, box);
+        }
+        if (!sendMessage(socket, DONE, out.data())) {
+            _exit(1);
+        }
+    }
+}
+
+NetworkRunResult PartitionedSimulation::run() {
+    TRAFFIC_TRACE_SCOPE("PartitionedSimulation::run");
+    
+    NetworkRunResult result;
+    result.workers = workerCount;
+    if (topology->getNodeCount() == 0 || config.seconds <= 0) {
+        return result;
+    }
+    result.cutLinks = topology->getCutLinkCount();
+    
+    auto wallStart = std::chrono::steady_clock::now();
+    if (!startWorkers(wallStart)) {
+        stopWorkers();
+        return NetworkRunResult();
+    }
+    
+    // Segments waiting for each region, in the order their senders reported
+    std::vector<std::vector<char>> inbound(workerCount);
+    std::vector<uint32_t> inboundSegments(workerCount, 0);
+    std::vector<char> payload;
+    for (int64_t second = 1; second <= config.seconds + 1; ++second) {
+        bool last = second > config.seconds;
+        for (int w = 0; w < workerCount; ++w) {
+            CheckpointWriter tick(wallStart);
+            tick.put(second);
+            tick.put(inboundSegments[w]);
+            tick.data().insert(tick.data().end(), inbound[w].begin(), inbound[w].end());
+            inbound[w].clear();
+            inboundSegments[w] = 0;
+            if (!sendMessage(workers[w].socket, last ? STOP : TICK, tick.data())) {
+                std::cerr << "Error: Partition worker " << w << " stopped unexpectedly.\n";
+                stopWorkers();
+                return NetworkRunResult();
+            }
+        }
+        
+        for (int w = 0; w < workerCount; ++w) {
+            if (!receiveMessage(workers[w].socket, last ? RESULT : DONE, payload)) {
+                std::cerr << "Error: Partition worker " << w << " stopped unexpectedly.\n";
+                stopWorkers();
+                return NetworkRunResult();
+            }
+            
+            CheckpointReader in;
+            in.openBuffer(payload.data(), payload.size(), wallStart);
+            if (last) {
+                result.vehiclesEntered += in.get<uint64_t>();
+                result.vehiclesExited += in.get<uint64_t>();
+                result.tripsStarted += in.get<uint64_t>();
+                result.tripsCompleted += in.get<uint64_t>();
+                result.departures += in.get<uint64_t>();
+                result.linkTransfers += in.get<uint64_t>();
+                result.boundaryTransfers += in.get<uint64_t>();
+                result.vehiclesInNetwork += in.get<uint64_t>();
+                result.entriesRefused += in.get<uint64_t>();
+                result.heldDischarges += in.get<uint64_t>();
+                result.fullLinks += in.get<uint32_t>();
+                result.vehicleSeconds += in.get<double>();
+                
+                uint32_t traversed = in.getCount(sizeof(uint32_t) + sizeof(double) + sizeof(uint32_t));
+                if (traversed > 0 && result.linkTraversals.empty()) {
+                    result.linkSeconds.assign(topology->getLinkCount(), 0.0);
+                    result.linkTraversals.assign(topology->getLinkCount(), 0);
+                }
+                for (uint32_t i = 0; i < traversed && in.ok(); ++i) {
+                    uint32_t link = in.get<uint32_t>();
+                    double seconds = in.get<double>();
+                    uint32_t count = in.get<uint32_t>();
+                    if (link < result.linkTraversals.size()) {
+                        result.linkSeconds[link] += seconds;
+                        result.linkTraversals[link] += count;
+                    }
+                }
+                continue;
+            }
+            
+            size_t offset = 0;
+            for (int r = 0; r < workerCount; ++r) {
+                uint64_t bytes = 0;
+                if (payload.size() - offset < sizeof(bytes)) {
+                    break;
+                }
+                std::memcpy(&bytes, payload.data() + offset, sizeof(bytes));
+                size_t segmentSize = sizeof(bytes) + bytes;
+                if (bytes > payload.size() - offset - sizeof(bytes)) {
+                    break;
+                }
+                if (r != w && bytes > EMPTY_SEGMENT_BYTES) {
+                    inbound[r].insert(inbound[r].end(), payload.begin() + offset, payload.begin() + offset + segmentSize);
+                    inboundSegments[r]++;
+                }
+                offset += segmentSize;
+            }
+            if (offset != payload.size()) {
+                std::cerr << "Error: Partition worker " << w << " sent a malformed exchange.\n";
+                stopWorkers();
+                return NetworkRunResult();
+            }
+        }
+    }
+    
+    stopWorkers();
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    result.simulatedSeconds = config.seconds;
+    return result;
+}
+#else
+bool PartitionedSimulation::startWorkers(std::chrono::steady_clock::time_point) {
+    return false;
+}
+
+void PartitionedSimulation::stopWorkers() {
+}
+
+void PartitionedSimulation::serveRegion(uint32_t, int, std::chrono::steady_clock::time_point) {
+    std::abort();
+}
+
+NetworkRunResult PartitionedSimulation::run() {
+    std::cerr << "Error: Partitioned simulation needs fork() and Unix domain sockets; use the sharded one here.\n";
+    return NetworkRunResult();
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "../include/PlanSchedule.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+const char* const DAY_NAMES[7] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+
+}  // namespace
+
+uint16_t PlanSchedule::addPlan(const TimingPlan& plan) {
+    plans.push_back(plan);
+    return static_cast<uint16_t>(plans.size() - 1);
+}
+
+bool PlanSchedule::addPeriod(const PlanPeriod& period, std::string& error) {
+    if (period.plan >= plans.size()) {
+        error = "period names plan " + std::to_string(period.plan) + " but only " + std::to_string(plans.size()) +
+                " plans exist";
+        return false;
+    }
+    if (period.startMinute < 0 || period.startMinute >= 24 * 60) {
+        error = "start minute " + std::to_string(period.startMinute) + " is outside the day";
+        return false;
+    }
+    if ((period.days & 0x7F) == 0) {
+        error = "period applies to no weekday";
+        return false;
+    }
+    periods.push_back(period);
+    return true;
+}
+
+void PlanSchedule::compile() {
+    transitions.clear();
+    for (const PlanPeriod& period : periods) {
+        for (int day = 0; day < 7; ++day) {
+            if (period.days & (1u << day)) {
+                transitions.push_back({day * 24 * 3600 + period.startMinute * 60, period.plan});
+            }
+        }
+    }
+    if (transitions.empty() && !plans.empty()) {
+        transitions.push_back({0, 0});   // No periods: the first plan all week
+    }
+    
+    // Stable, so of two entries at the same second the later period's comes last and is kept
+    std::stable_sort(transitions.begin(), transitions.end(),
+                     [](const Transition& a, const Transition& b) { return a.weekSecond < b.weekSecond; });
+    std::vector<Transition> merged;
+    for (const Transition& transition : transitions) {
+        if (!merged.empty() && merged.back().weekSecond == transition.weekSecond) {
+            merged.back() = transition;
+        } else {
+            merged.push_back(transition);
+        }
+    }
+    
+    // A change to the plan already in force is no change; the week wraps, so
+    // the last entry precedes the first
+    transitions.clear();
+    for (size_t i = 0; i < merged.size(); ++i) {
+        if (merged[i].plan != merged[(i + merged.size() - 1) % merged.size()].plan) {
+            transitions.push_back(merged[i]);
+        }
+    }
+    if (transitions.empty() && !merged.empty()) {
+        transitions.push_back({0, merged.front().plan});   // One plan all week
+    }
+}
+
+PlanSchedule PlanSchedule::rushHours(const TimingPlan& base) {
+    PlanSchedule schedule;
+    TimingPlan rush = base;
+    rush.name = "Rush hour";
+    for (int dir : {0, 1}) {   // NORTH, SOUTH
+        rush.greenSeconds[dir] = 40;
+        rush.yellowSeconds[dir] = 5;
+    }
+    uint16_t normal = schedule.addPlan(base);
+    uint16_t peak = schedule.addPlan(rush);
+    
+    std::string error;
+    for (int hour : {7, 17}) {
+        schedule.addPeriod({0x7F, hour * 60, peak}, error);
+        schedule.addPeriod({0x7F, (hour + 3) * 60, normal}, error);
+    }
+    schedule.compile();
+    return schedule;
+}
+
+size_t PlanSchedule::locate(int32_t weekSecond) const {
+    auto after = std::upper_bound(transitions.begin(), transitions.end(), weekSecond,
+                                  [](int32_t second, const Transition& t) { return second < t.weekSecond; });
+    // Before the first transition of the week the last one is still in force
+    return after == transitions.begin() ? transitions.size() - 1 : static_cast<size_t>(after - transitions.begin()) - 1;
+}
+
+int32_t PlanSchedule::secondsUntilNext(int32_t weekSecond) const {
+    if (transitions.size() <= 1) {
+        return WEEK_SECONDS;
+    }
+    size_t next = (locate(weekSecond) + 1) % transitions.size();
+    int32_t until = transitions[next].weekSecond - weekSecond;
+    return until > 0 ? until : until + WEEK_SECONDS;
+}
+
+const TimingPlan& PlanSchedule::getPlan(size_t index) const {
+    return plans[index];
+}
+
+size_t PlanSchedule::getPlanCount() const {
+    return plans.size();
+}
+
+const std::vector<PlanPeriod>& PlanSchedule::getPeriods() const {
+    return periods;
+}
+
+const std::vector<PlanSchedule::Transition>& PlanSchedule::getTransitions() const {
+    return transitions;
+}
+
+void PlanSchedule::display() const {
+    std::cout << "Plans:\n";
+    for (size_t i = 0; i < plans.size(); ++i) {
+        const TimingPlan& plan = plans[i];
+        std::cout << "  " << i << ". " << (plan.name.empty() ? "Plan " + std::to_string(i) : plan.name)
+                  << ": green N/S/E/W " << plan.greenSeconds[0] << "/" << plan.greenSeconds[1] << "/"
+                  << plan.greenSeconds[2] << "/" << plan.greenSeconds[3] << " s, yellow "
+                  << plan.yellowSeconds[0] << "/" << plan.yellowSeconds[1] << "/" << plan.yellowSeconds[2] << "/"
+                  << plan.yellowSeconds[3] << " s";
+        if (plan.offset >= 0) {
+            std::cout << ", offset " << plan.offset << " s";
+        }
+        std::cout << "\n";
+    }
+    std::cout << "Transitions:\n";
+    for (const Transition& transition : transitions) {
+        int32_t minute = transition.weekSecond / 60;
+        std::cout << "  " << DAY_NAMES[minute / (24 * 60)] << " " << std::setw(2) << std::setfill('0')
+                  << (minute / 60) % 24 << ":" << std::setw(2) << minute % 60 << std::setfill(' ')
+                  << " -> plan " << transition.plan << "\n";
+    }
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "../include/PlanScheduler.h"
+#include "../include/Intersection.h"
+#include "../include/TraceProfiler.h"
+#include <algorithm>
+#include <ctime>
+
+namespace {
+
+const int32_t DAY_SECONDS = 24 * 3600;
+
+int wrapSeconds(int value, int cycle) {
+    return ((value % cycle) + cycle) % cycle;
+}
+
+void applyPlan(Intersection& intersection, const TimingPlan& plan) {
+    for (int d = 0; d < 4; ++d) {
+        intersection.configureTiming(static_cast<Direction>(d), plan.greenSeconds[d], plan.yellowSeconds[d]);
+    }
+}
+
+}  // namespace
+
+void PlanScheduler::rebuild(const std::vector<std::unique_ptr<Intersection>>& intersections,
+                            std::chrono::steady_clock::time_point now) {
+    clear();
+    slots.resize(intersections.size());
+    for (size_t i = 0; i < intersections.size(); ++i) {
+        const PlanSchedule* schedule = intersections[i]->getPlanSchedule().get();
+        if (schedule && !schedule->getTransitions().empty()) {
+            events.push({now, static_cast<uint32_t>(i), EventKind::BOUNDARY});
+        }
+    }
+}
+
+void PlanScheduler::clear() {
+    events = decltype(events)();
+    slots.clear();
+}
+
+int32_t PlanScheduler::weekSecond(std::chrono::system_clock::time_point wallNow) {
+    std::time_t time = std::chrono::system_clock::to_time_t(wallNow);
+    std::tm local = *std::localtime(&time);
+    return local.tm_wday * DAY_SECONDS + local.tm_hour * 3600 + local.tm_min * 60 + std::min(local.tm_sec, 59);
+}
+
+void PlanScheduler::advance(std::vector<std::unique_ptr<Intersection>>& intersections,
+                            std::chrono::steady_clock::time_point now, std::chrono::system_clock::time_point wallNow) {
+    if (events.empty() || events.top().due > now) {
+        return;
+    }
+    TRAFFIC_TRACE_SCOPE("PlanScheduler::advance");
+    
+    // Everything due is handled as of now
+    int32_t week = weekSecond(wallNow);
+    stats.clockReads++;
+    while (!events.empty() && events.top().due <= now) {
+        Event event = events.top();
+        events.pop();
+        if (event.slot >= intersections.size() || event.slot >= slots.size()) {
+            continue;
+        }
+        Intersection& intersection = *intersections[event.slot];
+        SlotState& state = slots[event.slot];
+        const PlanSchedule* schedule = intersection.getPlanSchedule().get();
+        if (!schedule || schedule->getTransitions().empty()) {
+            state = SlotState();   // Taken off its schedule; its events lapse
+            continue;
+        }
+        if (schedule != state.schedule) {
+            state.schedule = schedule;
+            state.plan = -1;
+        }
+        
+        if (event.kind == EventKind::BOUNDARY) {
+            uint16_t plan = schedule->getTransitions()[schedule->locate(week)].plan;
+            if (plan != state.plan) {
+                applyPlan(intersection, schedule->getPlan(plan));
+                state.plan = plan;
+                stats.planChanges++;
+                
+                // The new timing starts with the next phase; seeking the offset starts there too
+                if (schedule->getPlan(plan).offset >= 0 && !state.seeking) {
+                    state.seeking = true;
+                    int untilNextPhase = std::max(1, intersection.getPhaseLength() - intersection.getPhaseTimer() + 1);
+                    events.push({now + std::chrono::seconds(untilNextPhase), event.slot, EventKind::SEEK});
+                }
+            }
+            events.push({now + std::chrono::seconds(schedule->secondsUntilNext(week)), event.slot, EventKind::BOUNDARY});
+            continue;
+        }
+        
+        const TimingPlan& plan = schedule->getPlan(static_cast<size_t>(std::max(0, state.plan)));
+        int wait = state.plan >= 0 && plan.offset >= 0 ? seekOffset(intersection, plan, week % DAY_SECONDS) : 0;
+        if (wait > 0) {
+            events.push({now + std::chrono::seconds(wait), event.slot, EventKind::SEEK});
+        } else {
+            state.seeking = false;
+            stats.offsetsReached += state.plan >= 0 && plan.offset >= 0 ? 1 : 0;
+        }
+    }
+}
+
+int PlanScheduler::seekOffset(Intersection& intersection, const TimingPlan& plan, int32_t secondOfDay) {
+    int cycle = intersection.getCycleLength();
+    if (cycle <= 0) {
+        return 0;
+    }
+    if (intersection.hasRingBarrierPlan() || intersection.isEmergencyMode()) {
+        return cycle;   // Off the two-phase cycle for now; look again a cycle later
+    }
+    
+    // Seconds the cycle has to move ahead to line up with the offset
+    int target = wrapSeconds(secondOfDay - plan.offset, cycle);
+    int error = wrapSeconds(target - intersection.getCyclePosition(), cycle);
+    if (error == 0) {
+        return 0;
+    }
+    
+    int phase = intersection.getCurrentPhase();
+    int timer = intersection.getPhaseTimer();
+    int length = intersection.getPhaseLength();
+    int yellow = intersection.getPlannedYellow(phase);
+    int minGreen = (intersection.getPlannedPhaseLength(phase) - yellow) / 2;
+    int maxShorten = std::max(1, cycle * MAX_SHORTEN_PERCENT / 100);
+    int maxLengthen = std::max(1, cycle * MAX_LENGTHEN_PERCENT / 100);
+    
+    // Still in green: shorten or lengthen it, whichever reaches the offset in fewer steps
+    if (timer < length - yellow) {
+        bool shorten = (error + maxShorten - 1) / maxShorten <= (cycle - error + maxLengthen - 1) / maxLengthen;
+        int cut = std::max(0, std::min({error, maxShorten, length - yellow - std::max(minGreen, timer + 1)}));
+        int change = shorten ? -cut : std::min(cycle - error, maxLengthen);
+        if (change != 0) {
+            intersection.setPhaseLength(length + change);
+            stats.seekSteps++;
+        }
+    }
+    return std::max(1, intersection.getPhaseLength() - timer + 1);
+}
+
+size_t PlanScheduler::getPendingCount() const {
+    return events.size();
+}
+
+const PlanSchedulerStats& PlanScheduler::getStats() const {
+    return stats;
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "../include/RealTimeScheduler.h"
+#include <iostream>
+#include <algorithm>
+
+namespace {
+
+double toMilliseconds(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+}  // namespace
+
+double TickTimingStats::getAverageWorkMs() const {
+    return ticks > 0 ? totalWorkMs / ticks : 0.0;
+}
+
+double TickTimingStats::getAverageJitterMs() const {
+    return ticks > 0 ? totalJitterMs / ticks : 0.0;
+}
+
+RealTimeScheduler::RealTimeScheduler()
+    : period(std::chrono::seconds(1)), sheddingEnabled(false), behind(false) {
+    reset(std::chrono::steady_clock::now());
+}
+
+void RealTimeScheduler::setPeriod(std::chrono::steady_clock::duration newPeriod) {
+    if (newPeriod.count() > 0) {
+        period = newPeriod;
+        stats.periodMs = toMilliseconds(period);
+    }
+}
+
+void RealTimeScheduler::setLoadShedding(bool enabled) {
+    sheddingEnabled.store(enabled);
+}
+
+void RealTimeScheduler::reset(std::chrono::steady_clock::time_point now) {
+    nextRelease = now;
+    tickStart = now;
+    lastOverrunLog = now - std::chrono::seconds(1);
+    behind = false;
+    stats = TickTimingStats();
+    stats.periodMs = toMilliseconds(period);
+}
+
+void RealTimeScheduler::rebase(std::chrono::steady_clock::time_point now) {
+    nextRelease = now;
+    tickStart = now;
+    behind = false;
+}
+
+std::chrono::steady_clock::time_point RealTimeScheduler::getNextRelease() const {
+    return nextRelease;
+}
+
+void RealTimeScheduler::beginTick(std::chrono::steady_clock::time_point wakeTime) {
+    tickStart = wakeTime;
+    if (shouldShedWork()) {
+        stats.shedTicks++;
+    }
+    
+    double jitterMs = std::max(0.0, toMilliseconds(wakeTime - nextRelease));
+    stats.maxJitterMs = std::max(stats.maxJitterMs, jitterMs);
+    stats.totalJitterMs += jitterMs;
+}
+
+void RealTimeScheduler::endTick(std::chrono::steady_clock::time_point finishTime) {
+    double workMs = toMilliseconds(finishTime - tickStart);
+    stats.ticks++;
+    stats.lastWorkMs = workMs;
+    stats.maxWorkMs = std::max(stats.maxWorkMs, workMs);
+    stats.totalWorkMs += workMs;
+    
+    // The deadline of this tick is the release of the next one
+    nextRelease += period;
+    behind = finishTime > nextRelease;
+    
+    if (behind) {
+        stats.missedDeadlines++;
+        auto lateness = finishTime - nextRelease;
+        
+        // Drop the releases we already blew through instead of firing them back to back
+        auto droppedReleases = lateness / period + 1;
+        stats.skippedPeriods += droppedReleases;
+        nextRelease += period * droppedReleases;
+        
+        // Rate-limit the warning so an overloaded system doesn't also flood the console
+        if (finishTime - lastOverrunLog >= std::chrono::seconds(1)) {
+            std::cerr << "Warning: controller tick overran its deadline by " << toMilliseconds(lateness)
+                      << " ms (work " << workMs << " ms, " << stats.missedDeadlines << " missed so far)\n";
+            lastOverrunLog = finishTime;
+        }
+    }
+}
+
+bool RealTimeScheduler::shouldShedWork() const {
+    return sheddingEnabled.load() && behind;
+}
+
+std::chrono::steady_clock::duration RealTimeScheduler::getPeriod() const {
+    return period;
+}
+
+bool RealTimeScheduler::isLoadSheddingEnabled() const {
+    return sheddingEnabled.load();
+}
+
+const TickTimingStats& RealTimeScheduler::getStats() const {
+    return stats;
+}
\ No newline at end of file
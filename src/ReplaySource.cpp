@@ -0,0 +1,268 @@
+#include "../include/ReplaySource.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
+
+namespace {
+
+const char BINARY_MAGIC[8] = {'T', 'R', 'F', 'R', 'E', 'P', 'L', '1'};
+const uint32_t BINARY_VERSION = 1;
+const size_t BINARY_HEADER_SIZE = 24;
+const size_t BINARY_RECORD_SIZE = 16;
+
+const char* const VEHICLE_TYPE_NAMES[] = {
+    "CAR", "TRUCK", "BUS", "MOTORCYCLE", "AMBULANCE", "FIRE_TRUCK", "POLICE", "EMERGENCY"
+};
+
+// A [begin, end) slice of the mapping; fields are never copied out
+struct Field {
+    const char* begin;
+    const char* end;
+};
+
+bool nextField(const char*& p, const char* lineEnd, Field& field) {
+    if (p > lineEnd) {
+        return false;
+    }
+    
+    const char* comma = static_cast<const char*>(std::memchr(p, ',', static_cast<size_t>(lineEnd - p)));
+    const char* fieldEnd = comma ? comma : lineEnd;
+    
+    field.begin = p;
+    field.end = fieldEnd;
+    while (field.begin < field.end && (*field.begin == ' ' || *field.begin == '\t')) {
+        field.begin++;
+    }
+    while (field.end > field.begin && (field.end[-1] == ' ' || field.end[-1] == '\t' || field.end[-1] == '\r')) {
+        field.end--;
+    }
+    
+    p = comma ? comma + 1 : lineEnd + 1;
+    return field.begin < field.end;
+}
+
+bool parseInteger(const Field& field, int64_t& value) {
+    value = 0;
+    if (field.end - field.begin > 18) {
+        return false;   // 18 digits always fit in int64_t; longer runs could overflow
+    }
+    for (const char* c = field.begin; c < field.end; ++c) {
+        if (*c < '0' || *c > '9') {
+            return false;
+        }
+        value = value * 10 + (*c - '0');
+    }
+    return true;
+}
+
+bool equalsIgnoreCase(const Field& field, const char* name) {
+    size_t length = std::strlen(name);
+    if (static_cast<size_t>(field.end - field.begin) != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (std::toupper(static_cast<unsigned char>(field.begin[i])) != name[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parseApproach(const Field& field, Direction& dir) {
+    int64_t value;
+    if (parseInteger(field, value)) {
+        if (value > 3) {
+            return false;
+        }
+        dir = static_cast<Direction>(value);
+        return true;
+    }
+    
+    switch (std::toupper(static_cast<unsigned char>(*field.begin))) {
+        case 'N': dir = Direction::NORTH; return true;
+        case 'S': dir = Direction::SOUTH; return true;
+        case 'E': dir = Direction::EAST; return true;
+        case 'W': dir = Direction::WEST; return true;
+        default: return false;
+    }
+}
+
+bool parseVehicleType(const Field& field, VehicleType& type) {
+    int64_t value;
+    if (parseInteger(field, value)) {
+        if (value > 7) {
+            return false;
+        }
+        type = static_cast<VehicleType>(value);
+        return true;
+    }
+    
+    for (int i = 0; i < 8; ++i) {
+        if (equalsIgnoreCase(field, VEHICLE_TYPE_NAMES[i])) {
+            type = static_cast<VehicleType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+double ReplayResult::getSpeedup() const {
+    return wallSeconds > 0.0 ? simulatedSeconds / wallSeconds : 0.0;
+}
+
+double ReplayResult::getRecordsPerSecond() const {
+    return wallSeconds > 0.0 ? arrivals / wallSeconds : 0.0;
+}
+
+ReplaySource::ReplaySource()
+    : format(Format::CSV), cursor(nullptr), end(nullptr), recordsRead(0), malformedRecords(0) {
+}
+
+bool ReplaySource::open(const std::string& path) {
+    if (!file.open(path)) {
+        return false;
+    }
+    file.adviseSequential();
+    
+    format = Format::CSV;
+    if (file.size() >= BINARY_HEADER_SIZE && std::memcmp(file.data(), BINARY_MAGIC, sizeof(BINARY_MAGIC)) == 0) {
+        uint32_t version;
+        uint32_t recordSize;
+        std::memcpy(&version, file.data() + 8, sizeof(version));
+        std::memcpy(&recordSize, file.data() + 12, sizeof(recordSize));
+        if (version != BINARY_VERSION || recordSize != BINARY_RECORD_SIZE) {
+            std::cerr << "Error: Unsupported replay format version in " << path << ".\n";
+            file.close();
+            return false;
+        }
+        format = Format::BINARY;
+    }
+    
+    rewind();
+    return true;
+}
+
+void ReplaySource::rewind() {
+    cursor = file.data();
+    end = file.data() + file.size();
+    if (format == Format::BINARY && cursor) {
+        cursor += BINARY_HEADER_SIZE;
+    }
+    recordsRead = 0;
+    malformedRecords = 0;
+}
+
+bool ReplaySource::next(ReplayRecord& record) {
+    if (cursor == nullptr) {
+        return false;
+    }
+    return format == Format::BINARY ? nextBinary(record) : nextCsv(record);
+}
+
+bool ReplaySource::nextBinary(ReplayRecord& record) {
+    while (static_cast<size_t>(end - cursor) >= BINARY_RECORD_SIZE) {
+        uint8_t approach = static_cast<uint8_t>(cursor[12]);
+        uint8_t type = static_cast<uint8_t>(cursor[13]);
+        std::memcpy(&record.timestampMs, cursor, sizeof(record.timestampMs));
+        std::memcpy(&record.intersection, cursor + 8, sizeof(record.intersection));
+        cursor += BINARY_RECORD_SIZE;
+        
+        if (approach > 3 || type > 7) {
+            malformedRecords++;
+            continue;
+        }
+        record.approach = static_cast<Direction>(approach);
+        record.vehicleType = static_cast<VehicleType>(type);
+        recordsRead++;
+        return true;
+    }
+    return false;
+}
+
+bool ReplaySource::nextCsv(ReplayRecord& record) {
+    while (cursor < end) {
+        const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', static_cast<size_t>(end - cursor)));
+        const char* lineEnd = newline ? newline : end;
+        const char* p = cursor;
+        cursor = newline ? newline + 1 : end;
+        
+        while (p < lineEnd && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+        if (p == lineEnd || *p < '0' || *p > '9') {
+            continue;  // Blank line, header or comment
+        }
+        
+        Field timestamp, intersection, approach, type;
+        int64_t timestampValue, intersectionValue;
+        if (!nextField(p, lineEnd, timestamp) || !nextField(p, lineEnd, intersection) ||
+            !nextField(p, lineEnd, approach) || !nextField(p, lineEnd, type) ||
+            !parseInteger(timestamp, timestampValue) || !parseInteger(intersection, intersectionValue) ||
+            intersectionValue > UINT32_MAX ||
+            !parseApproach(approach, record.approach) || !parseVehicleType(type, record.vehicleType)) {
+            malformedRecords++;
+            continue;
+        }
+        
+        record.timestampMs = timestampValue;
+        record.intersection = static_cast<uint32_t>(intersectionValue);
+        recordsRead++;
+        return true;
+    }
+    return false;
+}
+
+ReplaySource::Format ReplaySource::getFormat() const {
+    return format;
+}
+
+size_t ReplaySource::getSizeBytes() const {
+    return file.size();
+}
+
+double ReplaySource::getProgress() const {
+    if (file.size() == 0 || cursor == nullptr) {
+        return 1.0;
+    }
+    return static_cast<double>(cursor - file.data()) / file.size();
+}
+
+uint64_t ReplaySource::getRecordsRead() const {
+    return recordsRead;
+}
+
+uint64_t ReplaySource::getMalformedRecords() const {
+    return malformedRecords;
+}
+
+bool ReplaySource::writeBinary(const std::string& path, const std::vector<ReplayRecord>& records) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open file " << path << " for writing.\n";
+        return false;
+    }
+    
+    uint32_t version = BINARY_VERSION;
+    uint32_t recordSize = BINARY_RECORD_SIZE;
+    uint64_t count = records.size();
+    out.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    out.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+    out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    
+    char buffer[BINARY_RECORD_SIZE];
+    for (const auto& record : records) {
+        std::memset(buffer, 0, sizeof(buffer));
+        std::memcpy(buffer, &record.timestampMs, sizeof(record.timestampMs));
+        std::memcpy(buffer + 8, &record.intersection, sizeof(record.intersection));
+        buffer[12] = static_cast<char>(record.approach);
+        buffer[13] = static_cast<char>(record.vehicleType);
+        out.write(buffer, sizeof(buffer));
+    }
+    
+    return static_cast<bool>(out);
+}
\ No newline at end of file
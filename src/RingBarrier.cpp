@@ -0,0 +1,406 @@
+#include "../include/RingBarrier.h"
+#include "../include/Checkpoint.h"
+#include <iostream>
+
+namespace {
+
+NemaPhase makePhase(MovementMask protectedMovements, MovementMask permittedMovements,
+                    int minGreen, int maxGreen, int yellow) {
+    NemaPhase phase;
+    phase.protectedMovements = protectedMovements;
+    phase.permittedMovements = permittedMovements;
+    phase.minGreen = minGreen;
+    phase.maxGreen = maxGreen;
+    phase.yellow = yellow;
+    return phase;
+}
+
+MovementMask throughAndRight(Direction approach) {
+    return movementBit(approach, Turn::THROUGH) | movementBit(approach, Turn::RIGHT);
+}
+
+std::string describeMovements(MovementMask movements) {
+    std::string names;
+    for (int m = 0; m < MOVEMENT_COUNT; ++m) {
+        if (movements & (1u << m)) {
+            names += (names.empty() ? "" : " ") + movementName(m);
+        }
+    }
+    return names.empty() ? "-" : names;
+}
+
+// First pair of conflicting movements between two sets, as "N-T x E-T"
+std::string describeConflict(MovementMask a, MovementMask b) {
+    const ConflictMatrix& matrix = ConflictMatrix::instance();
+    for (int m = 0; m < MOVEMENT_COUNT; ++m) {
+        MovementMask hit = (a & (1u << m)) ? matrix.conflictsOf(m) & b : 0;
+        for (int n = 0; hit && n < MOVEMENT_COUNT; ++n) {
+            if (hit & (1u << n)) {
+                return movementName(m) + " x " + movementName(n);
+            }
+        }
+    }
+    return "";
+}
+
+// Permitted movements may cross only protected movements of the opposing
+// approach, which they yield to; anything else has to be separated in time.
+MovementMask illegalPermittedConflicts(MovementMask permitted, MovementMask otherProtected, MovementMask otherPermitted) {
+    const ConflictMatrix& matrix = ConflictMatrix::instance();
+    MovementMask illegal = 0;
+    for (int m = 0; m < MOVEMENT_COUNT; ++m) {
+        if (permitted & (1u << m)) {
+            MovementMask yieldsTo = approachMovements(opposingApproach(movementApproach(m)));
+            MovementMask hit = matrix.conflictsOf(m) & ((otherProtected & ~yieldsTo) | otherPermitted);
+            if (hit) {
+                illegal |= static_cast<MovementMask>(1u << m);
+            }
+        }
+    }
+    return illegal;
+}
+
+bool checkPair(const NemaPhase& a, int aNumber, const NemaPhase& b, int bNumber, std::string& error) {
+    const ConflictMatrix& matrix = ConflictMatrix::instance();
+    std::string pair = aNumber == bNumber ? "Phase " + std::to_string(aNumber)
+                                          : "Phases " + std::to_string(aNumber) + " and " + std::to_string(bNumber);
+    
+    if (!matrix.compatible(a.protectedMovements, b.protectedMovements)) {
+        error = pair + " run together but conflict: " + describeConflict(a.protectedMovements, b.protectedMovements);
+        return false;
+    }
+    
+    MovementMask illegal = illegalPermittedConflicts(a.permittedMovements, b.protectedMovements, b.permittedMovements) |
+                           illegalPermittedConflicts(b.permittedMovements, a.protectedMovements, a.permittedMovements);
+    if (illegal) {
+        error = pair + ": permitted " + describeMovements(illegal) + " would cross traffic it does not yield to";
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+RingBarrierPlan::RingBarrierPlan() {
+    for (auto& ring : sequence) {
+        for (auto& group : ring) {
+            group.fill(0);
+        }
+    }
+}
+
+RingBarrierPlan RingBarrierPlan::standardEightPhase(int throughMaxGreen, int leftMaxGreen) {
+    RingBarrierPlan plan;
+    plan.setPhase(1, makePhase(movementBit(Direction::SOUTH, Turn::LEFT), 0, 5, leftMaxGreen, 3));
+    plan.setPhase(2, makePhase(throughAndRight(Direction::NORTH), 0, 10, throughMaxGreen, 4));
+    plan.setPhase(5, makePhase(movementBit(Direction::NORTH, Turn::LEFT), 0, 5, leftMaxGreen, 3));
+    plan.setPhase(6, makePhase(throughAndRight(Direction::SOUTH), 0, 10, throughMaxGreen, 4));
+    plan.setPhase(3, makePhase(movementBit(Direction::WEST, Turn::LEFT), 0, 5, leftMaxGreen, 3));
+    plan.setPhase(4, makePhase(throughAndRight(Direction::EAST), 0, 10, throughMaxGreen, 4));
+    plan.setPhase(7, makePhase(movementBit(Direction::EAST, Turn::LEFT), 0, 5, leftMaxGreen, 3));
+    plan.setPhase(8, makePhase(throughAndRight(Direction::WEST), 0, 10, throughMaxGreen, 4));
+    
+    plan.setSequence(0, 0, 1, 2);
+    plan.setSequence(0, 1, 3, 4);
+    plan.setSequence(1, 0, 5, 6);
+    plan.setSequence(1, 1, 7, 8);
+    return plan;
+}
+
+RingBarrierPlan RingBarrierPlan::twoPhasePermitted(int maxGreen) {
+    RingBarrierPlan plan;
+    const Direction approaches[4] = {Direction::NORTH, Direction::EAST, Direction::SOUTH, Direction::WEST};
+    const int numbers[4] = {2, 4, 6, 8};
+    for (int i = 0; i < 4; ++i) {
+        plan.setPhase(numbers[i], makePhase(throughAndRight(approaches[i]), movementBit(approaches[i], Turn::LEFT),
+                                            10, maxGreen, 4));
+    }
+    
+    plan.setSequence(0, 0, 2);
+    plan.setSequence(0, 1, 4);
+    plan.setSequence(1, 0, 6);
+    plan.setSequence(1, 1, 8);
+    return plan;
+}
+
+void RingBarrierPlan::setPhase(int number, const NemaPhase& phase) {
+    if (number >= 1 && number <= PHASES) {
+        phases[number - 1] = phase;
+    }
+}
+
+const NemaPhase& RingBarrierPlan::getPhase(int number) const {
+    return phases[number - 1];
+}
+
+void RingBarrierPlan::setSequence(int ring, int group, uint8_t first, uint8_t second) {
+    if (ring >= 0 && ring < RINGS && group >= 0 && group < GROUPS) {
+        sequence[ring][group] = {first, second};
+    }
+}
+
+uint8_t RingBarrierPlan::getSequence(int ring, int group, int slot) const {
+    return sequence[ring][group][slot];
+}
+
+MovementMask RingBarrierPlan::servedMovements() const {
+    MovementMask served = 0;
+    for (const auto& ring : sequence) {
+        for (const auto& group : ring) {
+            for (uint8_t number : group) {
+                if (number) {
+                    served |= phases[number - 1].served();
+                }
+            }
+        }
+    }
+    return served;
+}
+
+bool RingBarrierPlan::validate(std::string& error) const {
+    std::array<bool, PHASES> sequenced{};
+    
+    for (int group = 0; group < GROUPS; ++group) {
+        bool groupUsed = false;
+        for (int ring = 0; ring < RINGS; ++ring) {
+            for (uint8_t number : sequence[ring][group]) {
+                if (number == 0) {
+                    continue;
+                }
+                if (number > PHASES || sequenced[number - 1]) {
+                    error = "Phase " + std::to_string(number) + " is out of range or sequenced twice";
+                    return false;
+                }
+                sequenced[number - 1] = true;
+                groupUsed = true;
+                
+                const NemaPhase& phase = phases[number - 1];
+                if (phase.served() == 0) {
+                    error = "Phase " + std::to_string(number) + " is sequenced but serves no movement";
+                    return false;
+                }
+                if (phase.minGreen < 1 || phase.maxGreen < phase.minGreen || phase.yellow < 1 || phase.redClearance < 0) {
+                    error = "Phase " + std::to_string(number) + " has invalid timing";
+                    return false;
+                }
+                if (phase.protectedMovements & phase.permittedMovements) {
+                    error = "Phase " + std::to_string(number) + " lists a movement as both protected and permitted";
+                    return false;
+                }
+                if (!checkPair(phase, number, phase, number, error)) {
+                    return false;
+                }
+            }
+        }
+        if (!groupUsed) {
+            error = "Barrier group " + std::to_string(group + 1) + " has no phases";
+            return false;
+        }
+        
+        // Each ring's phases in this group time concurrently with each of the other ring's
+        for (uint8_t a : sequence[0][group]) {
+            for (uint8_t b : sequence[1][group]) {
+                if (a && b && !checkPair(phases[a - 1], a, phases[b - 1], b, error)) {
+                    return false;
+                }
+            }
+        }
+    }
+    
+    for (int number = 1; number <= PHASES; ++number) {
+        if (!sequenced[number - 1] && phases[number - 1].served() != 0) {
+            error = "Phase " + std::to_string(number) + " serves movements but is not sequenced";
+            return false;
+        }
+    }
+    return true;
+}
+
+void RingBarrierPlan::display() const {
+    for (int ring = 0; ring < RINGS; ++ring) {
+        std::cout << "Ring " << ring + 1 << ":";
+        for (int group = 0; group < GROUPS; ++group) {
+            std::cout << (group ? " ||" : "");
+            for (uint8_t number : sequence[ring][group]) {
+                if (number) {
+                    const NemaPhase& phase = phases[number - 1];
+                    std::cout << "  [" << static_cast<int>(number) << ": " << describeMovements(phase.protectedMovements);
+                    if (phase.permittedMovements) {
+                        std::cout << " (" << describeMovements(phase.permittedMovements) << ")";
+                    }
+                    std::cout << " " << phase.minGreen << "-" << phase.maxGreen << "s]";
+                }
+            }
+        }
+        std::cout << "\n";
+    }
+}
+
+void RingBarrierPlan::writeCheckpoint(CheckpointWriter& out) const {
+    for (const auto& phase : phases) {
+        out.put(phase.protectedMovements);
+        out.put(phase.permittedMovements);
+        out.put(static_cast<int32_t>(phase.minGreen));
+        out.put(static_cast<int32_t>(phase.maxGreen));
+        out.put(static_cast<int32_t>(phase.yellow));
+        out.put(static_cast<int32_t>(phase.redClearance));
+    }
+    out.put(sequence);
+}
+
+void RingBarrierPlan::readCheckpoint(CheckpointReader& in) {
+    for (auto& phase : phases) {
+        phase.protectedMovements = in.get<MovementMask>();
+        phase.permittedMovements = in.get<MovementMask>();
+        phase.minGreen = in.get<int32_t>();
+        phase.maxGreen = in.get<int32_t>();
+        phase.yellow = in.get<int32_t>();
+        phase.redClearance = in.get<int32_t>();
+    }
+    sequence = in.get<decltype(sequence)>();
+}
+
+RingBarrierState::RingBarrierState()
+    : barrierGroup(0), slot{0, 0}, interval{RingInterval::BARRIER, RingInterval::BARRIER}, timer{0, 0} {
+}
+
+RingBarrierState::RingBarrierState(const RingBarrierPlan& validatedPlan) : RingBarrierState() {
+    plan = validatedPlan;
+    restart();
+}
+
+void RingBarrierState::restart() {
+    startGroup(0);
+}
+
+void RingBarrierState::startGroup(int group) {
+    barrierGroup = group;
+    for (int ring = 0; ring < RingBarrierPlan::RINGS; ++ring) {
+        startSlot(ring, 0);
+    }
+}
+
+void RingBarrierState::startSlot(int ring, int position) {
+    while (position < RingBarrierPlan::GROUP_SLOTS && plan.getSequence(ring, barrierGroup, position) == 0) {
+        position++;
+    }
+    slot[ring] = static_cast<uint8_t>(position);
+    interval[ring] = position < RingBarrierPlan::GROUP_SLOTS ? RingInterval::GREEN : RingInterval::BARRIER;
+    timer[ring] = 0;
+}
+
+bool RingBarrierState::step(MovementMask demand) {
+    for (int ring = 0; ring < RingBarrierPlan::RINGS; ++ring) {
+        if (interval[ring] == RingInterval::BARRIER) {
+            continue;
+        }
+        
+        const NemaPhase& phase = plan.getPhase(getActivePhase(ring));
+        timer[ring]++;
+        
+        if (interval[ring] == RingInterval::GREEN) {
+            // Gap out once nothing is waiting for this phase, max out regardless
+            bool gapOut = timer[ring] >= phase.minGreen && !(demand & phase.served());
+            if (gapOut || timer[ring] >= phase.maxGreen) {
+                interval[ring] = RingInterval::YELLOW;
+                timer[ring] = 0;
+            }
+        } else if (interval[ring] == RingInterval::YELLOW && timer[ring] >= phase.yellow) {
+            interval[ring] = RingInterval::RED_CLEARANCE;
+            timer[ring] = 0;
+        }
+        
+        if (interval[ring] == RingInterval::RED_CLEARANCE && timer[ring] >= phase.redClearance) {
+            startSlot(ring, slot[ring] + 1);
+        }
+    }
+    
+    for (int ring = 0; ring < RingBarrierPlan::RINGS; ++ring) {
+        if (interval[ring] != RingInterval::BARRIER) {
+            return false;
+        }
+    }
+    startGroup((barrierGroup + 1) % RingBarrierPlan::GROUPS);
+    return true;
+}
+
+const RingBarrierPlan& RingBarrierState::getPlan() const {
+    return plan;
+}
+
+int RingBarrierState::getBarrierGroup() const {
+    return barrierGroup;
+}
+
+int RingBarrierState::getActivePhase(int ring) const {
+    if (interval[ring] == RingInterval::BARRIER) {
+        return 0;
+    }
+    return plan.getSequence(ring, barrierGroup, slot[ring]);
+}
+
+RingInterval RingBarrierState::getInterval(int ring) const {
+    return interval[ring];
+}
+
+int RingBarrierState::getIntervalTimer(int ring) const {
+    return timer[ring];
+}
+
+MovementMask RingBarrierState::getProtectedGreen() const {
+    MovementMask movements = 0;
+    for (int ring = 0; ring < RingBarrierPlan::RINGS; ++ring) {
+        if (interval[ring] == RingInterval::GREEN) {
+            movements |= plan.getPhase(getActivePhase(ring)).protectedMovements;
+        }
+    }
+    return movements;
+}
+
+MovementMask RingBarrierState::getPermittedGreen() const {
+    MovementMask movements = 0;
+    for (int ring = 0; ring < RingBarrierPlan::RINGS; ++ring) {
+        if (interval[ring] == RingInterval::GREEN) {
+            movements |= plan.getPhase(getActivePhase(ring)).permittedMovements;
+        }
+    }
+    return movements;
+}
+
+MovementMask RingBarrierState::getYellow() const {
+    MovementMask movements = 0;
+    for (int ring = 0; ring < RingBarrierPlan::RINGS; ++ring) {
+        if (interval[ring] == RingInterval::YELLOW) {
+            movements |= plan.getPhase(getActivePhase(ring)).served();
+        }
+    }
+    return movements;
+}
+
+void RingBarrierState::writeCheckpoint(CheckpointWriter& out) const {
+    plan.writeCheckpoint(out);
+    out.put(static_cast<uint8_t>(barrierGroup));
+    out.put(slot);
+    out.put(interval);
+    out.put(std::array<int32_t, RingBarrierPlan::RINGS>{timer[0], timer[1]});
+}
+
+void RingBarrierState::readCheckpoint(CheckpointReader& in) {
+    plan.readCheckpoint(in);
+    barrierGroup = in.get<uint8_t>();
+    slot = in.get<decltype(slot)>();
+    interval = in.get<decltype(interval)>();
+    auto timers = in.get<std::array<int32_t, RingBarrierPlan::RINGS>>();
+    
+    std::string error;
+    bool valid = barrierGroup < RingBarrierPlan::GROUPS && plan.validate(error);
+    for (int ring = 0; ring < RingBarrierPlan::RINGS; ++ring) {
+        timer[ring] = timers[ring];
+        valid = valid && static_cast<uint8_t>(interval[ring]) <= static_cast<uint8_t>(RingInterval::BARRIER) &&
+                (interval[ring] == RingInterval::BARRIER || (slot[ring] < RingBarrierPlan::GROUP_SLOTS &&
+                                                             getActivePhase(ring) != 0));
+    }
+    if (!valid) {
+        in.fail();
+    }
+}
\ No newline at end of file
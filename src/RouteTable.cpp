@@ -0,0 +1,339 @@
+#include "../include/RouteTable.h"
+#include "../include/TraceProfiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <thread>
+
+namespace {
+
+uint64_t pairKey(uint32_t origin, uint32_t destination) {
+    return (static_cast<uint64_t>(origin) << 32) | destination;
+}
+
+const uint32_t UNREACHED = std::numeric_limits<uint32_t>::max();
+
+uint64_t mix(uint64_t x) {
+    // splitmix64 finaliser
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+// The network as a graph of links: a link's successors are the links a
+// vehicle may take after it, i.e. legal turns out of a signalled approach.
+// Read-only, shared by every search thread.
+struct LinkGraph {
+    std::vector<uint32_t> cost;         // Per link, travel time as the simulation rounds it
+    std::vector<uint32_t> to;           // Per link, its end node
+    std::vector<uint32_t> successorBegin;
+    std::vector<uint32_t> successors;
+    uint32_t longest;
+    
+    // Free-flow costs unless linkSeconds (one per link) is given
+    LinkGraph(const ScenarioFile& scenario, const std::vector<uint32_t>* linkSeconds) : longest(1) {
+        const ScenarioLink* links = scenario.outgoingBegin(0);
+        uint32_t linkCount = scenario.getLinkCount();
+        cost.resize(linkCount);
+        to.resize(linkCount);
+        successorBegin.assign(linkCount + 1, 0);
+        for (uint32_t l = 0; l < linkCount; ++l) {
+            const ScenarioLink& link = links[l];
+            cost[l] = linkSeconds ? std::max(1u, (*linkSeconds)[l]) : RouteTable::getFreeFlowSeconds(link);
+            to[l] = link.to;
+            longest = std::max(longest, cost[l]);
+            
+            // Through traffic needs a signal head on the approach it arrives on
+            if (scenario.getNode(link.to).approachMask & (1u << link.heading)) {
+                for (const ScenarioLink* next = scenario.outgoingBegin(link.to); next != scenario.outgoingEnd(link.to); ++next) {
+                    Turn turn;
+                    if (turnBetween(static_cast<Direction>(link.heading), static_cast<Direction>(next->heading), turn)) {
+                        successors.push_back(static_cast<uint32_t>(next - links));
+                    }
+                }
+            }
+            successorBegin[l + 1] = static_cast<uint32_t>(successors.size());
+        }
+    }
+};
+
+// Scratch for one search, reused across origins by one thread. Costs are
+// whole seconds, so the frontier is a ring of buckets one second apart
+// (Dial's algorithm) instead of a heap.
+struct SearchSpace {
+    std::vector<uint32_t> cost;         // Per link, from leaving the origin to reaching its end
+    std::vector<int32_t> previous;      // Per link, -1 for a first link
+    std::vector<int32_t> reachedBy;     // Per node, first settled link into it
+    std::vector<uint8_t> wanted;        // Per node, a destination of the current origin
+    std::vector<std::vector<uint32_t>> buckets;  // Links by cost modulo the bucket count
+    std::vector<uint32_t> touchedLinks;
+    std::vector<uint32_t> touchedNodes;
+    
+    SearchSpace(const LinkGraph& graph, uint32_t nodeCount)
+        : cost(graph.cost.size(), UNREACHED), previous(graph.cost.size(), -1), reachedBy(nodeCount, -1),
+          wanted(nodeCount, 0), buckets(graph.longest + 1) {}
+    
+    void reset() {
+        for (uint32_t link : touchedLinks) {
+            cost[link] = UNREACHED;
+            previous[link] = -1;
+        }
+        for (uint32_t node : touchedNodes) {
+            reachedBy[node] = -1;
+            wanted[node] = 0;
+        }
+        touchedLinks.clear();
+        touchedNodes.clear();
+    }
+};
+
+// Settles links outward from origin until every destination has been reached
+void searchFrom(const ScenarioFile& scenario, const LinkGraph& graph, uint32_t origin, const uint32_t* destinations,
+                size_t destinationCount, SearchSpace& space) {
+    const uint32_t bucketCount = static_cast<uint32_t>(space.buckets.size());
+    size_t queued = 0;
+    
+    auto relax = [&](uint32_t link, uint32_t cost, int32_t from) {
+        if (cost < space.cost[link]) {
+            if (space.cost[link] == UNREACHED) {
+                space.touchedLinks.push_back(link);
+            }
+            space.cost[link] = cost;
+            space.previous[link] = from;
+            space.buckets[cost % bucketCount].push_back(link);
+            queued++;
+        }
+    };
+    
+    // Trips start in a signalled queue at the origin, so only exits reachable from one count
+    const ScenarioLink* links = scenario.outgoingBegin(0);
+    uint8_t originApproaches = scenario.getNode(origin).approachMask;
+    for (const ScenarioLink* link = scenario.outgoingBegin(origin); link != scenario.outgoingEnd(origin); ++link) {
+        Direction approach;
+        Turn turn;
+        uint32_t index = static_cast<uint32_t>(link - links);
+        if (approachFor(originApproaches, static_cast<Direction>(link->heading), approach, turn)) {
+            relax(index, graph.cost[index], -1);
+        }
+    }
+    
+    size_t remaining = 0;
+    for (size_t i = 0; i < destinationCount; ++i) {
+        if (!space.wanted[destinations[i]]) {
+            space.wanted[destinations[i]] = 1;
+            space.touchedNodes.push_back(destinations[i]);
+            remaining++;
+        }
+    }
+    
+    for (uint32_t current = 0; queued > 0; ++current) {
+        // Relaxing adds at least one second, so the bucket being drained never grows
+        std::vector<uint32_t>& bucket = space.buckets[current % bucketCount];
+        for (size_t b = 0; b < bucket.size(); ++b) {
+            uint32_t settled = bucket[b];
+            queued--;
+            if (space.cost[settled] != current || remaining == 0) {
+                continue;  // Superseded, or nothing left to find
+            }
+            
+            uint32_t node = graph.to[settled];
+            if (space.reachedBy[node] < 0) {
+                space.reachedBy[node] = static_cast<int32_t>(settled);
+                space.touchedNodes.push_back(node);
+                if (space.wanted[node]) {
+                    remaining--;
+                }
+            }
+            for (uint32_t s = graph.successorBegin[settled]; s < graph.successorBegin[settled + 1]; ++s) {
+                uint32_t next = graph.successors[s];
+                relax(next, current + graph.cost[next], static_cast<int32_t>(settled));
+            }
+        }
+        bucket.clear();
+    }
+}
+
+// Shortest route for every pair (sorted, so pairs sharing an origin are
+// adjacent), one search per origin, origins spread over threads. Unreachable
+// pairs get an empty route.
+void routePairs(const ScenarioFile& scenario, const LinkGraph& graph, const std::vector<uint64_t>& pairs, int threads,
+                std::vector<std::vector<uint32_t>>& pairLinks, std::vector<uint32_t>& pairCost) {
+    pairLinks.assign(pairs.size(), std::vector<uint32_t>());
+    pairCost.assign(pairs.size(), UNREACHED);
+    
+    // Pairs [originBegin[k], originBegin[k + 1]) share an origin
+    std::vector<size_t> originBegin;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (i == 0 || (pairs[i] >> 32) != (pairs[i - 1] >> 32)) {
+            originBegin.push_back(i);
+        }
+    }
+    originBegin.push_back(pairs.size());
+    
+    std::atomic<size_t> nextOrigin(0);
+    auto worker = [&]() {
+        SearchSpace space(graph, scenario.getNodeCount());
+        std::vector<uint32_t> destinations;
+        for (size_t k = nextOrigin.fetch_add(1); k + 1 < originBegin.size(); k = nextOrigin.fetch_add(1)) {
+            uint32_t origin = static_cast<uint32_t>(pairs[originBegin[k]] >> 32);
+            destinations.clear();
+            for (size_t i = originBegin[k]; i < originBegin[k + 1]; ++i) {
+                destinations.push_back(static_cast<uint32_t>(pairs[i]));
+            }
+            
+            searchFrom(scenario, graph, origin, destinations.data(), destinations.size(), space);
+            for (size_t i = originBegin[k]; i < originBegin[k + 1]; ++i) {
+                int32_t link = space.reachedBy[static_cast<uint32_t>(pairs[i])];
+                if (link < 0) {
+                    continue;
+                }
+                pairCost[i] = space.cost[link];
+                auto& route = pairLinks[i];
+                for (; link >= 0; link = space.previous[link]) {
+                    route.push_back(static_cast<uint32_t>(link));
+                }
+                std::reverse(route.begin(), route.end());
+            }
+            space.reset();
+        }
+    };
+    
+    int threadCount = threads > 0 ? threads : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    threadCount = std::max(1, std::min<int>(threadCount, static_cast<int>(originBegin.size() - 1)));
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threadCount; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+}
+
+}  // namespace
+
+RouteTable::RouteTable()
+    : unroutable(0), buildMilliseconds(0.0) {
+}
+
+uint32_t RouteTable::getFreeFlowSeconds(const ScenarioLink& link) {
+    // Same rounding as the network simulation, so the shortest route is the fastest one there
+    double seconds = link.freeFlowSpeed > 0.0f ? link.lengthMeters / link.freeFlowSpeed : 1.0;
+    return static_cast<uint32_t>(std::max(1, static_cast<int32_t>(seconds + 0.999)));
+}
+
+void RouteTable::build(const ScenarioFile& scenario, int threads) {
+    TRAFFIC_TRACE_SCOPE("RouteTable::build");
+    
+    auto start = std::chrono::steady_clock::now();
+    clear();
+    uint32_t tripCount = scenario.getTripCount();
+    if (tripCount == 0 || scenario.getNodeCount() == 0) {
+        return;
+    }
+    
+    // Distinct OD pairs, sorted so route ids don't depend on thread timing
+    std::vector<uint64_t> candidates;
+    candidates.reserve(tripCount);
+    for (uint32_t t = 0; t < tripCount; ++t) {
+        const ScenarioTrip& trip = scenario.getTrip(t);
+        if (trip.origin != trip.destination) {
+            candidates.push_back(pairKey(trip.origin, trip.destination));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    
+    std::vector<std::vector<uint32_t>> pairLinks;
+    std::vector<uint32_t> pairCost;
+    routePairs(scenario, LinkGraph(scenario, nullptr), candidates, threads, pairLinks, pairCost);
+    
+    // Route id = position among the routable pairs
+    routeBegin.push_back(0);
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (pairCost[i] != UNREACHED) {
+            pairs.push_back(candidates[i]);
+            routeLinks.insert(routeLinks.end(), pairLinks[i].begin(), pairLinks[i].end());
+            routeBegin.push_back(static_cast<uint32_t>(routeLinks.size()));
+        }
+    }
+    
+    pairDemand.assign(pairs.size(), 0.0);
+    tripRoute.resize(tripCount);
+    for (uint32_t t = 0; t < tripCount; ++t) {
+        tripRoute[t] = findRoute(scenario.getTrip(t).origin, scenario.getTrip(t).destination);
+        if (tripRoute[t] == Vehicle::NO_ROUTE) {
+            unroutable++;
+        } else {
+            pairDemand[tripRoute[t]] += scenario.getTrip(t).tripsPerHour;
+        }
+    }
+    buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+ReassignResult RouteTable::reassign(const ScenarioFile& scenario, const std::vector<uint32_t>& linkSeconds,
+                                    double fraction, uint32_t iteration, int threads) {
+    TRAFFIC_TRACE_SCOPE("RouteTable::reassign");
+    
+    auto start = std::chrono::steady_clock::now();
+    ReassignResult result;
+    if (pairs.empty() || linkSeconds.size() != scenario.getLinkCount()) {
+        return result;
+    }
+    
+    std::vector<std::vector<uint32_t>> shortest;
+    std::vector<uint32_t> shortestCost;
+    routePairs(scenario, LinkGraph(scenario, &linkSeconds), pairs, threads, shortest, shortestCost);
+    
+    // Gap over the routes as they are, then move a share of the improvable pairs
+    double excess = 0.0;
+    double total = 0.0;
+    std::vector<uint32_t> newBegin(1, 0);
+    std::vector<uint32_t> newLinks;
+    newLinks.reserve(routeLinks.size());
+    for (uint32_t route = 0; route < pairs.size(); ++route) {
+        double current = 0.0;
+        for (uint32_t i = routeBegin[route]; i < routeBegin[route + 1]; ++i) {
+            current += std::max(1u, linkSeconds[routeLinks[i]]);
+        }
+        double best = std::min<double>(current, shortestCost[route]);
+        excess += pairDemand[route] * (current - best);
+        total += pairDemand[route] * current;
+        
+        bool improvable = best < current;
+        result.improvablePairs += improvable ? 1 : 0;
+        uint64_t h = mix(mix(pairs[route]) ^ iteration);
+        if (improvable && static_cast<double>(h >> 11) * (1.0 / 9007199254740992.0) < fraction) {
+            newLinks.insert(newLinks.end(), shortest[route].begin(), shortest[route].end());
+            result.reroutedPairs++;
+        } else {
+            newLinks.insert(newLinks.end(), routeLinks.begin() + routeBegin[route], routeLinks.begin() + routeBegin[route + 1]);
+        }
+        newBegin.push_back(static_cast<uint32_t>(newLinks.size()));
+    }
+    routeBegin.swap(newBegin);
+    routeLinks.swap(newLinks);
+    
+    result.relativeGap = total > 0.0 ? excess / total : 0.0;
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+void RouteTable::clear() {
+    pairs.clear();
+    pairDemand.clear();
+    routeBegin.clear();
+    routeLinks.clear();
+    tripRoute.clear();
+    unroutable = 0;
+    buildMilliseconds = 0.0;
+}
+
+uint32_t RouteTable::findRoute(uint32_t origin, uint32_t destination) const {
+    auto it = std::lower_bound(pairs.begin(), pairs.end(), pairKey(origin, destination));
+    return it != pairs.end() && *it == pairKey(origin, destination) ? static_cast<uint32_t>(it - pairs.begin())
+                                                                     : Vehicle::NO_ROUTE;
+}
\ No newline at end of file
@@ -0,0 +1,357 @@
+#include "../include/Scenario.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char FILE_MAGIC[8] = {'T', 'R', 'F', 'S', 'C', 'E', 'N', '1'};
+const uint32_t FORMAT_VERSION = 1;
+const size_t HEADER_SIZE = 16;
+const size_t SECTION_ENTRY_SIZE = 24;
+
+static_assert(sizeof(ScenarioNode) == 28, "ScenarioNode layout is part of the file format");
+static_assert(sizeof(ScenarioLink) == 24, "ScenarioLink layout is part of the file format");
+static_assert(sizeof(ScenarioPhasePlan) == 16, "ScenarioPhasePlan layout is part of the file format");
+static_assert(sizeof(ScenarioDemandProfile) == 16, "ScenarioDemandProfile layout is part of the file format");
+static_assert(sizeof(ScenarioTrip) == 16, "ScenarioTrip layout is part of the file format");
+
+struct SectionEntry {
+    uint32_t id;
+    uint32_t elementSize;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Locates a section and checks it lies inside the file and holds whole elements
+template <typename T>
+bool findSection(const char* data, size_t fileSize, uint32_t sectionCount, ScenarioFile::Section id,
+                 const T*& view, uint32_t& count) {
+    view = nullptr;
+    count = 0;
+    for (uint32_t i = 0; i < sectionCount; ++i) {
+        SectionEntry entry;
+        std::memcpy(&entry, data + HEADER_SIZE + i * SECTION_ENTRY_SIZE, sizeof(entry));
+        if (entry.id != static_cast<uint32_t>(id)) {
+            continue;
+        }
+        if (entry.elementSize != sizeof(T) || entry.offset % 8 != 0 || entry.offset > fileSize ||
+            entry.size > fileSize - entry.offset || entry.size % sizeof(T) != 0 ||
+            entry.size / sizeof(T) > UINT32_MAX) {
+            return false;
+        }
+        view = reinterpret_cast<const T*>(data + entry.offset);
+        count = static_cast<uint32_t>(entry.size / sizeof(T));
+        return true;
+    }
+    return true;  // Absent sections are empty
+}
+
+template <typename T>
+void appendSection(std::vector<char>& body, std::vector<SectionEntry>& table, ScenarioFile::Section id,
+                   const T* data, size_t count, size_t bodyOffset) {
+    while (body.size() % 8 != 0) {
+        body.push_back(0);
+    }
+    SectionEntry entry;
+    entry.id = static_cast<uint32_t>(id);
+    entry.elementSize = sizeof(T);
+    entry.offset = bodyOffset + body.size();
+    entry.size = count * sizeof(T);
+    table.push_back(entry);
+    
+    const char* bytes = reinterpret_cast<const char*>(data);
+    body.insert(body.end(), bytes, bytes + entry.size);
+}
+
+}  // namespace
+
+ScenarioFile::ScenarioFile() {
+    close();
+}
+
+bool ScenarioFile::open(const std::string& path) {
+    close();
+    if (!file.open(path)) {
+        return false;
+    }
+    
+    const char* data = file.data();
+    size_t size = file.size();
+    uint32_t version = 0;
+    uint32_t sectionCount = 0;
+    if (size >= HEADER_SIZE) {
+        std::memcpy(&version, data + 8, sizeof(version));
+        std::memcpy(&sectionCount, data + 12, sizeof(sectionCount));
+    }
+    if (size < HEADER_SIZE || std::memcmp(data, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+        std::cerr << "Error: " << path << " is not a scenario file.\n";
+        close();
+        return false;
+    }
+    if (version != FORMAT_VERSION) {
+        std::cerr << "Error: Unsupported scenario version " << version << ".\n";
+        close();
+        return false;
+    }
+    if (sectionCount > (size - HEADER_SIZE) / SECTION_ENTRY_SIZE) {
+        std::cerr << "Error: Scenario " << path << " is truncated.\n";
+        close();
+        return false;
+    }
+    
+    uint32_t indexCount = 0;
+    bool ok = findSection(data, size, sectionCount, Section::NODES, nodes, nodeCount) &&
+              findSection(data, size, sectionCount, Section::LINKS, links, linkCount) &&
+              findSection(data, size, sectionCount, Section::LINK_INDEX, linkIndex, indexCount) &&
+              findSection(data, size, sectionCount, Section::PLANS, plans, planCount) &&
+              findSection(data, size, sectionCount, Section::DEMAND_PROFILES, profiles, profileCount) &&
+              findSection(data, size, sectionCount, Section::DEMAND_RATES, demandRates, rateCount) &&
+              findSection(data, size, sectionCount, Section::STRINGS, strings, stringBytes) &&
+              findSection(data, size, sectionCount, Section::TRIPS, trips, tripCount);
+    if (!ok || indexCount != nodeCount + 1 || !validate(path)) {
+        if (!ok || indexCount != nodeCount + 1) {
+            std::cerr << "Error: Scenario " << path << " has a malformed section table.\n";
+        }
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool ScenarioFile::validate(const std::string& path) const {
+    // One pass over the records so lookups never need bounds checks afterwards
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        const ScenarioNode& node = nodes[i];
+        if (static_cast<uint64_t>(node.nameOffset) + node.nameLength > stringBytes ||
+            node.planIndex >= planCount ||
+            (node.demandProfile != NO_PROFILE && node.demandProfile >= profileCount) ||
+            (node.approachMask & ~0xFu) != 0) {
+            std::cerr << "Error: Scenario " << path << " node " << i << " is invalid.\n";
+            return false;
+        }
+    }
+    
+    if (linkIndex[0] != 0 || linkIndex[nodeCount] != linkCount) {
+        std::cerr << "Error: Scenario " << path << " link index is invalid.\n";
+        return false;
+    }
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        if (linkIndex[i] > linkIndex[i + 1]) {
+            std::cerr << "Error: Scenario " << path << " link index is invalid.\n";
+            return false;
+        }
+        for (uint32_t l = linkIndex[i]; l < linkIndex[i + 1]; ++l) {
+            if (links[l].from != i || links[l].to >= nodeCount || links[l].heading > 3) {
+                std::cerr << "Error: Scenario " << path << " link " << l << " is invalid.\n";
+                return false;
+            }
+        }
+    }
+    
+    for (uint32_t i = 0; i < profileCount; ++i) {
+        const ScenarioDemandProfile& profile = profiles[i];
+        if (profile.slotCount == 0 || profile.slotSeconds == 0 ||
+            static_cast<uint64_t>(profile.firstRate) + static_cast<uint64_t>(profile.slotCount) * 4 > rateCount) {
+            std::cerr << "Error: Scenario " << path << " demand profile " << i << " is invalid.\n";
+            return false;
+        }
+    }
+    
+    for (uint32_t i = 0; i < tripCount; ++i) {
+        if (trips[i].origin >= nodeCount || trips[i].destination >= nodeCount || !(trips[i].tripsPerHour >= 0.0f)) {
+            std::cerr << "Error: Scenario " << path << " trip " << i << " is invalid.\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+void ScenarioFile::close() {
+    file.close();
+    nodes = nullptr;
+    nodeCount = 0;
+    links = nullptr;
+    linkCount = 0;
+    linkIndex = nullptr;
+    plans = nullptr;
+    planCount = 0;
+    profiles = nullptr;
+    profileCount = 0;
+    demandRates = nullptr;
+    rateCount = 0;
+    strings = nullptr;
+    stringBytes = 0;
+    trips = nullptr;
+    tripCount = 0;
+}
+
+bool ScenarioFile::isOpen() const {
+    return file.isOpen();
+}
+
+uint32_t ScenarioFile::getNodeCount() const {
+    return nodeCount;
+}
+
+uint32_t ScenarioFile::getLinkCount() const {
+    return linkCount;
+}
+
+uint32_t ScenarioFile::getPlanCount() const {
+    return planCount;
+}
+
+const ScenarioNode& ScenarioFile::getNode(uint32_t index) const {
+    return nodes[index];
+}
+
+std::string_view ScenarioFile::getNodeName(uint32_t index) const {
+    return std::string_view(strings + nodes[index].nameOffset, nodes[index].nameLength);
+}
+
+const ScenarioPhasePlan& ScenarioFile::getPlan(uint32_t index) const {
+    return plans[index];
+}
+
+uint32_t ScenarioFile::getTripCount() const {
+    return tripCount;
+}
+
+const ScenarioTrip& ScenarioFile::getTrip(uint32_t index) const {
+    return trips[index];
+}
+
+const ScenarioLink* ScenarioFile::outgoingBegin(uint32_t node) const {
+    return links + linkIndex[node];
+}
+
+const ScenarioLink* ScenarioFile::outgoingEnd(uint32_t node) const {
+    return links + linkIndex[node + 1];
+}
+
+double ScenarioFile::getDemandPerHour(uint32_t node, Direction approach, int64_t secondOfDay) const {
+    if (node >= nodeCount || nodes[node].demandProfile == NO_PROFILE) {
+        return 0.0;
+    }
+    
+    const ScenarioDemandProfile& profile = profiles[nodes[node].demandProfile];
+    int64_t period = static_cast<int64_t>(profile.slotCount) * profile.slotSeconds;
+    int64_t offset = ((secondOfDay % period) + period) % period;
+    uint32_t slot = static_cast<uint32_t>(offset / profile.slotSeconds);
+    return demandRates[profile.firstRate + slot * 4 + static_cast<uint32_t>(approach)];
+}
+
+uint32_t ScenarioFile::getStorageVehicles(const ScenarioLink& link) {
+    const double JAM_SPACING_METERS = 7.5;
+    double vehicles = std::max<int>(1, link.lanes) * static_cast<double>(link.lengthMeters) / JAM_SPACING_METERS;
+    return std::max<uint32_t>(1, static_cast<uint32_t>(vehicles));
+}
+
+uint32_t ScenarioBuilder::addPlan(const ScenarioPhasePlan& plan) {
+    plans.push_back(plan);
+    return static_cast<uint32_t>(plans.size() - 1);
+}
+
+uint32_t ScenarioBuilder::addDemandProfile(uint32_t slotSeconds, const std::vector<float>& ratesPerHour) {
+    ScenarioDemandProfile profile;
+    profile.firstRate = static_cast<uint32_t>(demandRates.size());
+    profile.slotCount = static_cast<uint32_t>(ratesPerHour.size() / 4);
+    profile.slotSeconds = slotSeconds;
+    profile.reserved = 0;
+    demandRates.insert(demandRates.end(), ratesPerHour.begin(), ratesPerHour.begin() + profile.slotCount * 4);
+    profiles.push_back(profile);
+    return static_cast<uint32_t>(profiles.size() - 1);
+}
+
+uint32_t ScenarioBuilder::addNode(const std::string& name, float x, float y, uint8_t approachMask,
+                                  uint32_t plan, uint32_t demandProfile) {
+    ScenarioNode node = {};
+    node.nameOffset = static_cast<uint32_t>(strings.size());
+    node.nameLength = static_cast<uint32_t>(name.size());
+    node.x = x;
+    node.y = y;
+    node.planIndex = plan;
+    node.demandProfile = demandProfile;
+    node.approachMask = approachMask;
+    strings += name;
+    nodes.push_back(node);
+    return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+void ScenarioBuilder::addLink(uint32_t from, uint32_t to, Direction heading, float lengthMeters,
+                              float freeFlowSpeed, uint8_t lanes, float capacity) {
+    ScenarioLink link = {};
+    link.from = from;
+    link.to = to;
+    link.heading = static_cast<uint8_t>(heading);
+    link.lanes = lanes;
+    link.lengthMeters = lengthMeters;
+    link.freeFlowSpeed = freeFlowSpeed;
+    link.capacity = capacity;
+    links.push_back(link);
+}
+
+void ScenarioBuilder::addTrip(uint32_t origin, uint32_t destination, float tripsPerHour) {
+    ScenarioTrip trip = {};
+    trip.origin = origin;
+    trip.destination = destination;
+    trip.tripsPerHour = tripsPerHour;
+    trips.push_back(trip);
+}
+
+size_t ScenarioBuilder::getNodeCount() const {
+    return nodes.size();
+}
+
+bool ScenarioBuilder::write(const std::string& path) const {
+    // Group links by origin so each node's outgoing links are contiguous
+    std::vector<ScenarioLink> sortedLinks(links);
+    std::stable_sort(sortedLinks.begin(), sortedLinks.end(),
+        [](const ScenarioLink& a, const ScenarioLink& b) { return a.from < b.from; });
+    std::vector<uint32_t> linkIndex(nodes.size() + 1, 0);
+    for (const auto& link : sortedLinks) {
+        if (link.from >= nodes.size()) {
+            std::cerr << "Error: Scenario link refers to unknown node " << link.from << ".\n";
+            return false;
+        }
+        linkIndex[link.from + 1]++;
+    }
+    for (size_t i = 1; i < linkIndex.size(); ++i) {
+        linkIndex[i] += linkIndex[i - 1];
+    }
+    
+    const uint32_t sectionCount = 8;
+    size_t bodyOffset = HEADER_SIZE + sectionCount * SECTION_ENTRY_SIZE;
+    bodyOffset = (bodyOffset + 7) & ~static_cast<size_t>(7);
+    
+    std::vector<char> body;
+    std::vector<SectionEntry> table;
+    appendSection(body, table, ScenarioFile::Section::NODES, nodes.data(), nodes.size(), bodyOffset);
+    appendSection(body, table, ScenarioFile::Section::LINKS, sortedLinks.data(), sortedLinks.size(), bodyOffset);
+    appendSection(body, table, ScenarioFile::Section::LINK_INDEX, linkIndex.data(), linkIndex.size(), bodyOffset);
+    appendSection(body, table, ScenarioFile::Section::PLANS, plans.data(), plans.size(), bodyOffset);
+    appendSection(body, table, ScenarioFile::Section::DEMAND_PROFILES, profiles.data(), profiles.size(), bodyOffset);
+    appendSection(body, table, ScenarioFile::Section::DEMAND_RATES, demandRates.data(), demandRates.size(), bodyOffset);
+    appendSection(body, table, ScenarioFile::Section::STRINGS, strings.data(), strings.size(), bodyOffset);
+    appendSection(body, table, ScenarioFile::Section::TRIPS, trips.data(), trips.size(), bodyOffset);
+    
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open file " << path << " for writing.\n";
+        return false;
+    }
+    
+    uint32_t version = FORMAT_VERSION;
+    out.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+    out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    out.write(reinterpret_cast<const char*>(&sectionCount), sizeof(sectionCount));
+    for (const auto& entry : table) {
+        out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    }
+    std::vector<char> padding(bodyOffset - HEADER_SIZE - sectionCount * SECTION_ENTRY_SIZE, 0);
+    out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+    out.write(body.data(), static_cast<std::streamsize>(body.size()));
+    return static_cast<bool>(out);
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "../include/ShardedSimulation.h"
+#include "../include/TraceProfiler.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+void pinToCpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+}  // namespace
+
+// Sense-reversing barrier. Spins briefly, then yields, so oversubscribed runs still progress.
+class ShardedSimulation::SpinBarrier {
+private:
+    const int count;
+    alignas(64) std::atomic<int> waiting;
+    alignas(64) std::atomic<uint32_t> generation;
+
+public:
+    explicit SpinBarrier(int threads) : count(threads), waiting(0), generation(0) {}
+    
+    void wait() {
+        uint32_t current = generation.load(std::memory_order_acquire);
+        if (waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+            waiting.store(0, std::memory_order_relaxed);
+            generation.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        for (int spins = 0; generation.load(std::memory_order_acquire) == current; ++spins) {
+            if (spins >= 256) {
+                std::this_thread::yield();
+            }
+        }
+    }
+};
+
+struct ShardedSimulation::Shard {
+    std::unique_ptr<NetworkRegion> region;
+    std::array<std::vector<BoundaryExchange>, 2> outbox;  // [second parity][receiving worker]
+};
+
+ShardedSimulation::ShardedSimulation(const ScenarioFile& network, std::vector<std::unique_ptr<Intersection>>& nodes,
+                                     const NetworkRunConfig& runConfig, const RouteTable* routes)
+    : scenario(network), intersections(nodes), config(runConfig) {
+    uint32_t nodeCount = std::min<uint32_t>(scenario.getNodeCount(), static_cast<uint32_t>(intersections.size()));
+    workerCount = config.workers > 0 ? config.workers : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    workerCount = std::max(1, std::min<int>(workerCount, static_cast<int>(std::max<uint32_t>(nodeCount, 1))));
+    topology = std::make_unique<NetworkTopology>(scenario, nodeCount, workerCount, routes);
+    shards.resize(workerCount);
+}
+
+ShardedSimulation::~ShardedSimulation() = default;
+
+void ShardedSimulation::buildShard(int worker) {
+    // Copy this region's intersections from this thread, so under first-touch
+    // placement their queues and timers live on this worker's memory node
+    std::vector<Intersection*> byNode(topology->getNodeCount(), nullptr);
+    for (uint32_t node = 0; node < topology->getNodeCount(); ++node) {
+        if (topology->getRegion(node) == static_cast<uint32_t>(worker)) {
+            intersections[node] = std::make_unique<Intersection>(*intersections[node]);
+            byNode[node] = intersections[node].get();
+        }
+    }
+    
+    auto shard = std::make_unique<Shard>();
+    shard->region = std::make_unique<NetworkRegion>(*topology, static_cast<uint32_t>(worker), config, byNode);
+    for (auto& boxes : shard->outbox) {
+        boxes.resize(workerCount);
+    }
+    shards[worker] = std::move(shard);
+}
+
+void ShardedSimulation::drainExchange(Shard& shard, int parity) {
+    uint32_t index = shard.region->getRegion();
+    for (int source = 0; source < workerCount; ++source) {
+        if (static_cast<uint32_t>(source) == index) {
+            continue;
+        }
+        BoundaryExchange& mail = shards[source]->outbox[parity][index];
+        for (auto& transfer : mail.vehicles) {
+            shard.region->receive(std::move(transfer));
+        }
+        for (const LinkOccupancy& report : mail.occupancy) {
+            shard.region->receive(report);
+        }
+    }
+}
+
+void ShardedSimulation::runWorker(int worker, SpinBarrier& barrier, std::chrono::steady_clock::time_point origin) {
+    TRAFFIC_TRACE_THREAD("shard");
+    
+    unsigned cpus = std::thread::hardware_concurrency();
+    if (config.pinThreads && cpus > 0 && static_cast<unsigned>(workerCount) <= cpus) {
+        pinToCpu(worker);
+    }
+    
+    buildShard(worker);
+    barrier.wait();  // Every shard exists before anyone reads another's outbox
+    
+    Shard& mine = *shards[worker];
+    for (int64_t second = 1; second <= config.seconds; ++second) {
+        int parity = static_cast<int>(second & 1);
+        drainExchange(mine, parity ^ 1);
+        for (auto& box : mine.outbox[parity]) {
+            box.vehicles.clear();  // Drained by its receiver last second
+            box.occupancy.clear();
+        }
+        mine.region->step(second, origin + std::chrono::seconds(second), mine.outbox[parity]);
+        barrier.wait();
+    }
+    drainExchange(mine, static_cast<int>(config.seconds & 1));
+}
+
+NetworkRunResult ShardedSimulation::run() {
+    TRAFFIC_TRACE_SCOPE("ShardedSimulation::run");
+    
+    NetworkRunResult result;
+    result.workers = workerCount;
+    if (topology->getNodeCount() == 0 || config.seconds <= 0) {
+        return result;
+    }
+    result.cutLinks = topology->getCutLinkCount();
+    
+    SpinBarrier barrier(workerCount);
+    auto wallStart = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int w = 0; w < workerCount; ++w) {
+        workers.emplace_back(&ShardedSimulation::runWorker, this, w, std::ref(barrier), wallStart);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    result.simulatedSeconds = config.seconds;
+    
+    for (const auto& shard : shards) {
+        shard->region->addTo(result);
+    }
+    return result;
+}
\ No newline at end of file
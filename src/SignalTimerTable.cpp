@@ -0,0 +1,156 @@
+#include "../include/SignalTimerTable.h"
+#include "../include/TraceProfiler.h"
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TRAFFIC_AVX2_KERNEL 1
+#include <immintrin.h>
+#define TRAFFIC_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define TRAFFIC_AVX2_KERNEL 1
+#include <immintrin.h>
+#include <intrin.h>
+#define TRAFFIC_AVX2_TARGET
+#else
+#define TRAFFIC_AVX2_KERNEL 0
+#endif
+
+namespace {
+
+bool cpuHasAvx2() {
+#if TRAFFIC_AVX2_KERNEL && defined(__GNUC__)
+    return __builtin_cpu_supports("avx2");
+#elif TRAFFIC_AVX2_KERNEL
+    // Leaf 7 reports AVX2; the OS must also save the YMM registers (OSXSAVE + XCR0)
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5));
+#else
+    return false;
+#endif
+}
+
+// Reference kernel; also handles the tail the vector kernel leaves over
+void advanceScalar(int32_t* timers, const int32_t* events, const int64_t* rolls, int64_t now,
+                   int16_t* timeLeft, size_t begin, size_t end, std::vector<uint32_t>& due) {
+    for (size_t slot = begin; slot < end; ++slot) {
+        if (++timers[slot] >= events[slot] || now >= rolls[slot]) {
+            due.push_back(static_cast<uint32_t>(slot));
+        }
+    }
+    for (size_t i = begin * 4; i < end * 4; ++i) {
+        if (timeLeft[i] > 0) {
+            timeLeft[i]--;
+        }
+    }
+}
+
+#if TRAFFIC_AVX2_KERNEL
+// Eight phase timers and sixteen approach countdowns per step. Due slots come
+// out of a compare mask, so there is no per-slot branch on the common path.
+TRAFFIC_AVX2_TARGET
+size_t advanceAvx2(int32_t* timers, const int32_t* events, const int64_t* rolls, int64_t now,
+                   int16_t* timeLeft, size_t count, std::vector<uint32_t>& due) {
+    const __m256i one32 = _mm256_set1_epi32(1);
+    const __m256i one16 = _mm256_set1_epi16(1);
+    const __m256i nowTicks = _mm256_set1_epi64x(now);
+    
+    size_t slot = 0;
+    for (; slot + 8 <= count; slot += 8) {
+        __m256i timer = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(timers + slot)), one32);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(timers + slot), timer);
+        
+        // timer >= event  <=>  !(event > timer)
+        __m256i event = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(events + slot));
+        __m256i notDue = _mm256_cmpgt_epi32(event, timer);
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(notDue))) & 0xFFu;
+        
+        // now >= roll, four 64-bit slots at a time
+        for (size_t quarter = 0; quarter < 2; ++quarter) {
+            __m256i roll = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rolls + slot + quarter * 4));
+            __m256i rollPending = _mm256_cmpgt_epi64(roll, nowTicks);
+            unsigned rollDue = ~static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(rollPending))) & 0xFu;
+            mask |= rollDue << (quarter * 4);
+        }
+        if (mask) {
+            for (unsigned lane = 0; lane < 8; ++lane) {
+                if (mask & (1u << lane)) {
+                    due.push_back(static_cast<uint32_t>(slot + lane));
+                }
+            }
+        }
+        
+        // Countdowns are never negative, so an unsigned saturating subtract stops them at zero
+        for (size_t half = 0; half < 2; ++half) {
+            __m256i* left = reinterpret_cast<__m256i*>(timeLeft + slot * 4 + half * 16);
+            _mm256_storeu_si256(left, _mm256_subs_epu16(_mm256_loadu_si256(left), one16));
+        }
+    }
+    return slot;
+}
+#endif
+
+}  // namespace
+
+SignalTimerTable::SignalTimerTable()
+    : kernel(isSupported(Kernel::AVX2) ? Kernel::AVX2 : Kernel::SCALAR) {
+}
+
+void SignalTimerTable::resize(size_t slots) {
+    phaseTimers.resize(slots, 0);
+    nextEvents.resize(slots, NO_EVENT);
+    sensorRolls.resize(slots, INT64_MAX);
+    timeLeft.resize(slots * 4, 0);
+}
+
+size_t SignalTimerTable::size() const {
+    return phaseTimers.size();
+}
+
+const std::vector<uint32_t>& SignalTimerTable::advance(std::chrono::steady_clock::time_point now) {
+    TRAFFIC_TRACE_SCOPE("SignalTimerTable::advance");
+    
+    dueSlots.clear();
+    int64_t nowTicks = toTicks(now);
+    size_t count = phaseTimers.size();
+    size_t done = 0;
+#if TRAFFIC_AVX2_KERNEL
+    if (kernel == Kernel::AVX2) {
+        done = advanceAvx2(phaseTimers.data(), nextEvents.data(), sensorRolls.data(), nowTicks,
+                           timeLeft.data(), count, dueSlots);
+    }
+#endif
+    advanceScalar(phaseTimers.data(), nextEvents.data(), sensorRolls.data(), nowTicks,
+                  timeLeft.data(), done, count, dueSlots);
+    return dueSlots;
+}
+
+int64_t SignalTimerTable::toTicks(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+SignalTimerTable::Kernel SignalTimerTable::getKernel() const {
+    return kernel;
+}
+
+bool SignalTimerTable::setKernel(Kernel requested) {
+    if (!isSupported(requested)) {
+        return false;
+    }
+    kernel = requested;
+    return true;
+}
+
+bool SignalTimerTable::isSupported(Kernel kernel) {
+    if (kernel == Kernel::SCALAR) {
+        return true;
+    }
+    static const bool avx2 = cpuHasAvx2();
+    return avx2;
+}
+
+const char* SignalTimerTable::getKernelName(Kernel kernel) {
+    return kernel == Kernel::AVX2 ? "AVX2" : "scalar";
+}
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "../include/StateSnapshot.h"
+#include <iostream>
+
+namespace {
+
+std::string directionName(Direction dir) {
+    switch (dir) {
+        case Direction::NORTH: return "NORTH";
+        case Direction::SOUTH: return "SOUTH";
+        case Direction::EAST: return "EAST";
+        case Direction::WEST: return "WEST";
+        default: return "UNKNOWN";
+    }
+}
+
+std::string stateName(TrafficState state) {
+    switch (state) {
+        case TrafficState::RED: return "RED";
+        case TrafficState::YELLOW: return "YELLOW";
+        case TrafficState::GREEN: return "GREEN";
+        case TrafficState::FLASHING_RED: return "FLASHING_RED";
+        case TrafficState::FLASHING_YELLOW: return "FLASHING_YELLOW";
+        default: return "UNKNOWN";
+    }
+}
+
+}  // namespace
+
+int IntersectionSnapshot::getTotalVehicleCount() const {
+    int total = 0;
+    for (int length : queueLengths) {
+        total += length;
+    }
+    return total;
+}
+
+void IntersectionSnapshot::display() const {
+    std::cout << "\n=== Intersection " << id << " Status ===\n";
+    std::cout << "Emergency Mode: " << (emergencyMode ? "YES" : "NO") << "\n";
+    std::cout << "Current Phase: " << currentPhase << "\n";
+    
+    std::cout << "\nTraffic Lights:\n";
+    for (const auto& light : lights) {
+        std::cout << "  " << directionName(light.direction) << ": " 
+                  << stateName(light.state) << " (" << light.timeLeft << "s)\n";
+    }
+    
+    std::cout << "\nVehicle Queues:\n";
+    const std::string directions[] = {"NORTH", "SOUTH", "EAST", "WEST"};
+    for (int i = 0; i < 4; ++i) {
+        std::cout << "  " << directions[i] << ": " << queueLengths[i] << " vehicles\n";
+    }
+    
+    std::cout << "Average Wait Time: " << averageWaitTime << " seconds\n";
+}
+
+void SystemSnapshot::display() const {
+    std::cout << "\n=== SYSTEM STATUS ===\n";
+    std::cout << "Running: " << (running ? "YES" : "NO") << "\n";
+    std::cout << "Emergency Mode: " << (emergencyActive ? "ACTIVE" : "NORMAL") << "\n";
+    std::cout << "Intersections: " << intersections.size();
+    if (idleSkipping) {
+        std::cout << " (" << activeIntersections << " active)";
+    }
+    std::cout << "\n";
+    std::cout << "Queued Vehicles: " << queuedVehicles << " (" << meanLoad << " per intersection)\n";
+    std::cout << "Simulation Speed: " << simulationSpeed << "x\n";
+    std::cout << "Real-time Mode: " << (realTimeMode ? "YES" : "NO") << "\n";
+    std::cout << "Snapshot Epoch: " << epoch << "\n";
+    
+    if (schedulingMode == SchedulingMode::REAL_TIME) {
+        std::cout << "Scheduling: REAL-TIME (" << timing.periodMs << " ms period)\n";
+        std::cout << "  Ticks: " << timing.ticks << ", Missed Deadlines: " << timing.missedDeadlines
+                  << ", Shed Ticks: " << timing.shedTicks << "\n";
+        std::cout << "  Work: avg " << timing.getAverageWorkMs() << " ms, max " << timing.maxWorkMs << " ms\n";
+        std::cout << "  Jitter: avg " << timing.getAverageJitterMs() << " ms, max " << timing.maxJitterMs << " ms\n";
+    }
+    
+    if (controlStrategy == ControlStrategy::LOOKAHEAD) {
+        std::cout << "Control: LOOKAHEAD (" << lookaheadDecisions << " decisions, avg "
+                  << lookaheadAverageMs << " ms)\n";
+    }
+    
+    for (const auto& intersection : intersections) {
+        intersection.display();
+    }
+    
+    statistics.displaySummary();
+}
+
+void SystemSnapshot::displayCongestion(std::ostream& out, size_t count) const {
+    const char* titles[] = {"Longest Queues", "Longest Average Waits", "Fastest Growing Queues", "Longest Approach Queues"};
+    const char* units[] = {" vehicles", " s", " vehicles/min", " vehicles"};
+    
+    out << "\n=== WORST CONGESTION ===\n";
+    for (size_t metric = 0; metric < worst.size(); ++metric) {
+        out << titles[metric] << ":\n";
+        if (worst[metric].empty()) {
+            out << "  (none)\n";
+        }
+        for (size_t i = 0; i < worst[metric].size() && i < count; ++i) {
+            const CongestionRank& rank = worst[metric][i];
+            out << "  " << (i + 1) << ". " << rank.id;
+            if (rank.approach >= 0) {
+                out << " " << directionName(static_cast<Direction>(rank.approach));
+            }
+            out << ": ";
+            if (metric == static_cast<size_t>(CongestionMetric::QUEUE_LENGTH) ||
+                metric == static_cast<size_t>(CongestionMetric::APPROACH_QUEUE)) {
+                out << static_cast<int64_t>(rank.value);
+            } else {
+                out << rank.value;
+            }
+            out << units[metric] << "\n";
+        }
+    }
+}
+
+SnapshotBuffer::ReadGuard::ReadGuard(const SnapshotBuffer* buffer, int slot)
+    : owner(buffer), index(slot) {
+}
+
+SnapshotBuffer::ReadGuard::ReadGuard(ReadGuard&& other) noexcept
+    : owner(other.owner), index(other.index) {
+    other.owner = nullptr;
+}
+
+SnapshotBuffer::ReadGuard::~ReadGuard() {
+    if (owner) {
+        owner->readers[index].fetch_sub(1);
+    }
+}
+
+const SystemSnapshot& SnapshotBuffer::ReadGuard::operator*() const {
+    return owner->buffers[index];
+}
+
+const SystemSnapshot* SnapshotBuffer::ReadGuard::operator->() const {
+    return &owner->buffers[index];
+}
+
+SnapshotBuffer::SnapshotBuffer()
+    : front(0), epoch(0), skippedPublications(0) {
+    readers[0] = 0;
+    readers[1] = 0;
+}
+
+SystemSnapshot* SnapshotBuffer::beginWrite() {
+    int back = 1 - front.load();
+    
+    // A reader that pinned this buffer before the last flip is still using it
+    if (readers[back].load() != 0) {
+        skippedPublications++;
+        return nullptr;
+    }
+    return &buffers[back];
+}
+
+void SnapshotBuffer::publish() {
+    int back = 1 - front.load();
+    buffers[back].epoch = epoch.load() + 1;
+    front.store(back);
+    epoch++;
+}
+
+SnapshotBuffer::ReadGuard SnapshotBuffer::read() const {
+    while (true) {
+        int slot = front.load();
+        readers[slot].fetch_add(1);
+        
+        // If the writer flipped in between, the pinned buffer may be the one
+        // being refilled; back off and retry on the new front
+        if (front.load() == slot) {
+            return ReadGuard(this, slot);
+        }
+        readers[slot].fetch_sub(1);
+    }
+}
+
+SystemSnapshot SnapshotBuffer::copy() const {
+    ReadGuard guard = read();
+    return *guard;
+}
+
+uint64_t SnapshotBuffer::getEpoch() const {
+    return epoch.load();
+}
+
+uint64_t SnapshotBuffer::getSkippedPublications() const {
+    return skippedPublications.load();
+}
\ No newline at end of file
@@ -0,0 +1,209 @@
+#include "../include/TraceProfiler.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+
+TraceBuffer::TraceBuffer(uint32_t id)
+    : written(0), threadId(id), threadName("thread-" + std::to_string(id)) {
+}
+
+void TraceBuffer::append(const char* name, int64_t startNs, int64_t durationNs) {
+    uint64_t index = written.load(std::memory_order_relaxed);
+    events[index & (CAPACITY - 1)] = {name, startNs, durationNs};
+    written.store(index + 1, std::memory_order_release);
+}
+
+void TraceBuffer::setThreadName(const std::string& name) {
+    threadName = name;
+}
+
+void TraceBuffer::clear() {
+    written.store(0, std::memory_order_release);
+}
+
+void TraceBuffer::reassign(uint32_t id) {
+    threadId = id;
+    threadName = "thread-" + std::to_string(id);
+    clear();
+}
+
+uint32_t TraceBuffer::getThreadId() const {
+    return threadId;
+}
+
+const std::string& TraceBuffer::getThreadName() const {
+    return threadName;
+}
+
+std::vector<TraceEvent> TraceBuffer::collect() const {
+    uint64_t end = written.load(std::memory_order_acquire);
+    uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+    
+    std::vector<TraceEvent> result;
+    result.reserve(end - begin);
+    for (uint64_t i = begin; i < end; ++i) {
+        result.push_back(events[i & (CAPACITY - 1)]);
+    }
+    
+    // Drop anything the owner may have overwritten while we were copying
+    uint64_t after = written.load(std::memory_order_acquire);
+    if (after > CAPACITY && after - CAPACITY > begin) {
+        size_t stale = static_cast<size_t>(std::min<uint64_t>(after - CAPACITY - begin, result.size()));
+        result.erase(result.begin(), result.begin() + stale);
+    }
+    return result;
+}
+
+TraceProfiler::TraceProfiler() : enabled(false), nextThreadId(1) {
+}
+
+TraceProfiler& TraceProfiler::instance() {
+    static TraceProfiler profiler;
+    return profiler;
+}
+
+int64_t TraceProfiler::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TraceBuffer& TraceProfiler::localBuffer() {
+    // Buffers are owned by the profiler so events survive their thread; the
+    // holder only hands its buffer back when the thread exits
+    struct Holder {
+        TraceBuffer* buffer = nullptr;
+        ~Holder() {
+            if (buffer) {
+                TraceProfiler::instance().retireBuffer(buffer);
+            }
+        }
+    };
+    thread_local Holder holder;
+    if (holder.buffer == nullptr) {
+        holder.buffer = acquireBuffer();
+    }
+    return *holder.buffer;
+}
+
+TraceBuffer* TraceProfiler::acquireBuffer() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    
+    auto reusable = std::find_if(retired.begin(), retired.end(), [](const Retired& r) { return r.flushed; });
+    if (reusable == retired.end() && buffers.size() >= MAX_BUFFERS && !retired.empty()) {
+        reusable = retired.begin();   // At the cap: the oldest unwritten events are dropped
+    }
+    if (reusable != retired.end()) {
+        TraceBuffer* buffer = reusable->buffer;
+        retired.erase(reusable);
+        buffer->reassign(nextThreadId++);
+        return buffer;
+    }
+    
+    buffers.push_back(std::make_unique<TraceBuffer>(nextThreadId++));
+    return buffers.back().get();
+}
+
+void TraceProfiler::retireBuffer(TraceBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    retired.push_back({buffer, false});
+}
+
+void TraceProfiler::setEnabled(bool on) {
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+bool TraceProfiler::isEnabled() const {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void TraceProfiler::clear() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto& buffer : buffers) {
+        buffer->clear();
+    }
+    for (auto& r : retired) {
+        r.flushed = true;   // Nothing left in it to lose
+    }
+}
+
+void TraceProfiler::record(const char* name, int64_t startNs, int64_t durationNs) {
+    localBuffer().append(name, startNs, durationNs);
+}
+
+void TraceProfiler::setThreadName(const std::string& name) {
+    localBuffer().setThreadName(name);
+}
+
+bool TraceProfiler::writeChromeTrace(const std::string& filename) const {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << " for writing.\n";
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(registryMutex);
+    
+    // Timestamps are rebased to the earliest event so the viewer starts at zero
+    std::vector<std::vector<TraceEvent>> perThread;
+    int64_t origin = INT64_MAX;
+    for (const auto& buffer : buffers) {
+        perThread.push_back(buffer->collect());
+        for (const auto& event : perThread.back()) {
+            origin = std::min(origin, event.startNs);
+        }
+    }
+    
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << std::fixed << std::setprecision(3);
+    bool first = true;
+    size_t eventCount = 0;
+    
+    for (size_t t = 0; t < buffers.size(); ++t) {
+        uint32_t tid = buffers[t]->getThreadId();
+        
+        file << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+             << ",\"args\":{\"name\":\"" << buffers[t]->getThreadName() << "\"}}";
+        first = false;
+        
+        for (const auto& event : perThread[t]) {
+            file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"traffic\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                 << ",\"ts\":" << (event.startNs - origin) / 1000.0
+                 << ",\"dur\":" << event.durationNs / 1000.0 << "}";
+            eventCount++;
+        }
+    }
+    
+    file << "\n]}\n";
+    file.close();
+    
+    for (auto& r : retired) {
+        r.flushed = true;
+    }
+    
+    std::cout << "Trace with " << eventCount << " events saved to " << filename << "\n";
+    return true;
+}
+
+size_t TraceProfiler::getEventCount() const {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t count = 0;
+    for (const auto& buffer : buffers) {
+        count += buffer->collect().size();
+    }
+    return count;
+}
+
+ScopedTrace::ScopedTrace(const char* scopeName)
+    : name(scopeName), start(-1) {
+    if (TraceProfiler::instance().isEnabled()) {
+        start = TraceProfiler::nowNs();
+    }
+}
+
+ScopedTrace::~ScopedTrace() {
+    if (start >= 0) {
+        TraceProfiler::instance().record(name, start, TraceProfiler::nowNs() - start);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "../include/TrafficAssignment.h"
+#include "../include/ShardedSimulation.h"
+#include "../include/TrafficStats.h"
+#include "../include/TraceProfiler.h"
+#include <algorithm>
+#include <cmath>
+
+TrafficAssignment::TrafficAssignment(const ScenarioFile& network, std::vector<std::unique_ptr<Intersection>>& nodes,
+                                     RouteTable& tripRoutes, const AssignmentConfig& assignmentConfig)
+    : scenario(network), intersections(nodes), routes(tripRoutes), config(assignmentConfig) {
+    config.run.collectLinkTimes = true;
+}
+
+AssignmentResult TrafficAssignment::run() {
+    TRAFFIC_TRACE_SCOPE("TrafficAssignment::run");
+    
+    AssignmentResult result;
+    if (routes.getRouteCount() == 0) {
+        return result;
+    }
+    
+    auto wallStart = std::chrono::steady_clock::now();
+    std::vector<Intersection> initial;
+    initial.reserve(intersections.size());
+    for (const auto& intersection : intersections) {
+        initial.push_back(*intersection);
+    }
+    
+    std::vector<uint32_t> freeFlow(scenario.getLinkCount());
+    for (uint32_t link = 0; link < freeFlow.size(); ++link) {
+        freeFlow[link] = RouteTable::getFreeFlowSeconds(scenario.outgoingBegin(0)[link]);
+    }
+    std::vector<double> averaged(freeFlow.size(), 0.0);
+    std::vector<uint32_t> linkSeconds(freeFlow.size());
+    
+    for (int k = 0; k < config.iterations; ++k) {
+        if (k > 0) {
+            for (size_t i = 0; i < intersections.size(); ++i) {
+                intersections[i] = std::make_unique<Intersection>(initial[i]);
+            }
+        }
+        
+        AssignmentIteration iteration;
+        iteration.iteration = k + 1;
+        NetworkRunResult run = ShardedSimulation(scenario, intersections, config.run, &routes).run();
+        iteration.tripsStarted = run.tripsStarted;
+        iteration.tripsCompleted = run.tripsCompleted;
+        iteration.averageTimeInNetwork = run.getAverageTimeInNetwork();
+        iteration.simulateSeconds = run.wallSeconds;
+        
+        // Links nobody used still have a signal to wait at: charge them the mean delay seen elsewhere
+        TrafficStats stats;
+        stats.updateLinkTravelTimes(run.linkSeconds, run.linkTraversals);
+        double delay = 0.0;
+        uint64_t traversals = 0;
+        for (uint32_t link = 0; link < freeFlow.size(); ++link) {
+            if (stats.getLinkTraversals(link) > 0) {
+                delay += (stats.getLinkTravelTime(link, 0.0) - freeFlow[link]) * stats.getLinkTraversals(link);
+                traversals += stats.getLinkTraversals(link);
+            }
+        }
+        delay = traversals > 0 ? std::max(0.0, delay / traversals) : 0.0;
+        
+        // Averaged over iterations, so one noisy run doesn't swing every route
+        for (uint32_t link = 0; link < freeFlow.size(); ++link) {
+            double measured = stats.getLinkTravelTime(link, freeFlow[link] + delay);
+            averaged[link] = k == 0 ? measured : averaged[link] + (measured - averaged[link]) / (k + 1);
+            linkSeconds[link] = static_cast<uint32_t>(std::max(1.0, std::round(averaged[link])));
+        }
+        
+        double fraction = config.rerouteFraction > 0.0 ? config.rerouteFraction : 1.0 / (k + 2);
+        ReassignResult step = routes.reassign(scenario, linkSeconds, fraction, static_cast<uint32_t>(k));
+        iteration.relativeGap = step.relativeGap;
+        iteration.improvablePairs = step.improvablePairs;
+        iteration.reroutedPairs = step.reroutedPairs;
+        iteration.rerouteSeconds = step.milliseconds / 1000.0;
+        result.iterations.push_back(iteration);
+        
+        if (step.relativeGap < config.gapTarget) {
+            result.converged = true;
+            break;
+        }
+    }
+    
+    for (size_t i = 0; i < intersections.size(); ++i) {
+        intersections[i] = std::make_unique<Intersection>(initial[i]);
+    }
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    return result;
+}
\ No newline at end of file
@@ -1,37 +1,214 @@
 #include "../include/TrafficController.h"
+#include "../include/TraceProfiler.h"
 #include <iostream>
 #include <algorithm>
 #include <random>
 #include <thread>
 #include <chrono>
+#include <sstream>
+#include <fstream>
 
 TrafficController::TrafficController()
     : running(false), emergencyActive(false), simulationSpeed(1), 
-      realTimeMode(true), systemStartTime(std::chrono::steady_clock::now()) {
+      realTimeMode(true), schedulingMode(SchedulingMode::BEST_EFFORT),
+      controlStrategy(ControlStrategy::FIXED_TIME),
+      systemStartTime(std::chrono::steady_clock::now()), paused(false), threadsActive(false),
+      lastSignalStep(std::chrono::steady_clock::now()),
+      defaultSchedule(std::make_shared<const PlanSchedule>(PlanSchedule::rushHours(TimingPlan()))), idleSkipping(true),
+      rebalanceRequested(false),
+      rng(std::random_device{}()), vehicleCounter(0), checkpointRequested(false), checkpointWriting(false) {
 }
 
 TrafficController::~TrafficController() {
     stop();
+    waitForCheckpoint();
+    stopEventLog();
 }
 
-void TrafficController::addIntersection(const std::string& id) {
-    auto intersection = std::make_unique<Intersection>(id);
-    
-    // Add traffic lights for all directions
-    intersection->addTrafficLight(Direction::NORTH);
-    intersection->addTrafficLight(Direction::SOUTH);
-    intersection->addTrafficLight(Direction::EAST);
-    intersection->addTrafficLight(Direction::WEST);
+bool TrafficController::addIntersection(const std::string& id) {
+    if (running) {
+        std::cout << "Stop the system before adding intersections.\n";
+        return false;
+    }
     
-    // Add sensors for all directions
-    intersection->addTrafficSensor(Direction::NORTH);
-    intersection->addTrafficSensor(Direction::SOUTH);
-    intersection->addTrafficSensor(Direction::EAST);
-    intersection->addTrafficSensor(Direction::WEST);
+    auto intersection = createIntersection(id, 0xF);  // All four approaches
+    intersection->attachEventLog(&eventLog, static_cast<uint32_t>(intersections.size()));
+    signalTimers.resize(intersections.size() + 1);
+    intersection->attachSignalTimers(&signalTimers, static_cast<uint32_t>(intersections.size()));
+    activeIntersections.resize(intersections.size() + 1);
+    intersection->attachActiveSet(&activeIntersections, static_cast<uint32_t>(intersections.size()));
+    networkLoad.resize(intersections.size() + 1);
+    intersection->attachNetworkLoad(&networkLoad, static_cast<uint32_t>(intersections.size()));
+    intersection->setPlanSchedule(defaultSchedule);   // Its timing is the default plan's
     
     intersections.push_back(std::move(intersection));
     
     std::cout << "Added intersection: " << id << "\n";
+    return true;
+}
+
+std::unique_ptr<Intersection> TrafficController::createIntersection(const std::string& id, uint8_t approachMask) {
+    auto intersection = std::make_unique<Intersection>(id);
+    
+    // Add traffic lights for each approach
+    for (int i = 0; i < 4; ++i) {
+        if (approachMask & (1u << i)) {
+            intersection->addTrafficLight(static_cast<Direction>(i));
+        }
+    }
+    
+    // Add sensors for each approach
+    for (int i = 0; i < 4; ++i) {
+        if (approachMask & (1u << i)) {
+            intersection->addTrafficSensor(static_cast<Direction>(i));
+        }
+    }
+    
+    return intersection;
+}
+
+bool TrafficController::loadScenario(const std::string& filename) {
+    TRAFFIC_TRACE_SCOPE("loadScenario");
+    
+    if (running) {
+        std::cout << "Stop the system before loading a scenario.\n";
+        return false;
+    }
+    
+    auto start = std::chrono::steady_clock::now();
+    if (!scenario.open(filename)) {
+        return false;
+    }
+    
+    // Only the per-intersection runtime state is built; names, topology, plans and
+    // demand are read from the mapping
+    uint32_t nodeCount = scenario.getNodeCount();
+    std::vector<std::unique_ptr<Intersection>> loaded;
+    loaded.reserve(nodeCount);
+    std::vector<std::shared_ptr<const PlanSchedule>> schedules(scenario.getPlanCount());   // One per phase plan
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        const ScenarioNode& node = scenario.getNode(i);
+        std::string_view name = scenario.getNodeName(i);
+        auto intersection = createIntersection(name.empty() ? "N" + std::to_string(i) : std::string(name),
+                                               node.approachMask);
+        
+        const ScenarioPhasePlan& plan = scenario.getPlan(node.planIndex);
+        for (int d = 0; d < 4; ++d) {
+            intersection->configureTiming(static_cast<Direction>(d), plan.greenSeconds[d], plan.yellowSeconds[d]);
+        }
+        intersection->setPhaseLength(intersection->getPlannedPhaseLength(intersection->getCurrentPhase()));
+        
+        if (!schedules[node.planIndex]) {
+            TimingPlan base;
+            std::copy(plan.greenSeconds, plan.greenSeconds + 4, base.greenSeconds.begin());
+            std::copy(plan.yellowSeconds, plan.yellowSeconds + 4, base.yellowSeconds.begin());
+            schedules[node.planIndex] = std::make_shared<const PlanSchedule>(PlanSchedule::rushHours(base));
+        }
+        intersection->setPlanSchedule(schedules[node.planIndex]);
+        
+        loaded.push_back(std::move(intersection));
+    }
+    
+    // An approach fed by a link holds what the link does
+    for (const ScenarioLink* link = scenario.outgoingBegin(0); nodeCount > 0 && link != scenario.outgoingEnd(nodeCount - 1); ++link) {
+        if (link->to < nodeCount && link->heading <= 3) {
+            loaded[link->to]->setApproachCapacity(static_cast<Direction>(link->heading),
+                                                  static_cast<int>(ScenarioFile::getStorageVehicles(*link)));
+        }
+    }
+    
+    intersections = std::move(loaded);
+    attachEventLogToIntersections();
+    attachSignalTimersToIntersections();
+    attachActiveSetToIntersections();
+    attachNetworkLoadToIntersections();
+    
+    emergencyQueue = decltype(emergencyQueue)();
+    emergencyActive = false;
+    statistics.reset();
+    
+    routes.build(scenario);
+    
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Loaded scenario " << filename << ": " << nodeCount << " intersections, "
+              << scenario.getLinkCount() << " links in " << elapsedMs << " ms.\n";
+    if (scenario.getTripCount() > 0) {
+        std::cout << "Routed " << scenario.getTripCount() << " OD trips over " << routes.getRouteCount()
+                  << " routes (" << routes.getUnroutableCount() << " unroutable) in "
+                  << routes.getBuildMilliseconds() << " ms.\n";
+    }
+    return true;
+}
+
+const ScenarioFile& TrafficController::getScenario() const {
+    return scenario;
+}
+
+const RouteTable& TrafficController::getRoutes() const {
+    return routes;
+}
+
+bool TrafficController::setRingBarrierPlan(const std::string& id, const RingBarrierPlan& plan) {
+    if (running) {
+        std::cout << "Stop the system before changing phasing.\n";
+        return false;
+    }
+    
+    Intersection* intersection = getIntersection(id);
+    if (!intersection) {
+        std::cerr << "Error: Intersection " << id << " does not exist.\n";
+        return false;
+    }
+    
+    std::string error;
+    if (!intersection->setRingBarrierPlan(plan, error)) {
+        std::cerr << "Error: Phase plan rejected for " << id << ": " << error << "\n";
+        return false;
+    }
+    
+    std::cout << "Ring-and-barrier phasing active at " << id << ":\n";
+    plan.display();
+    return true;
+}
+
+bool TrafficController::clearRingBarrierPlan(const std::string& id) {
+    if (running) {
+        std::cout << "Stop the system before changing phasing.\n";
+        return false;
+    }
+    
+    Intersection* intersection = getIntersection(id);
+    if (!intersection) {
+        std::cerr << "Error: Intersection " << id << " does not exist.\n";
+        return false;
+    }
+    
+    intersection->clearRingBarrierPlan();
+    std::cout << "Intersection " << id << " is back on the two-phase cycle.\n";
+    return true;
+}
+
+bool TrafficController::setPlanSchedule(const std::string& id, std::shared_ptr<const PlanSchedule> schedule) {
+    if (running) {
+        std::cout << "Stop the system before changing plan schedules.\n";
+        return false;
+    }
+    Intersection* intersection = getIntersection(id);
+    if (!intersection) {
+        std::cerr << "Error: Intersection " << id << " does not exist.\n";
+        return false;
+    }
+    if (schedule && schedule->getTransitions().empty()) {
+        std::cerr << "Error: Plan schedule for " << id << " has no plans; compile it first.\n";
+        return false;
+    }
+    
+    intersection->setPlanSchedule(std::move(schedule));
+    return true;
+}
+
+const PlanScheduler& TrafficController::getPlanScheduler() const {
+    return planScheduler;
 }
 
 Intersection* TrafficController::getIntersection(const std::string& id) {
@@ -43,13 +220,105 @@ Intersection* TrafficController::getIntersection(const std::string& id) {
     return (it != intersections.end()) ? it->get() : nullptr;
 }
 
-void TrafficController::removeIntersection(const std::string& id) {
+bool TrafficController::removeIntersection(const std::string& id) {
+    if (running) {
+        std::cout << "Stop the system before removing intersections.\n";
+        return false;
+    }
+    
     intersections.erase(
         std::remove_if(intersections.begin(), intersections.end(),
             [&id](const std::unique_ptr<Intersection>& intersection) {
                 return intersection->getId() == id;
             }),
         intersections.end());
+    
+    // Log indices, timer slots, active-set indices and scenario node numbers follow list positions, which just shifted
+    attachEventLogToIntersections();
+    attachSignalTimersToIntersections();
+    attachActiveSetToIntersections();
+    attachNetworkLoadToIntersections();
+    planScheduler.rebuild(intersections, std::chrono::steady_clock::now());
+    scenario.close();
+    routes.clear();
+    return true;
+}
+
+int TrafficController::getIntersectionIndex(const std::string& id) const {
+    for (size_t i = 0; i < intersections.size(); ++i) {
+        if (intersections[i]->getId() == id) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+size_t TrafficController::ingestDetections(const DetectionEvent* events, size_t count) {
+    if (events == nullptr || count == 0) {
+        return 0;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        if (threadsActive) {
+            // The controller thread owns the sensors and queues; it sorts and applies the batch
+            size_t queued = 0;
+            for (size_t i = 0; i < count; ++i) {
+                if (events[i].intersection < intersections.size()) {
+                    pendingDetections.push_back(events[i]);
+                    queued++;
+                }
+            }
+            controlWakeup.notify_all();
+            return queued;
+        }
+    }
+    
+    return applyDetections(events, count);
+}
+
+size_t TrafficController::ingestDetections(const std::vector<DetectionEvent>& events) {
+    return ingestDetections(events.data(), events.size());
+}
+
+size_t TrafficController::applyDetections(const DetectionEvent* events, size_t count) {
+    size_t intersectionCount = intersections.size();
+    if (count == 0 || intersectionCount == 0) {
+        return 0;
+    }
+    
+    // Counting sort by intersection: one histogram pass, one scatter pass.
+    // The sort is stable, so each intersection still sees its events in arrival order.
+    ingestOffsets.assign(intersectionCount + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (events[i].intersection < intersectionCount) {
+            ingestOffsets[events[i].intersection + 1]++;
+        }
+    }
+    for (size_t i = 1; i <= intersectionCount; ++i) {
+        ingestOffsets[i] += ingestOffsets[i - 1];
+    }
+    
+    size_t valid = ingestOffsets[intersectionCount];
+    ingestBuffer.resize(valid);
+    ingestCursor.assign(ingestOffsets.begin(), ingestOffsets.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t target = events[i].intersection;
+        if (target < intersectionCount) {
+            ingestBuffer[ingestCursor[target]++] = events[i];
+        }
+    }
+    
+    // Apply each intersection's slice in a single pass
+    size_t applied = 0;
+    const DetectionEvent* base = ingestBuffer.data();
+    for (size_t i = 0; i < intersectionCount; ++i) {
+        if (ingestOffsets[i] != ingestOffsets[i + 1]) {
+            applied += intersections[i]->applyDetections(base + ingestOffsets[i], base + ingestOffsets[i + 1]);
+        }
+    }
+    
+    return applied;
 }
 
 void TrafficController::handleEmergencyVehicle(const Vehicle& emergency) {
@@ -72,6 +341,8 @@ void TrafficController::handleEmergencyVehicle(const Vehicle& emergency) {
 }
 
 void TrafficController::processEmergencyQueue() {
+    TRAFFIC_TRACE_SCOPE("processEmergencyQueue");
+    
     while (!emergencyQueue.empty() && emergencyActive) {
         Vehicle emergency = emergencyQueue.top();
         emergencyQueue.pop();
@@ -99,63 +370,37 @@ void TrafficController::clearEmergencyMode() {
 }
 
 void TrafficController::optimizeTrafficFlow() {
-    // Implement adaptive traffic control
-    for (auto& intersection : intersections) {
-        // Analyze queue lengths
-        std::vector<int> queueLengths(4);
-        queueLengths[0] = intersection->getQueueLength(Direction::NORTH);
-        queueLengths[1] = intersection->getQueueLength(Direction::SOUTH);
-        queueLengths[2] = intersection->getQueueLength(Direction::EAST);
-        queueLengths[3] = intersection->getQueueLength(Direction::WEST);
-        
-        // Find direction with longest queue
-        auto maxIt = std::max_element(queueLengths.begin(), queueLengths.end());
-        int maxIndex = std::distance(queueLengths.begin(), maxIt);
-        Direction priorityDirection = static_cast<Direction>(maxIndex);
-        
-        // Adjust timing if significant difference
-        if (*maxIt > 5) {  // If queue has more than 5 vehicles
-            intersection->configureTiming(priorityDirection, 35, 5);  // Extend green time
-        }
+    TRAFFIC_TRACE_SCOPE("optimizeTrafficFlow");
+    
+    // Extend the green of the longest approach wherever one holds more than
+    // LONG_QUEUE vehicles; the load index already lists exactly those
+    for (uint32_t index : networkLoad.getCongested()) {
+        intersections[index]->configureTiming(networkLoad.getLongestApproach(index), 35, 5);
     }
 }
 
 void TrafficController::adaptiveSignalTiming() {
-    // Implement time-of-day adjustments
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto tm = *std::localtime(&time_t);
-    
-    int hour = tm.tm_hour;
+    TRAFFIC_TRACE_SCOPE("adaptiveSignalTiming");
     
-    // Rush hour adjustments (7-9 AM, 5-7 PM)
-    if ((hour >= 7 && hour <= 9) || (hour >= 17 && hour <= 19)) {
-        for (auto& intersection : intersections) {
-            // Increase main road green time during rush hours
-            intersection->configureTiming(Direction::NORTH, 40, 5);
-            intersection->configureTiming(Direction::SOUTH, 40, 5);
-        }
-    }
+    // Time-of-day plans switch at their schedules' boundaries only
+    planScheduler.advance(intersections, std::chrono::steady_clock::now(), std::chrono::system_clock::now());
 }
 
 void TrafficController::balanceIntersectionLoad() {
-    // Simple load balancing between intersections
+    TRAFFIC_TRACE_SCOPE("balanceIntersectionLoad");
+    
+    // Simple load balancing between intersections, on the precomputed loads
     if (intersections.size() > 1) {
-        int totalVehicles = 0;
-        for (const auto& intersection : intersections) {
-            totalVehicles += intersection->getTotalVehicleCount();
-        }
-        
-        int avgLoad = totalVehicles / intersections.size();
+        int avgLoad = static_cast<int>(networkLoad.getTotalQueued() / static_cast<int64_t>(intersections.size()));
         
         // Adjust timing for heavily loaded intersections
-        for (auto& intersection : intersections) {
-            if (intersection->getTotalVehicleCount() > avgLoad + 3) {
+        for (uint32_t i = 0; i < intersections.size(); ++i) {
+            if (networkLoad.getLoad(i) > avgLoad + 3) {
                 // Reduce cycle time for overloaded intersections
-                intersection->configureTiming(Direction::NORTH, 25, 4);
-                intersection->configureTiming(Direction::SOUTH, 25, 4);
-                intersection->configureTiming(Direction::EAST, 20, 4);
-                intersection->configureTiming(Direction::WEST, 20, 4);
+                intersections[i]->configureTiming(Direction::NORTH, 25, 4);
+                intersections[i]->configureTiming(Direction::SOUTH, 25, 4);
+                intersections[i]->configureTiming(Direction::EAST, 20, 4);
+                intersections[i]->configureTiming(Direction::WEST, 20, 4);
             }
         }
     }
@@ -167,11 +412,21 @@ void TrafficController::start() {
         return;
     }
     
-    running = true;
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        running = true;
+        paused = false;
+        threadsActive = true;
+    }
     systemStartTime = std::chrono::steady_clock::now();
+    lastSignalStep = systemStartTime;
+    planScheduler.rebuild(intersections, systemStartTime);   // Plans in force are applied on the first second
     
     std::cout << "Starting traffic management system...\n";
     
+    // Readers switch to published snapshots from here on, so seed the first one
+    publishSnapshot();
+    
     // Start control threads
     controllerThread = std::thread(&TrafficController::controllerLoop, this);
     simulationThread = std::thread(&TrafficController::simulationLoop, this);
@@ -184,7 +439,11 @@ void TrafficController::stop() {
         return;
     }
     
-    running = false;
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        running = false;
+    }
+    controlWakeup.notify_all();
     
     // Wait for threads to finish
     if (controllerThread.joinable()) {
@@ -194,16 +453,49 @@ void TrafficController::stop() {
         simulationThread.join();
     }
     
+    // Arrivals and detections that never reached the controller thread are applied now
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        threadsActive = false;
+        arrivalBatch.swap(pendingArrivals);
+        detectionBatch.swap(pendingDetections);
+    }
+    for (const auto& arrival : arrivalBatch) {
+        applyArrival(arrival.intersection, arrival.vehicle);
+    }
+    arrivalBatch.clear();
+    applyDetections(detectionBatch.data(), detectionBatch.size());
+    detectionBatch.clear();
+    
+    // A checkpoint requested while the threads were winding down is taken now
+    serviceCheckpointRequest();
+    
     std::cout << "Traffic controller stopped.\n";
 }
 
 void TrafficController::pause() {
-    // Implementation for pause functionality
+    if (!running) {
+        std::cout << "Traffic controller is not running.\n";
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        paused = true;
+    }
+    controlWakeup.notify_all();
     std::cout << "System paused.\n";
 }
 
 void TrafficController::resume() {
-    // Implementation for resume functionality
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        if (!paused) {
+            return;
+        }
+        paused = false;
+    }
+    controlWakeup.notify_all();
     std::cout << "System resumed.\n";
 }
 
@@ -211,6 +503,11 @@ bool TrafficController::isRunning() const {
     return running;
 }
 
+bool TrafficController::isPaused() const {
+    std::lock_guard<std::mutex> lock(controlMutex);
+    return paused;
+}
+
 void TrafficController::setSimulationSpeed(int speed) {
     simulationSpeed = speed;
 }
@@ -219,85 +516,871 @@ void TrafficController::setRealTimeMode(bool realTime) {
     realTimeMode = realTime;
 }
 
-void TrafficController::configureIntersection(const std::string& id, Direction dir, int greenTime, int yellowTime) {
+void TrafficController::setSchedulingMode(SchedulingMode mode) {
+    if (running) {
+        std::cout << "Stop the system before changing the scheduling mode.\n";
+        return;
+    }
+    schedulingMode = mode;
+}
+
+void TrafficController::setLoadShedding(bool enabled) {
+    scheduler.setLoadShedding(enabled);
+}
+
+void TrafficController::setIdleSkipping(bool enabled) {
+    idleSkipping = enabled;
+}
+
+bool TrafficController::isIdleSkipping() const {
+    return idleSkipping;
+}
+
+SchedulingMode TrafficController::getSchedulingMode() const {
+    return schedulingMode;
+}
+
+void TrafficController::setControlStrategy(ControlStrategy strategy) {
+    // Takes effect at each intersection's next decision point
+    controlStrategy = strategy;
+    std::cout << "Signal control: " << (strategy == ControlStrategy::LOOKAHEAD ? "LOOKAHEAD" : "FIXED-TIME") << "\n";
+}
+
+ControlStrategy TrafficController::getControlStrategy() const {
+    return controlStrategy;
+}
+
+void TrafficController::setLookaheadConfig(const LookaheadConfig& config) {
+    if (running) {
+        std::cout << "Stop the system before changing the lookahead configuration.\n";
+        return;
+    }
+    lookahead.setConfig(config);
+}
+
+const LookaheadController& TrafficController::getLookahead() const {
+    return lookahead;
+}
+
+bool TrafficController::configureIntersection(const std::string& id, Direction dir, int greenTime, int yellowTime) {
+    if (running) {
+        std::cout << "Stop the system before changing signal timing.\n";
+        return false;
+    }
     Intersection* intersection = getIntersection(id);
-    if (intersection) {
-        intersection->configureTiming(dir, greenTime, yellowTime);
+    if (!intersection) {
+        std::cerr << "Error: Intersection " << id << " does not exist.\n";
+        return false;
     }
+    
+    intersection->setPlanSchedule(nullptr);
+    intersection->configureTiming(dir, greenTime, yellowTime);
+    return true;
 }
 
 void TrafficController::generateRandomTraffic() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dirDis(0, 3);
-    static std::uniform_int_distribution<> typeDis(0, 7);
-    static std::uniform_int_distribution<> emergencyDis(1, 100);
-    static int vehicleCounter = 0;
+    TRAFFIC_TRACE_SCOPE("generateRandomTraffic");
     
-    // Generate vehicle every few seconds
-    Direction dir = static_cast<Direction>(dirDis(gen));
-    VehicleType type = static_cast<VehicleType>(typeDis(gen));
+    std::uniform_int_distribution<> dirDis(0, 3);
+    std::uniform_int_distribution<> typeDis(0, 7);
+    std::uniform_int_distribution<> emergencyDis(1, 100);
+    std::uniform_int_distribution<> turnDis(1, 100);
     
-    // 5% chance for emergency vehicle
-    if (emergencyDis(gen) <= 5) {
-        type = VehicleType::AMBULANCE;
+    Direction dir;
+    Turn turn;
+    VehicleType type;
+    std::string id;
+    {
+        std::lock_guard<std::mutex> lock(rngMutex);
+        
+        // Generate vehicle every few seconds
+        dir = static_cast<Direction>(dirDis(rng));
+        type = static_cast<VehicleType>(typeDis(rng));
+        
+        // 20% left, 15% right, the rest straight through
+        int turnRoll = turnDis(rng);
+        turn = turnRoll <= 20 ? Turn::LEFT : (turnRoll <= 35 ? Turn::RIGHT : Turn::THROUGH);
+        
+        // 5% chance for emergency vehicle
+        if (emergencyDis(rng) <= 5) {
+            type = VehicleType::AMBULANCE;
+        }
+        
+        id = "V" + std::to_string(++vehicleCounter);
     }
-    
-    std::string id = "V" + std::to_string(++vehicleCounter);
-    Vehicle newVehicle(id, type, dir);
+    Vehicle newVehicle(id, type, dir, turn);
     
     // Add to first intersection (expand for multiple intersections)
     if (!intersections.empty()) {
-        intersections[0]->addVehicle(newVehicle);
-        statistics.updateVehicleCount();
-        
-        if (newVehicle.isEmergencyVehicle()) {
-            handleEmergencyVehicle(newVehicle);
+        postArrival(0, newVehicle);
+    }
+}
+
+bool TrafficController::submitVehicle(const std::string& intersectionId, const Vehicle& vehicle) {
+    int index = getIntersectionIndex(intersectionId);
+    if (index < 0) {
+        return false;
+    }
+    
+    postArrival(static_cast<size_t>(index), vehicle);
+    return true;
+}
+
+void TrafficController::postArrival(size_t intersectionIndex, const Vehicle& vehicle) {
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        if (threadsActive) {
+            // The controller thread owns the intersections; hand it over and wake it
+            pendingArrivals.push_back({intersectionIndex, vehicle});
+            controlWakeup.notify_all();
+            return;
         }
     }
+    
+    applyArrival(intersectionIndex, vehicle);
+}
+
+void TrafficController::applyArrival(size_t intersectionIndex, const Vehicle& vehicle) {
+    if (intersectionIndex >= intersections.size()) {
+        return;
+    }
+    
+    if (!intersections[intersectionIndex]->addVehicle(vehicle)) {
+        return;  // Its approach is full: the vehicle never enters
+    }
+    statistics.updateVehicleCount();
+    
+    if (vehicle.isEmergencyVehicle()) {
+        handleEmergencyVehicle(vehicle);
+    }
 }
 
 void TrafficController::simulateVehicleFlow() {
     generateRandomTraffic();
-    optimizeTrafficFlow();
-    adaptiveSignalTiming();
-    balanceIntersectionLoad();
+    
+    // The controller thread owns the queues and their aggregates; it rebalances at its next tick
+    rebalanceRequested.store(true, std::memory_order_release);
 }
 
 void TrafficController::updateAllIntersections() {
-    for (auto& intersection : intersections) {
-        intersection->updateSignals();
+    TRAFFIC_TRACE_SCOPE("updateAllIntersections");
+    
+    auto now = std::chrono::steady_clock::now();
+    bool stepped = now - lastSignalStep >= std::chrono::seconds(1);
+    if (stepped) {  // Update every second
+        advanceSignals(now);
+        adaptiveSignalTiming();
+        networkLoad.rollGrowthWindow(std::chrono::duration<double>(now.time_since_epoch()).count());
+        lastSignalStep = now;
     }
     
+    serviceIntersections(now, stepped);
+    
     statistics.updateCycleCount();
 }
 
+void TrafficController::advanceSignals(std::chrono::steady_clock::time_point now) {
+    TRAFFIC_TRACE_SCOPE("advanceSignals");
+    
+    // Only intersections with a signal change or a sensor roll due are touched
+    for (uint32_t slot : signalTimers.advance(now)) {
+        intersections[slot]->completeSecond(now);
+    }
+}
+
+size_t TrafficController::serviceIntersections(std::chrono::steady_clock::time_point now, bool controlStep) {
+    size_t departures = 0;
+    if (!idleSkipping.load(std::memory_order_relaxed)) {
+        for (auto& intersection : intersections) {
+            if (controlStep) {
+                applyControlStrategy(*intersection, now);
+            }
+            departures += intersection->processVehicleQueues();
+        }
+        return departures;
+    }
+    
+    // An intersection with empty queues has nothing to discharge and nothing
+    // for lookahead to plan, so only the active set is visited
+    for (uint32_t index : activeIntersections.getMembers()) {
+        Intersection& intersection = *intersections[index];
+        if (controlStep) {
+            applyControlStrategy(intersection, now);
+        }
+        departures += intersection.processVehicleQueues();
+    }
+    activeIntersections.retain([this](uint32_t index) {
+        return intersections[index]->hasQueuedVehicles();
+    });
+    return departures;
+}
+
+size_t TrafficController::getActiveIntersectionCount() const {
+    return activeIntersections.size();
+}
+
+const NetworkLoad& TrafficController::getNetworkLoad() const {
+    return networkLoad;
+}
+
+SignalTimerTable::Kernel TrafficController::getSignalKernel() const {
+    return signalTimers.getKernel();
+}
+
+bool TrafficController::setSignalKernel(SignalTimerTable::Kernel kernel) {
+    return signalTimers.setKernel(kernel);
+}
+
+ReplayResult TrafficController::runReplay(ReplaySource& source, double speedup) {
+    TRAFFIC_TRACE_SCOPE("runReplay");
+    
+    ReplayResult result;
+    if (running) {
+        std::cout << "Stop the system before replaying recorded traffic.\n";
+        return result;
+    }
+    
+    auto wallStart = std::chrono::steady_clock::now();
+    ReplayRecord record;
+    bool haveRecord = source.next(record);
+    
+    // Simulated time origin is the first record; second k of the trace maps to
+    // simulatedOrigin + k so sensor windows and wait times see trace time
+    int64_t originMs = haveRecord ? record.timestampMs : 0;
+    auto simulatedOrigin = wallStart;
+    int64_t second = 0;
+    
+    auto advanceTo = [&](int64_t targetSecond) {
+        while (second < targetSecond) {
+            second++;
+            result.departures += stepReplaySecond(simulatedOrigin + std::chrono::seconds(second));
+            
+            if (speedup > 0.0) {
+                std::this_thread::sleep_until(wallStart + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(second / speedup)));
+            }
+        }
+    };
+    
+    while (haveRecord) {
+        int64_t offsetMs = record.timestampMs - originMs;
+        if (offsetMs < second * 1000) {
+            result.outOfOrderRecords++;
+            offsetMs = second * 1000;
+        }
+        advanceTo(offsetMs / 1000);
+        
+        if (record.intersection >= intersections.size()) {
+            result.skippedRecords++;
+        } else {
+            // Short ids stay within the small-string buffer, so arrivals don't allocate
+            Vehicle vehicle("R" + std::to_string(result.arrivals), record.vehicleType, record.approach);
+            vehicle.setArrivalTime(simulatedOrigin + std::chrono::milliseconds(offsetMs));
+            applyArrival(record.intersection, vehicle);
+            result.arrivals++;
+        }
+        
+        haveRecord = source.next(record);
+    }
+    
+    // Let the last second's arrivals see one more signal step
+    advanceTo(second + 1);
+    
+    // A replay faster than real time ends with trace time ahead of the steady
+    // clock; what is still queued is moved back so waits read against now()
+    // are the trace-time waits rather than negative
+    auto ahead = simulatedOrigin + std::chrono::seconds(second) - std::chrono::steady_clock::now();
+    if (ahead > std::chrono::steady_clock::duration::zero()) {
+        for (auto& intersection : intersections) {
+            intersection->shiftArrivalTimes(-ahead);
+        }
+    }
+    
+    result.malformedRecords = source.getMalformedRecords();
+    result.simulatedSeconds = second;
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    return result;
+}
+
+NetworkRunResult TrafficController::runShardedSimulation(const NetworkRunConfig& config) {
+    TRAFFIC_TRACE_SCOPE("runShardedSimulation");
+    
+    if (running) {
+        std::cout << "Stop the system before running a sharded simulation.\n";
+        return NetworkRunResult();
+    }
+    if (!scenario.isOpen()) {
+        std::cerr << "Error: A sharded simulation runs on a loaded scenario's road network.\n";
+        return NetworkRunResult();
+    }
+    
+    // Workers write only to their own intersections, so nothing shared stays attached
+    for (auto& intersection : intersections) {
+        intersection->attachEventLog(nullptr, 0);
+        intersection->attachSignalTimers(nullptr, 0);
+        intersection->attachActiveSet(nullptr, 0);
+        intersection->attachNetworkLoad(nullptr, 0);
+    }
+    
+    // The regions set the run's approach storage on the intersections; the scenario's is put back after
+    std::vector<int> capacities;
+    capacities.reserve(intersections.size() * 4);
+    for (const auto& intersection : intersections) {
+        for (int d = 0; d < 4; ++d) {
+            capacities.push_back(intersection->getApproachCapacity(static_cast<Direction>(d)));
+        }
+    }
+    
+    ShardedSimulation simulation(scenario, intersections, config, routes.getRouteCount() > 0 ? &routes : nullptr);
+    NetworkRunResult result = simulation.run();
+    
+    for (size_t i = 0; i < intersections.size(); ++i) {
+        for (int d = 0; d < 4; ++d) {
+            intersections[i]->setApproachCapacity(static_cast<Direction>(d), capacities[i * 4 + d]);
+        }
+    }
+    attachEventLogToIntersections();
+    attachSignalTimersToIntersections();
+    attachActiveSetToIntersections();
+    attachNetworkLoadToIntersections();
+    return result;
+}
+
+NetworkRunResult TrafficController::runPartitionedSimulation(const NetworkRunConfig& config) {
+    TRAFFIC_TRACE_SCOPE("runPartitionedSimulation");
+    
+    if (running) {
+        std::cout << "Stop the system before running a partitioned simulation.\n";
+        return NetworkRunResult();
+    }
+    if (!scenario.isOpen()) {
+        std::cerr << "Error: A partitioned simulation runs on a loaded scenario's road network.\n";
+        return NetworkRunResult();
+    }
+    
+    // No background thread may be mid-write when the workers are forked, and
+    // the workers' copies must not append to this process's event log
+    waitForCheckpoint();
+    for (auto& intersection : intersections) {
+        intersection->attachEventLog(nullptr, 0);
+        intersection->attachSignalTimers(nullptr, 0);
+        intersection->attachActiveSet(nullptr, 0);
+        intersection->attachNetworkLoad(nullptr, 0);
+    }
+    
+    NetworkRunResult result = PartitionedSimulation(scenario, intersections, config,
+                                                    routes.getRouteCount() > 0 ? &routes : nullptr).run();
+    
+    attachEventLogToIntersections();
+    attachSignalTimersToIntersections();
+    attachActiveSetToIntersections();
+    attachNetworkLoadToIntersections();
+    return result;
+}
+
+AssignmentResult TrafficController::runAssignment(const AssignmentConfig& config) {
+    TRAFFIC_TRACE_SCOPE("runAssignment");
+    
+    if (running) {
+        std::cout << "Stop the system before running a traffic assignment.\n";
+        return AssignmentResult();
+    }
+    if (!scenario.isOpen() || routes.getRouteCount() == 0) {
+        std::cerr << "Error: Traffic assignment needs a loaded scenario with routable OD trips.\n";
+        return AssignmentResult();
+    }
+    
+    for (auto& intersection : intersections) {
+        intersection->attachEventLog(nullptr, 0);
+        intersection->attachSignalTimers(nullptr, 0);
+        intersection->attachActiveSet(nullptr, 0);
+        intersection->attachNetworkLoad(nullptr, 0);
+    }
+    
+    AssignmentResult result = TrafficAssignment(scenario, intersections, routes, config).run();
+    
+    attachEventLogToIntersections();
+    attachSignalTimersToIntersections();
+    attachActiveSetToIntersections();
+    attachNetworkLoadToIntersections();
+    return result;
+}
+
+LaneRunResult TrafficController::runLaneSimulation(const LaneRunConfig& config) {
+    TRAFFIC_TRACE_SCOPE("runLaneSimulation");
+    
+    if (running) {
+        std::cout << "Stop the system before running a lane simulation.\n";
+        return LaneRunResult();
+    }
+    
+    // Approach geometry from the scenario where a link feeds the approach
+    std::vector<const ScenarioLink*> feeding(intersections.size() * 4, nullptr);
+    uint32_t nodeCount = scenario.isOpen() ? std::min<uint32_t>(scenario.getNodeCount(), static_cast<uint32_t>(intersections.size())) : 0;
+    for (const ScenarioLink* link = scenario.isOpen() ? scenario.outgoingBegin(0) : nullptr;
+         nodeCount > 0 && link != scenario.outgoingEnd(nodeCount - 1); ++link) {
+        if (link->to < nodeCount && link->heading <= 3) {
+            feeding[link->to * 4 + link->heading] = link;
+        }
+    }
+    
+    std::vector<const Intersection*> signals;
+    signals.reserve(intersections.size());
+    for (const auto& intersection : intersections) {
+        signals.push_back(intersection.get());
+    }
+    LaneSimulation simulation(signals, config);
+    for (size_t i = 0; i < intersections.size(); ++i) {
+        SignalState state = intersections[i]->getSignalState();
+        for (int d = 0; d < 4; ++d) {
+            if (!state.has(static_cast<Direction>(d))) {
+                continue;
+            }
+            const ScenarioLink* link = feeding[i * 4 + d];
+            LaneSpec spec;
+            spec.lengthMeters = link ? link->lengthMeters : config.approachMeters;
+            spec.signal = static_cast<int32_t>(i);
+            spec.approach = static_cast<Direction>(d);
+            spec.demandPerHour = config.demandPerLaneHour;
+            int laneCount = link ? std::max<int>(1, link->lanes) : std::max(1, config.lanesPerApproach);
+            for (int lane = 0; lane < laneCount; ++lane) {
+                simulation.addLane(spec);
+            }
+        }
+    }
+    return simulation.run();
+}
+
+CorridorResult TrafficController::coordinateCorridor(const CorridorConfig& config) {
+    TRAFFIC_TRACE_SCOPE("coordinateCorridor");
+    
+    if (running) {
+        std::cout << "Stop the system before coordinating a corridor.\n";
+        return CorridorResult();
+    }
+    
+    std::vector<size_t> members;
+    if (config.intersections.empty()) {
+        for (size_t i = 0; i < intersections.size(); ++i) {
+            members.push_back(i);
+        }
+    }
+    for (const std::string& id : config.intersections) {
+        auto it = std::find_if(intersections.begin(), intersections.end(),
+            [&id](const std::unique_ptr<Intersection>& intersection) {
+                return intersection->getId() == id;
+            });
+        if (it == intersections.end()) {
+            std::cerr << "Error: Intersection " << id << " does not exist.\n";
+            return CorridorResult();
+        }
+        members.push_back(static_cast<size_t>(it - intersections.begin()));
+    }
+    if (members.size() < 2) {
+        std::cerr << "Error: A corridor needs at least two intersections.\n";
+        return CorridorResult();
+    }
+    
+    // Scenario links between consecutive members where they exist, the configured spacing otherwise
+    uint32_t nodeCount = scenario.isOpen() ? std::min<uint32_t>(scenario.getNodeCount(), static_cast<uint32_t>(intersections.size())) : 0;
+    auto joining = [&](size_t from, size_t to, Direction heading) {
+        if (from < nodeCount && to < nodeCount) {
+            for (const ScenarioLink* link = scenario.outgoingBegin(static_cast<uint32_t>(from));
+                 link != scenario.outgoingEnd(static_cast<uint32_t>(from)); ++link) {
+                if (link->to == to && link->heading <= 3) {
+                    return CorridorLink{link->lengthMeters, link->freeFlowSpeed, static_cast<Direction>(link->heading)};
+                }
+            }
+        }
+        return CorridorLink{config.spacingMeters, config.speed, heading};
+    };
+    std::vector<Intersection*> corridor;
+    std::vector<CorridorLink> outbound;
+    std::vector<CorridorLink> inbound;
+    for (size_t k = 0; k < members.size(); ++k) {
+        corridor.push_back(intersections[members[k]].get());
+        if (k + 1 < members.size()) {
+            outbound.push_back(joining(members[k], members[k + 1], config.heading));
+            inbound.push_back(joining(members[k + 1], members[k], opposingApproach(outbound.back().heading)));
+        }
+    }
+    
+    CorridorResult result = CorridorCoordinator(corridor, outbound, inbound, config).run();
+    if (result.applied) {
+        for (Intersection* intersection : corridor) {
+            intersection->setPlanSchedule(nullptr);   // A plan change would undo the offsets
+        }
+    }
+    return result;
+}
+
+size_t TrafficController::stepReplaySecond(std::chrono::steady_clock::time_point simulatedNow) {
+    size_t departures = 0;
+    advanceSignals(simulatedNow);
+    departures += serviceIntersections(simulatedNow, true);
+    processEmergencyQueue();
+    return departures;
+}
+
+void TrafficController::applyControlStrategy(Intersection& intersection, std::chrono::steady_clock::time_point now) {
+    // Lookahead plans the two-phase cycle; ring-and-barrier intersections are actuated instead
+    if (controlStrategy.load(std::memory_order_relaxed) != ControlStrategy::LOOKAHEAD || intersection.isEmergencyMode() ||
+        intersection.hasRingBarrierPlan()) {
+        return;
+    }
+    if (!lookahead.isDecisionPoint(intersection.getPhaseTimer(), intersection.getPhaseLength(),
+                                   intersection.getPlannedYellow(intersection.getCurrentPhase()))) {
+        return;
+    }
+    
+    LookaheadDecision decision = lookahead.decide(intersection.fork(now));
+    intersection.setPhaseLength(intersection.getPhaseTimer() + 1 + decision.extraGreenSeconds +
+                                intersection.getPlannedYellow(intersection.getCurrentPhase()));
+}
+
+bool TrafficController::startEventLog(const std::string& filename) {
+    if (!eventLog.open(filename)) {
+        return false;
+    }
+    
+    std::cout << "Event log started: " << filename << "\n";
+    return true;
+}
+
+void TrafficController::stopEventLog() {
+    if (!eventLog.isOpen()) {
+        return;
+    }
+    
+    // close() waits out any append already in flight and flushes every thread's chunk
+    eventLog.close();
+    std::cout << "Event log closed: " << eventLog.getEventsWritten() << " events in "
+              << eventLog.getSegmentsWritten() << " segments.\n";
+}
+
+bool TrafficController::isEventLogging() const {
+    return eventLog.isOpen();
+}
+
+bool TrafficController::saveCheckpoint(const std::string& filename) {
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        if (threadsActive) {
+            // The controller thread owns the state while running; it captures at its next tick
+            if (checkpointRequested) {
+                std::cout << "A checkpoint is already pending.\n";
+                return false;
+            }
+            pendingCheckpoint = filename;
+            checkpointRequested = true;
+            return true;
+        }
+    }
+    
+    CheckpointWriter out(std::chrono::steady_clock::now());
+    writeCheckpoint(out);
+    launchCheckpointWrite(filename, std::move(out.data()));
+    return true;
+}
+
+bool TrafficController::restoreCheckpoint(const std::string& filename) {
+    if (running) {
+        std::cout << "Stop the system before restoring a checkpoint.\n";
+        return false;
+    }
+    
+    // Never read a file that our own writer may still be replacing
+    waitForCheckpoint();
+    
+    auto start = std::chrono::steady_clock::now();
+    CheckpointReader in;
+    if (!in.open(filename, start)) {
+        return false;
+    }
+    
+    // Decode into fresh objects so a bad checkpoint leaves the current state untouched
+    std::vector<std::unique_ptr<Intersection>> restoredIntersections;
+    uint32_t intersectionCount = in.getCount(1);
+    for (uint32_t i = 0; i < intersectionCount && in.ok(); ++i) {
+        auto intersection = std::make_unique<Intersection>("");
+        intersection->readCheckpoint(in);
+        restoredIntersections.push_back(std::move(intersection));
+    }
+    
+    bool restoredEmergencyActive = in.get<uint8_t>() != 0;
+    std::vector<Vehicle> restoredEmergencies;
+    uint32_t emergencyCount = in.getCount(1);
+    for (uint32_t i = 0; i < emergencyCount && in.ok(); ++i) {
+        restoredEmergencies.emplace_back("", VehicleType::CAR, Direction::NORTH);
+        restoredEmergencies.back().readCheckpoint(in);
+    }
+    
+    TrafficStats restoredStats;
+    restoredStats.readCheckpoint(in);
+    
+    int restoredSpeed = in.get<int32_t>();
+    bool restoredRealTime = in.get<uint8_t>() != 0;
+    uint8_t restoredScheduling = in.get<uint8_t>();
+    uint8_t restoredStrategy = in.get<uint8_t>();
+    int restoredCounter = in.get<int32_t>();
+    std::mt19937 restoredRng;
+    std::istringstream rngState(in.getString());
+    rngState >> restoredRng;
+    
+    if (!in.ok() || !in.atEnd() || rngState.fail() ||
+        restoredScheduling > static_cast<uint8_t>(SchedulingMode::REAL_TIME) ||
+        restoredStrategy > static_cast<uint8_t>(ControlStrategy::LOOKAHEAD)) {
+        std::cerr << "Error: Checkpoint " << filename << " could not be decoded.\n";
+        return false;
+    }
+    
+    // Plan schedules aren't checkpointed; intersections keep the one of the same name
+    for (auto& restored : restoredIntersections) {
+        Intersection* current = getIntersection(restored->getId());
+        restored->setPlanSchedule(current ? current->getPlanSchedule() : defaultSchedule);
+    }
+    
+    intersections = std::move(restoredIntersections);
+    attachEventLogToIntersections();
+    attachSignalTimersToIntersections();
+    attachActiveSetToIntersections();
+    attachNetworkLoadToIntersections();
+    if (scenario.getNodeCount() != intersections.size()) {
+        scenario.close();  // The restored network isn't the loaded scenario
+        routes.clear();
+    }
+    
+    emergencyQueue = decltype(emergencyQueue)();
+    for (const auto& emergency : restoredEmergencies) {
+        emergencyQueue.push(emergency);
+    }
+    emergencyActive = restoredEmergencyActive;
+    statistics = restoredStats;
+    simulationSpeed = restoredSpeed;
+    realTimeMode = restoredRealTime;
+    schedulingMode = static_cast<SchedulingMode>(restoredScheduling);
+    controlStrategy = static_cast<ControlStrategy>(restoredStrategy);
+    {
+        std::lock_guard<std::mutex> lock(rngMutex);
+        rng = restoredRng;
+        vehicleCounter = restoredCounter;
+    }
+    
+    double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Checkpoint restored: " << intersections.size() << " intersections in "
+              << elapsedMs << " ms.\n";
+    return true;
+}
+
+void TrafficController::waitForCheckpoint() {
+    std::lock_guard<std::mutex> lock(checkpointMutex);
+    if (checkpointWriter.joinable()) {
+        checkpointWriter.join();
+    }
+}
+
+bool TrafficController::isCheckpointWriting() const {
+    return checkpointWriting;
+}
+
+void TrafficController::writeCheckpoint(CheckpointWriter& out) {
+    TRAFFIC_TRACE_SCOPE("writeCheckpoint");
+    
+    out.put(static_cast<uint32_t>(intersections.size()));
+    for (const auto& intersection : intersections) {
+        intersection->writeCheckpoint(out);
+    }
+    
+    out.put(static_cast<uint8_t>(emergencyActive.load()));
+    auto pendingEmergencies = emergencyQueue;
+    out.put(static_cast<uint32_t>(pendingEmergencies.size()));
+    while (!pendingEmergencies.empty()) {
+        pendingEmergencies.top().writeCheckpoint(out);
+        pendingEmergencies.pop();
+    }
+    
+    statistics.writeCheckpoint(out);
+    
+    out.put(static_cast<int32_t>(simulationSpeed));
+    out.put(static_cast<uint8_t>(realTimeMode));
+    out.put(static_cast<uint8_t>(schedulingMode));
+    out.put(static_cast<uint8_t>(controlStrategy.load()));
+    
+    // mt19937 only exposes its state through stream operators
+    std::ostringstream rngState;
+    {
+        std::lock_guard<std::mutex> lock(rngMutex);
+        out.put(static_cast<int32_t>(vehicleCounter));
+        rngState << rng;
+    }
+    out.putString(rngState.str());
+}
+
+void TrafficController::serviceCheckpointRequest() {
+    std::string filename;
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        if (!checkpointRequested) {
+            return;
+        }
+        filename.swap(pendingCheckpoint);
+        checkpointRequested = false;
+    }
+    
+    CheckpointWriter out(std::chrono::steady_clock::now());
+    writeCheckpoint(out);
+    launchCheckpointWrite(filename, std::move(out.data()));
+}
+
+void TrafficController::launchCheckpointWrite(const std::string& filename, std::vector<char>&& payload) {
+    std::lock_guard<std::mutex> lock(checkpointMutex);
+    
+    // One write in flight at a time; a new checkpoint waits for the previous file
+    if (checkpointWriter.joinable()) {
+        checkpointWriter.join();
+    }
+    
+    checkpointWriting = true;
+    checkpointWriter = std::thread([this, filename, data = std::move(payload)]() {
+        auto start = std::chrono::steady_clock::now();
+        if (CheckpointWriter::writeFile(filename, data)) {
+            double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "Checkpoint saved: " << filename << " (" << data.size() << " bytes, "
+                      << elapsedMs << " ms)\n";
+        }
+        checkpointWriting = false;
+    });
+}
+
+void TrafficController::attachEventLogToIntersections() {
+    for (size_t i = 0; i < intersections.size(); ++i) {
+        intersections[i]->attachEventLog(&eventLog, static_cast<uint32_t>(i));
+    }
+}
+
+void TrafficController::attachSignalTimersToIntersections() {
+    // Park every intersection's timers locally first: slots are about to be reused
+    for (auto& intersection : intersections) {
+        intersection->attachSignalTimers(nullptr, 0);
+    }
+    signalTimers.resize(intersections.size());
+    for (size_t i = 0; i < intersections.size(); ++i) {
+        intersections[i]->attachSignalTimers(&signalTimers, static_cast<uint32_t>(i));
+    }
+}
+
+void TrafficController::attachActiveSetToIntersections() {
+    activeIntersections.clear();
+    activeIntersections.resize(intersections.size());
+    for (size_t i = 0; i < intersections.size(); ++i) {
+        intersections[i]->attachActiveSet(&activeIntersections, static_cast<uint32_t>(i));
+    }
+}
+
+void TrafficController::attachNetworkLoadToIntersections() {
+    networkLoad.clear();
+    networkLoad.resize(intersections.size());
+    for (size_t i = 0; i < intersections.size(); ++i) {
+        intersections[i]->attachNetworkLoad(&networkLoad, static_cast<uint32_t>(i));
+    }
+}
+
 TrafficStats& TrafficController::getStatistics() {
     return statistics;
 }
 
 void TrafficController::generateSystemReport() const {
-    statistics.generateReport();
+    SystemSnapshot snapshot = getSnapshot();
+    snapshot.statistics.generateReport();
+    snapshot.displayCongestion(std::cout, 5);
 }
 
 void TrafficController::saveReportToFile(const std::string& filename) const {
-    statistics.saveToFile(filename);
+    SystemSnapshot snapshot = getSnapshot();
+    snapshot.statistics.saveToFile(filename);
+    
+    std::ofstream file(filename, std::ios::app);
+    if (file.is_open()) {
+        snapshot.displayCongestion(file, SystemSnapshot::RANKED);
+    }
 }
 
 void TrafficController::displaySystemStatus() const {
-    std::cout << "\n=== SYSTEM STATUS ===\n";
-    std::cout << "Running: " << (running ? "YES" : "NO") << "\n";
-    std::cout << "Emergency Mode: " << (emergencyActive ? "ACTIVE" : "NORMAL") << "\n";
-    std::cout << "Intersections: " << intersections.size() << "\n";
-    std::cout << "Simulation Speed: " << simulationSpeed << "x\n";
-    std::cout << "Real-time Mode: " << (realTimeMode ? "YES" : "NO") << "\n";
-    
-    // Display each intersection status
-    for (const auto& intersection : intersections) {
-        intersection->displayStatus();
+    getSnapshot().display();
+}
+
+void TrafficController::displayWorstCongestion(size_t count) const {
+    getSnapshot().displayCongestion(std::cout, count);
+}
+
+SystemSnapshot TrafficController::getSnapshot() const {
+    // While the threads run, only the published buffers are safe to read.
+    // When stopped nothing else touches the live state, so read it directly.
+    if (running) {
+        return snapshots.copy();
+    }
+    
+    SystemSnapshot snapshot;
+    captureSnapshot(snapshot);
+    snapshot.epoch = snapshots.getEpoch();
+    return snapshot;
+}
+
+uint64_t TrafficController::getSnapshotEpoch() const {
+    return snapshots.getEpoch();
+}
+
+void TrafficController::captureSnapshot(SystemSnapshot& out) const {
+    out.running = running;
+    out.emergencyActive = emergencyActive;
+    out.simulationSpeed = simulationSpeed;
+    out.realTimeMode = realTimeMode;
+    out.schedulingMode = schedulingMode;
+    out.timing = scheduler.getStats();
+    out.controlStrategy = controlStrategy;
+    out.lookaheadDecisions = lookahead.getDecisions();
+    out.lookaheadAverageMs = lookahead.getAverageDecisionMs();
+    out.idleSkipping = idleSkipping;
+    out.activeIntersections = activeIntersections.size();
+    out.queuedVehicles = networkLoad.getTotalQueued();
+    out.meanLoad = networkLoad.getMeanLoad();
+    
+    // Straight from the congestion index, a few heap entries per ranking
+    double nowSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    std::vector<CongestionEntry> entries;
+    for (size_t metric = 0; metric < out.worst.size(); ++metric) {
+        networkLoad.getCongestionIndex().top(static_cast<CongestionMetric>(metric), SystemSnapshot::RANKED, nowSeconds, entries);
+        out.worst[metric].clear();
+        for (const CongestionEntry& entry : entries) {
+            if (entry.index >= intersections.size()) {
+                continue;   // Not attached to a live intersection
+            }
+            CongestionRank rank;
+            rank.id = intersections[entry.index]->getId();
+            rank.approach = entry.approach;
+            rank.value = entry.value;
+            out.worst[metric].push_back(rank);
+        }
+    }
+    
+    out.intersections.resize(intersections.size());
+    for (size_t i = 0; i < intersections.size(); ++i) {
+        intersections[i]->captureSnapshot(out.intersections[i]);
+    }
+    
+    out.statistics = statistics;
+}
+
+void TrafficController::publishSnapshot() {
+    TRAFFIC_TRACE_SCOPE("publishSnapshot");
+    
+    SystemSnapshot* next = snapshots.beginWrite();
+    if (next == nullptr) {
+        return;  // A slow reader still holds the back buffer; try again next tick
     }
     
-    statistics.displaySummary();
+    captureSnapshot(*next);
+    snapshots.publish();
 }
 
 void TrafficController::reset() {
@@ -305,6 +1388,12 @@ void TrafficController::reset() {
     
     // Clear all intersections
     intersections.clear();
+    signalTimers.resize(0);
+    activeIntersections.resize(0);
+    networkLoad.clear();
+    networkLoad.resize(0);
+    scenario.close();
+    routes.clear();
     
     // Clear emergency queue
     while (!emergencyQueue.empty()) {
@@ -331,27 +1420,131 @@ std::vector<std::string> TrafficController::getIntersectionIds() const {
     return ids;
 }
 
+std::chrono::steady_clock::duration TrafficController::getTickPeriod() const {
+    int sleepTime = realTimeMode ? 1000 / std::max(1, simulationSpeed) : 100;
+    return std::chrono::milliseconds(sleepTime);
+}
+
+TrafficController::WakeReason TrafficController::waitUntil(std::chrono::steady_clock::time_point deadline,
+                                                           bool drainArrivals) {
+    std::unique_lock<std::mutex> lock(controlMutex);
+    
+    while (true) {
+        if (!running) {
+            return WakeReason::STOPPING;
+        }
+        
+        if (paused) {
+            // Park with no timeout: zero CPU until resume() or stop()
+            controlWakeup.wait(lock, [this] { return !running || !paused; });
+            return running ? WakeReason::RESUMED : WakeReason::STOPPING;
+        }
+        
+        if (drainArrivals && (!pendingArrivals.empty() || !pendingDetections.empty())) {
+            arrivalBatch.swap(pendingArrivals);
+            detectionBatch.swap(pendingDetections);
+            lock.unlock();
+            for (const auto& arrival : arrivalBatch) {
+                applyArrival(arrival.intersection, arrival.vehicle);
+            }
+            arrivalBatch.clear();
+            applyDetections(detectionBatch.data(), detectionBatch.size());
+            detectionBatch.clear();
+            lock.lock();
+            continue;
+        }
+        
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return WakeReason::DEADLINE;
+        }
+        controlWakeup.wait_until(lock, deadline);
+    }
+}
+
 void TrafficController::controllerLoop() {
-    while (running) {
+    TRAFFIC_TRACE_THREAD("controller");
+    
+    bool realTime = schedulingMode == SchedulingMode::REAL_TIME;
+    if (realTime) {
+        scheduler.setPeriod(getTickPeriod());
+        scheduler.reset(std::chrono::steady_clock::now());
+    }
+    
+    auto nextTick = std::chrono::steady_clock::now();
+    while (true) {
+        // Wait for the next tick, applying external arrivals the moment they land.
+        // Real-time mode waits for absolute release times so work time doesn't shift the period.
+        auto deadline = realTime ? scheduler.getNextRelease() : nextTick;
+        WakeReason reason = waitUntil(deadline, true);
+        if (reason == WakeReason::STOPPING) {
+            break;
+        }
+        if (reason == WakeReason::RESUMED) {
+            // Time spent paused is neither jitter nor a missed deadline
+            scheduler.rebase(std::chrono::steady_clock::now());
+            nextTick = std::chrono::steady_clock::now();
+            continue;
+        }
+        
+        TRAFFIC_TRACE_SCOPE("controllerTick");
+        
+        bool shedWork = false;
+        if (realTime) {
+            scheduler.beginTick(std::chrono::steady_clock::now());
+            shedWork = scheduler.shouldShedWork();
+        }
+        
         updateAllIntersections();
         processEmergencyQueue();
+        if (rebalanceRequested.exchange(false, std::memory_order_acq_rel)) {
+            optimizeTrafficFlow();
+            balanceIntersectionLoad();
+        }
+        
+        // Statistics and snapshot publication are the first things dropped when behind
+        if (!shedWork) {
+            // Update system efficiency
+            double efficiency = 85.0;  // Simplified efficiency calculation
+            statistics.updateSystemEfficiency(efficiency);
+            
+            publishSnapshot();
+        }
         
-        // Update system efficiency
-        double efficiency = 85.0;  // Simplified efficiency calculation
-        statistics.updateSystemEfficiency(efficiency);
+        if (checkpointRequested.load(std::memory_order_acquire)) {
+            serviceCheckpointRequest();
+        }
         
-        // Sleep based on simulation speed
-        int sleepTime = realTimeMode ? 1000 / simulationSpeed : 100;
-        std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime));
+        if (realTime) {
+            scheduler.endTick(std::chrono::steady_clock::now());
+            scheduler.setPeriod(getTickPeriod());
+        } else {
+            // Next tick a fixed interval after this one finished, based on simulation speed
+            nextTick = std::chrono::steady_clock::now() + getTickPeriod();
+        }
     }
 }
 
 void TrafficController::simulationLoop() {
-    while (running) {
-        simulateVehicleFlow();
+    TRAFFIC_TRACE_THREAD("simulation");
+    
+    auto nextStep = std::chrono::steady_clock::now();
+    while (true) {
+        WakeReason reason = waitUntil(nextStep, false);
+        if (reason == WakeReason::STOPPING) {
+            break;
+        }
+        if (reason == WakeReason::RESUMED) {
+            nextStep = std::chrono::steady_clock::now();
+            continue;
+        }
+        
+        {
+            TRAFFIC_TRACE_SCOPE("simulateVehicleFlow");
+            simulateVehicleFlow();
+        }
         
-        // Sleep for traffic generation interval
-        std::this_thread::sleep_for(std::chrono::seconds(3));
+        // Traffic generation interval
+        nextStep = std::chrono::steady_clock::now() + std::chrono::seconds(3);
     }
 }
 
@@ -368,9 +1561,8 @@ void TrafficController::processIntersection(Intersection& intersection) {
 void TrafficController::checkEmergencyConditions() {
     // Check for emergency vehicles in queues
     for (auto& intersection : intersections) {
-        for (int i = 0; i < 4; ++i) {
-            Direction dir = static_cast<Direction>(i);
-            auto& queue = intersection->getQueue(dir);
+        for (int movement = 0; movement < MOVEMENT_COUNT; ++movement) {
+            const auto& queue = intersection->getQueue(movementApproach(movement), movementTurn(movement));
             
             if (!queue.empty() && queue.front().isEmergencyVehicle()) {
                 handleEmergencyVehicle(queue.front());
@@ -380,15 +1572,13 @@ void TrafficController::checkEmergencyConditions() {
 }
 
 Direction TrafficController::getRandomDirection() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(0, 3);
-    return static_cast<Direction>(dis(gen));
+    std::uniform_int_distribution<> dis(0, 3);
+    std::lock_guard<std::mutex> lock(rngMutex);
+    return static_cast<Direction>(dis(rng));
 }
 
 VehicleType TrafficController::getRandomVehicleType() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(0, 7);
-    return static_cast<VehicleType>(dis(gen));
+    std::uniform_int_distribution<> dis(0, 7);
+    std::lock_guard<std::mutex> lock(rngMutex);
+    return static_cast<VehicleType>(dis(rng));
 }
\ No newline at end of file
@@ -2,30 +2,35 @@
 #include <iostream>
 
 TrafficLight::TrafficLight(Direction dir, TrafficState initialState)
-    : direction(dir), state(initialState), duration(30), timeLeft(30), 
+    : state(initialState), direction(dir), duration(30), timeLeft(30), 
       emergencyMode(false), lastUpdate(std::chrono::steady_clock::now()) {
 }
 
-void TrafficLight::changeState(TrafficState newState) {
-    state = newState;
-    
-    // Set default durations based on state
+TrafficLight::TrafficLight(Direction dir, TrafficState currentState, int stateDuration, int remaining, bool emergency)
+    : state(currentState), direction(dir), duration(stateDuration), timeLeft(remaining),
+      emergencyMode(emergency), lastUpdate(std::chrono::steady_clock::now()) {
+}
+
+int TrafficLight::defaultDuration(TrafficState state) {
     switch (state) {
         case TrafficState::RED:
-            duration = 30;
-            break;
+            return 30;
         case TrafficState::YELLOW:
-            duration = 5;
-            break;
+            return 5;
         case TrafficState::GREEN:
-            duration = 25;
-            break;
+            return 25;
         case TrafficState::FLASHING_RED:
         case TrafficState::FLASHING_YELLOW:
-            duration = 1;  // Flashing cycle
-            break;
+            return 1;  // Flashing cycle
     }
+    return 30;
+}
+
+void TrafficLight::changeState(TrafficState newState) {
+    state = newState;
     
+    // Set default durations based on state
+    duration = defaultDuration(state);
     timeLeft = duration;
     lastUpdate = std::chrono::steady_clock::now();
 }
@@ -42,6 +47,12 @@ void TrafficLight::update() {
     }
 }
 
+void TrafficLight::tick() {
+    if (timeLeft > 0) {
+        timeLeft--;
+    }
+}
+
 void TrafficLight::setDuration(int seconds) {
     duration = seconds;
     timeLeft = seconds;
@@ -1,11 +1,31 @@
 #include "../include/TrafficSensor.h"
 #include "../include/TrafficLight.h"
+#include "../include/Checkpoint.h"
 #include <chrono>
 #include <random>
+#include <cmath>
+#include <algorithm>
 
 TrafficSensor::TrafficSensor(Direction dir, double range)
     : direction(dir), vehicleCount(0), isActive(true), detectionRange(range),
-      lastDetection(std::chrono::steady_clock::now()) {
+      lastDetection(std::chrono::steady_clock::now()),
+      intervalLength(std::chrono::seconds(5)), smoothing(0.2) {
+    resetWindow(lastDetection);
+}
+
+void TrafficSensor::resetWindow(std::chrono::steady_clock::time_point now) {
+    intervalCounts.fill(0);
+    windowHead = 0;
+    windowCount = 0;
+    currentOccupied = 0.0;
+    currentInterval = 0;
+    windowStart = now;
+    intervalEnd = now + intervalLength;
+    
+    ewmaCount = 0.0;
+    ewmaOccupancy = 0.0;
+    ewmaHeadway = 0.0;
+    headwayValid = false;
 }
 
 bool TrafficSensor::detectVehicle() {
@@ -22,8 +42,7 @@ bool TrafficSensor::detectVehicle() {
     bool detected = dis(gen) <= 30;
     
     if (detected) {
-        vehicleCount++;
-        lastDetection = std::chrono::steady_clock::now();
+        recordDetection(std::chrono::steady_clock::now());
     }
     
     return detected;
@@ -32,6 +51,7 @@ bool TrafficSensor::detectVehicle() {
 void TrafficSensor::reset() {
     vehicleCount = 0;
     lastDetection = std::chrono::steady_clock::now();
+    resetWindow(lastDetection);
 }
 
 void TrafficSensor::activate() {
@@ -73,15 +93,8 @@ std::string TrafficSensor::getDirectionString() const {
 }
 
 double TrafficSensor::getTrafficDensity() const {
-    // Calculate vehicles per minute based on recent detections
-    auto now = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::minutes>(now - lastDetection);
-    
-    if (duration.count() == 0) {
-        return vehicleCount;  // Recent activity
-    }
-    
-    return static_cast<double>(vehicleCount) / duration.count();
+    // Vehicles per minute over the sliding window; kept for existing callers
+    return getWindowFlowRate();
 }
 
 bool TrafficSensor::hasRecentActivity(int seconds) const {
@@ -91,6 +104,162 @@ bool TrafficSensor::hasRecentActivity(int seconds) const {
 }
 
 void TrafficSensor::incrementCount() {
+    recordDetection(std::chrono::steady_clock::now());
+}
+
+void TrafficSensor::recordDetection(std::chrono::steady_clock::time_point when, double dwellSeconds) {
+    advanceWindow(when);
+    
+    intervalCounts[windowHead]++;
+    windowCount++;
+    currentOccupied += dwellSeconds;
+    
+    // Headway is only meaningful between two detections seen by this sensor
+    if (vehicleCount > 0 && when >= lastDetection) {
+        double headway = std::chrono::duration<double>(when - lastDetection).count();
+        ewmaHeadway = headwayValid ? smoothing * headway + (1.0 - smoothing) * ewmaHeadway : headway;
+        headwayValid = true;
+    }
+    
     vehicleCount++;
-    lastDetection = std::chrono::steady_clock::now();
+    if (when > lastDetection) {
+        lastDetection = when;
+    }
+}
+
+void TrafficSensor::advanceWindow(std::chrono::steady_clock::time_point now) {
+    // Called every second for every sensor, so the common case is one compare
+    if (now < intervalEnd) {
+        return;  // Still inside the current interval
+    }
+    
+    long long target = (now - windowStart) / intervalLength;
+    
+    // Fold the interval that just closed into the smoothed estimates
+    double intervalSeconds = std::chrono::duration<double>(intervalLength).count();
+    ewmaCount = smoothing * intervalCounts[windowHead] + (1.0 - smoothing) * ewmaCount;
+    double occupied = std::min(1.0, currentOccupied / intervalSeconds);
+    ewmaOccupancy = smoothing * occupied + (1.0 - smoothing) * ewmaOccupancy;
+    
+    // Any further skipped intervals were empty, so they only decay the estimates
+    long long skipped = target - currentInterval - 1;
+    if (skipped > 0) {
+        double decay = std::pow(1.0 - smoothing, static_cast<double>(skipped));
+        ewmaCount *= decay;
+        ewmaOccupancy *= decay;
+    }
+    
+    // Settle negligible estimates at zero so an idle sensor comes to rest
+    if (ewmaCount < EWMA_FLOOR) {
+        ewmaCount = 0.0;
+    }
+    if (ewmaOccupancy < EWMA_FLOOR) {
+        ewmaOccupancy = 0.0;
+    }
+    
+    // Recycle at most one full ring of slots; older ones are already gone
+    long long steps = std::min<long long>(target - currentInterval, WINDOW_SLOTS);
+    for (long long i = 0; i < steps; ++i) {
+        windowHead = (windowHead + 1) % WINDOW_SLOTS;
+        windowCount -= intervalCounts[windowHead];
+        intervalCounts[windowHead] = 0;
+    }
+    
+    currentOccupied = 0.0;
+    currentInterval = target;
+    intervalEnd = windowStart + (target + 1) * intervalLength;
+}
+
+std::chrono::steady_clock::time_point TrafficSensor::getIntervalEnd() const {
+    return intervalEnd;
+}
+
+bool TrafficSensor::isAtRest() const {
+    // Skipped rolls are caught up by the next detection, and until then every
+    // estimate reads zero whether the window rolled or not
+    return windowCount == 0 && currentOccupied == 0.0 && ewmaCount == 0.0 && ewmaOccupancy == 0.0;
+}
+
+void TrafficSensor::setIntervalLength(std::chrono::milliseconds length) {
+    if (length.count() <= 0) {
+        return;
+    }
+    intervalLength = length;
+    resetWindow(std::chrono::steady_clock::now());
+}
+
+void TrafficSensor::setSmoothing(double alpha) {
+    if (alpha > 0.0 && alpha <= 1.0) {
+        smoothing = alpha;
+    }
+}
+
+double TrafficSensor::getFlowRate() const {
+    double intervalMinutes = std::chrono::duration<double>(intervalLength).count() / 60.0;
+    return ewmaCount / intervalMinutes;
+}
+
+double TrafficSensor::getWindowFlowRate() const {
+    // Only intervals that have actually elapsed count towards the window length
+    long long filled = std::min<long long>(currentInterval + 1, WINDOW_SLOTS);
+    double windowMinutes = filled * std::chrono::duration<double>(intervalLength).count() / 60.0;
+    return windowMinutes > 0 ? windowCount / windowMinutes : 0.0;
+}
+
+double TrafficSensor::getOccupancy() const {
+    return ewmaOccupancy;
+}
+
+double TrafficSensor::getAverageHeadway() const {
+    return headwayValid ? ewmaHeadway : 0.0;
+}
+
+void TrafficSensor::writeCheckpoint(CheckpointWriter& out) const {
+    out.put(static_cast<uint8_t>(direction));
+    out.put(static_cast<int32_t>(vehicleCount));
+    out.putTime(lastDetection);
+    out.put(static_cast<uint8_t>(isActive));
+    out.put(detectionRange);
+    
+    out.put(intervalCounts);
+    out.put(static_cast<int32_t>(windowHead));
+    out.put(static_cast<int32_t>(windowCount));
+    out.put(currentOccupied);
+    out.put(static_cast<int64_t>(currentInterval));
+    out.putTime(windowStart);
+    out.put(static_cast<int64_t>(intervalLength.count()));
+    
+    out.put(smoothing);
+    out.put(ewmaCount);
+    out.put(ewmaOccupancy);
+    out.put(ewmaHeadway);
+    out.put(static_cast<uint8_t>(headwayValid));
+}
+
+void TrafficSensor::readCheckpoint(CheckpointReader& in) {
+    uint8_t directionValue = in.get<uint8_t>();
+    direction = static_cast<Direction>(directionValue & 3);
+    vehicleCount = in.get<int32_t>();
+    lastDetection = in.getTime();
+    isActive = in.get<uint8_t>() != 0;
+    detectionRange = in.get<double>();
+    
+    intervalCounts = in.get<std::array<int, WINDOW_SLOTS>>();
+    windowHead = in.get<int32_t>();
+    windowCount = in.get<int32_t>();
+    currentOccupied = in.get<double>();
+    currentInterval = in.get<int64_t>();
+    windowStart = in.getTime();
+    intervalLength = std::chrono::milliseconds(in.get<int64_t>());
+    
+    smoothing = in.get<double>();
+    ewmaCount = in.get<double>();
+    ewmaOccupancy = in.get<double>();
+    ewmaHeadway = in.get<double>();
+    headwayValid = in.get<uint8_t>() != 0;
+    intervalEnd = windowStart + (currentInterval + 1) * intervalLength;
+    
+    if (directionValue > 3 || windowHead < 0 || windowHead >= WINDOW_SLOTS || intervalLength.count() <= 0) {
+        in.fail();
+    }
 }
\ No newline at end of file
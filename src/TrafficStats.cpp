@@ -1,4 +1,5 @@
 #include "../include/TrafficStats.h"
+#include "../include/Checkpoint.h"
 #include <iostream>
 #include <fstream>
 #include <iomanip>
@@ -88,6 +89,28 @@ int TrafficStats::getEmergencyOverrides() const {
     return emergencyOverrides;
 }
 
+void TrafficStats::updateLinkTravelTimes(const std::vector<double>& seconds, const std::vector<uint32_t>& traversals) {
+    if (linkTravelSeconds.size() < seconds.size()) {
+        linkTravelSeconds.resize(seconds.size(), 0.0);
+        linkTraversals.resize(seconds.size(), 0);
+    }
+    for (size_t link = 0; link < seconds.size() && link < traversals.size(); ++link) {
+        linkTravelSeconds[link] += seconds[link];
+        linkTraversals[link] += traversals[link];
+    }
+}
+
+double TrafficStats::getLinkTravelTime(uint32_t link, double unobserved) const {
+    if (link >= linkTraversals.size() || linkTraversals[link] == 0) {
+        return unobserved;
+    }
+    return linkTravelSeconds[link] / linkTraversals[link];
+}
+
+uint32_t TrafficStats::getLinkTraversals(uint32_t link) const {
+    return link < linkTraversals.size() ? linkTraversals[link] : 0;
+}
+
 int TrafficStats::getVehiclesByDirection(const std::string& direction) const {
     auto it = vehiclesByDirection.find(direction);
     return it != vehiclesByDirection.end() ? it->second : 0;
@@ -187,6 +210,8 @@ void TrafficStats::reset() {
     vehiclesByDirection.clear();
     avgWaitByDirection.clear();
     throughputByDirection.clear();
+    linkTravelSeconds.clear();
+    linkTraversals.clear();
     
     startTime = std::chrono::steady_clock::now();
 }
@@ -207,4 +232,55 @@ void TrafficStats::displaySummary() const {
     std::cout << "Average Wait Time: " << std::setprecision(2) << getAverageWaitTime() << " seconds\n";
     std::cout << "System Throughput: " << std::setprecision(2) << getThroughput() << " vehicles/minute\n";
     std::cout << "Runtime: " << getTotalRunTime() << " seconds\n";
+}
+
+namespace {
+
+template <typename T>
+void writeDirectionMap(CheckpointWriter& out, const std::map<std::string, T>& values) {
+    out.put(static_cast<uint32_t>(values.size()));
+    for (const auto& entry : values) {
+        out.putString(entry.first);
+        out.put(entry.second);
+    }
+}
+
+template <typename T>
+void readDirectionMap(CheckpointReader& in, std::map<std::string, T>& values) {
+    values.clear();
+    uint32_t count = in.getCount(sizeof(uint32_t) + sizeof(T));
+    for (uint32_t i = 0; i < count && in.ok(); ++i) {
+        std::string key = in.getString();
+        values[key] = in.get<T>();
+    }
+}
+
+}  // namespace
+
+void TrafficStats::writeCheckpoint(CheckpointWriter& out) const {
+    out.put(static_cast<int32_t>(totalVehicles));
+    out.put(static_cast<int32_t>(emergencyVehicles));
+    out.put(totalWaitTime);
+    out.put(static_cast<int32_t>(processedVehicles));
+    out.putTime(startTime);
+    writeDirectionMap(out, vehiclesByDirection);
+    writeDirectionMap(out, avgWaitByDirection);
+    writeDirectionMap(out, throughputByDirection);
+    out.put(systemEfficiency);
+    out.put(static_cast<int32_t>(totalCycles));
+    out.put(static_cast<int32_t>(emergencyOverrides));
+}
+
+void TrafficStats::readCheckpoint(CheckpointReader& in) {
+    totalVehicles = in.get<int32_t>();
+    emergencyVehicles = in.get<int32_t>();
+    totalWaitTime = in.get<double>();
+    processedVehicles = in.get<int32_t>();
+    startTime = in.getTime();
+    readDirectionMap(in, vehiclesByDirection);
+    readDirectionMap(in, avgWaitByDirection);
+    readDirectionMap(in, throughputByDirection);
+    systemEfficiency = in.get<double>();
+    totalCycles = in.get<int32_t>();
+    emergencyOverrides = in.get<int32_t>();
 }
\ No newline at end of file
@@ -1,10 +1,18 @@
 #include "../include/Vehicle.h"
 #include "../include/TrafficLight.h"
+#include "../include/Checkpoint.h"
 #include <chrono>
+#include <atomic>
 
-Vehicle::Vehicle(const std::string& vehicleId, VehicleType vehType, Direction dir)
-    : id(vehicleId), type(vehType), direction(dir), hasPassedIntersection(false),
-      arrivalTime(std::chrono::steady_clock::now()) {
+namespace {
+
+std::atomic<uint32_t> nextVehicleSerial(1);
+
+}  // namespace
+
+Vehicle::Vehicle(const std::string& vehicleId, VehicleType vehType, Direction dir, Turn vehTurn)
+    : id(vehicleId), serial(nextVehicleSerial.fetch_add(1, std::memory_order_relaxed)), type(vehType), direction(dir), turn(vehTurn),
+      arrivalTime(std::chrono::steady_clock::now()), hasPassedIntersection(false), routeId(NO_ROUTE), routeCursor(0) {
     
     // Set priority based on vehicle type
     switch (type) {
@@ -40,10 +48,29 @@ void Vehicle::markAsPassed() {
     hasPassedIntersection = true;
 }
 
+void Vehicle::setApproach(Direction dir, Turn vehTurn) {
+    direction = dir;
+    turn = vehTurn;
+    hasPassedIntersection = false;
+}
+
+void Vehicle::setRoute(uint32_t route) {
+    routeId = route;
+    routeCursor = 0;
+}
+
+void Vehicle::advanceRoute() {
+    routeCursor++;
+}
+
 std::string Vehicle::getId() const {
     return id;
 }
 
+uint32_t Vehicle::getSerial() const {
+    return serial;
+}
+
 VehicleType Vehicle::getType() const {
     return type;
 }
@@ -52,10 +79,22 @@ Direction Vehicle::getDirection() const {
     return direction;
 }
 
+Turn Vehicle::getTurn() const {
+    return turn;
+}
+
+int Vehicle::getMovement() const {
+    return movementIndex(direction, turn);
+}
+
 int Vehicle::getPriority() const {
     return priority;
 }
 
+void Vehicle::setArrivalTime(std::chrono::steady_clock::time_point when) {
+    arrivalTime = when;
+}
+
 std::chrono::steady_clock::time_point Vehicle::getArrivalTime() const {
     return arrivalTime;
 }
@@ -64,6 +103,14 @@ bool Vehicle::hasPassed() const {
     return hasPassedIntersection;
 }
 
+uint32_t Vehicle::getRouteId() const {
+    return routeId;
+}
+
+uint32_t Vehicle::getRouteCursor() const {
+    return routeCursor;
+}
+
 bool Vehicle::isEmergencyVehicle() const {
     return type == VehicleType::AMBULANCE || 
            type == VehicleType::FIRE_TRUCK || 
@@ -113,4 +160,39 @@ bool Vehicle::operator<(const Vehicle& other) const {
 bool Vehicle::operator>(const Vehicle& other) const {
     // For std::priority_queue with std::greater
     return priority > other.priority;
+}
+
+void Vehicle::writeCheckpoint(CheckpointWriter& out) const {
+    out.putString(id);
+    out.put(serial);
+    out.put(static_cast<uint8_t>(type));
+    out.put(static_cast<uint8_t>(direction));
+    out.put(static_cast<uint8_t>(turn));
+    out.put(static_cast<int32_t>(priority));
+    out.putTime(arrivalTime);
+    out.put(static_cast<uint8_t>(hasPassedIntersection));
+    out.put(routeId);
+    out.put(routeCursor);
+}
+
+void Vehicle::readCheckpoint(CheckpointReader& in) {
+    id = in.getString();
+    serial = in.get<uint32_t>();
+    uint8_t typeValue = in.get<uint8_t>();
+    uint8_t directionValue = in.get<uint8_t>();
+    uint8_t turnValue = in.get<uint8_t>();
+    if (typeValue > static_cast<uint8_t>(VehicleType::EMERGENCY) || directionValue > 3 ||
+        turnValue > static_cast<uint8_t>(Turn::RIGHT)) {
+        in.fail();
+        return;
+    }
+    
+    type = static_cast<VehicleType>(typeValue);
+    direction = static_cast<Direction>(directionValue);
+    turn = static_cast<Turn>(turnValue);
+    priority = in.get<int32_t>();
+    arrivalTime = in.getTime();
+    hasPassedIntersection = in.get<uint8_t>() != 0;
+    routeId = in.get<uint32_t>();
+    routeCursor = in.get<uint32_t>();
 }
\ No newline at end of file